@@ -21,6 +21,7 @@
 #include "render.h"
 #include "color.h"
 #include "instance.h"
+#include "cpu.h"
 
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
@@ -122,88 +123,562 @@ void RrColorFree(RrColor *c)
     }
 }
 
-void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im)
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define HOST_BYTE_ORDER LSBFirst
+#else
+#define HOST_BYTE_ORDER MSBFirst
+#endif
+
+/*! How to turn RrPixel32s into pixels for an XImage */
+typedef struct {
+    gint ro, go, bo; /* where each channel goes in the image's pixels */
+    gint rs, gs, bs; /* how many bits to drop from each channel */
+    gboolean swap;   /* the image's byte order is not ours */
+    gboolean dither; /* hide the dropped bits with an ordered dither */
+} ReduceFormat;
+
+typedef void (*ReduceFunc)(const ReduceFormat *f, const RrPixel32 *data,
+                           XImage *im);
+
+/* a 4x4 Bayer matrix, for ordered dithering */
+static const guchar dither_matrix[4][4] = {
+    {  0,  8,  2, 10 },
+    { 12,  4, 14,  6 },
+    {  3, 11,  1,  9 },
+    { 15,  7, 13,  5 }
+};
+
+/*! Makes the dither thresholds for 4 pixels in row @y of the image, as
+  RrPixel32s to be added to the pixels with saturation */
+static void dither_row(const ReduceFormat *f, gint y, RrPixel32 *t)
 {
-    gint r, g, b;
-    gint x,y;
-    gint ro = RrRedOffset(inst);
-    gint bo = RrBlueOffset(inst);
-    gint go = RrGreenOffset(inst);
-    gint rs = RrRedShift(inst);
-    gint bs = RrBlueShift(inst);
-    gint gs = RrGreenShift(inst);
+    gint x;
+
+    for (x = 0; x < 4; ++x) {
+        if (!f->dither)
+            t[x] = 0;
+        else {
+            const guint d = dither_matrix[y & 3][x];
+            t[x] = (((d << f->rs) >> 4) << RrDefaultRedOffset) +
+                (((d << f->gs) >> 4) << RrDefaultGreenOffset) +
+                (((d << f->bs) >> 4) << RrDefaultBlueOffset);
+        }
+    }
+}
+
+static inline guint reduce_pixel(const ReduceFormat *f, RrPixel32 p,
+                                 RrPixel32 dither)
+{
+    guint r, g, b;
+
+    r = ((p >> RrDefaultRedOffset) & 0xFF) +
+        ((dither >> RrDefaultRedOffset) & 0xFF);
+    g = ((p >> RrDefaultGreenOffset) & 0xFF) +
+        ((dither >> RrDefaultGreenOffset) & 0xFF);
+    b = ((p >> RrDefaultBlueOffset) & 0xFF) +
+        ((dither >> RrDefaultBlueOffset) & 0xFF);
+    r = MIN(r, 0xFF);
+    g = MIN(g, 0xFF);
+    b = MIN(b, 0xFF);
+    return ((r >> f->rs) << f->ro) + ((g >> f->gs) << f->go) +
+        ((b >> f->bs) << f->bo);
+}
+
+static void reduce_copy(const ReduceFormat *f, const RrPixel32 *data,
+                        XImage *im)
+{
+    gint y;
+    gchar *p = im->data;
+
+    if (im->bytes_per_line == im->width * (gint)sizeof(RrPixel32))
+        memcpy(p, data, im->height * im->width * sizeof(RrPixel32));
+    else
+        for (y = 0; y < im->height; y++) {
+            memcpy(p, data, im->width * sizeof(RrPixel32));
+            data += im->width;
+            p += im->bytes_per_line;
+        }
+}
+
+static void reduce32(const ReduceFormat *format, const RrPixel32 *data,
+                     XImage *im)
+{
+    /* a copy, so the compiler knows that writing the image won't change it */
+    const ReduceFormat fc = *format, *f = &fc;
+    gint x, y;
     RrPixel32 *p32 = (RrPixel32 *) im->data;
+    const gboolean copy = f->ro == RrDefaultRedOffset &&
+        f->go == RrDefaultGreenOffset && f->bo == RrDefaultBlueOffset;
+
+    for (y = 0; y < im->height; y++) {
+        if (copy)
+            for (x = 0; x < im->width; x++)
+                p32[x] = GUINT32_SWAP_LE_BE(data[x]);
+        else if (f->swap)
+            for (x = 0; x < im->width; x++)
+                p32[x] = GUINT32_SWAP_LE_BE(reduce_pixel(f, data[x], 0));
+        else
+            for (x = 0; x < im->width; x++)
+                p32[x] = reduce_pixel(f, data[x], 0);
+        data += im->width;
+        p32 += im->bytes_per_line/4;
+    }
+}
+
+static void reduce24(const ReduceFormat *f, const RrPixel32 *data,
+                     XImage *im)
+{
+    gint x, y, outx;
+    RrPixel8 *p8 = (RrPixel8 *) im->data;
+    /* the byte in each pixel for each channel, with the first byte holding
+       the lowest bits for LSBFirst, and the highest for MSBFirst */
+    const gboolean msb = im->byte_order == MSBFirst;
+    const guint roff = msb ? (16 - f->ro) / 8 : f->ro / 8;
+    const guint goff = msb ? (16 - f->go) / 8 : f->go / 8;
+    const guint boff = msb ? (16 - f->bo) / 8 : f->bo / 8;
+
+    for (y = 0; y < im->height; y++) {
+        for (x = 0, outx = 0; x < im->width; x++, outx += 3) {
+            p8[outx+roff] = (data[x] >> RrDefaultRedOffset) & 0xFF;
+            p8[outx+goff] = (data[x] >> RrDefaultGreenOffset) & 0xFF;
+            p8[outx+boff] = (data[x] >> RrDefaultBlueOffset) & 0xFF;
+        }
+        data += im->width;
+        p8 += im->bytes_per_line;
+    }
+}
+
+static void reduce16(const ReduceFormat *format, const RrPixel32 *data,
+                     XImage *im)
+{
+    /* a copy, so the compiler knows that writing the image won't change it */
+    const ReduceFormat fc = *format, *f = &fc;
+    gint x, y;
     RrPixel16 *p16 = (RrPixel16 *) im->data;
-    RrPixel8  *p8  = (RrPixel8 *)  im->data;
+    RrPixel32 dither[4];
+
+    for (y = 0; y < im->height; y++) {
+        dither_row(f, y, dither);
+        if (f->dither)
+            for (x = 0; x < im->width; x++) {
+                const RrPixel16 p = reduce_pixel(f, data[x], dither[x & 3]);
+                p16[x] = f->swap ? GUINT16_SWAP_LE_BE(p) : p;
+            }
+        else if (f->swap)
+            for (x = 0; x < im->width; x++)
+                p16[x] = GUINT16_SWAP_LE_BE(reduce_pixel(f, data[x], 0));
+        else
+            for (x = 0; x < im->width; x++)
+                p16[x] = reduce_pixel(f, data[x], 0);
+        data += im->width;
+        p16 += im->bytes_per_line/2;
+    }
+}
+
+static void reduce8(const ReduceFormat *format, const RrPixel32 *data,
+                    XImage *im)
+{
+    /* a copy, so the compiler knows that writing the image won't change it */
+    const ReduceFormat fc = *format, *f = &fc;
+    gint x, y;
+    RrPixel8 *p8 = (RrPixel8 *) im->data;
+    RrPixel32 dither[4];
+
+    for (y = 0; y < im->height; y++) {
+        dither_row(f, y, dither);
+        if (f->dither)
+            for (x = 0; x < im->width; x++)
+                p8[x] = reduce_pixel(f, data[x], dither[x & 3]);
+        else
+            for (x = 0; x < im->width; x++)
+                p8[x] = reduce_pixel(f, data[x], 0);
+        data += im->width;
+        p8 += im->bytes_per_line;
+    }
+}
+
+#ifdef USE_SIMD
+
+#include <immintrin.h>
+
+/* The vector versions work on whole vectors of pixels in each row, and
+   leave the rest of the row to reduce_pixel.  They all start each row at a
+   multiple of 4 pixels, so the dither thresholds line up with the lanes. */
+
+__attribute__((target("sse2")))
+static inline __m128i reduce_lanes_sse2(__m128i p, __m128i dither,
+                                        const __m128i *shift,
+                                        const __m128i *mask)
+{
+    __m128i r, g, b;
+
+    p = _mm_adds_epu8(p, dither);
+    r = _mm_and_si128(_mm_srl_epi32(p, shift[0]), mask[0]);
+    g = _mm_and_si128(_mm_srl_epi32(p, shift[1]), mask[1]);
+    b = _mm_and_si128(_mm_srl_epi32(p, shift[2]), mask[2]);
+    return _mm_add_epi32(_mm_add_epi32(_mm_sll_epi32(r, shift[3]),
+                                       _mm_sll_epi32(g, shift[4])),
+                         _mm_sll_epi32(b, shift[5]));
+}
+
+/*! Sets up the shift counts and masks for reduce_lanes_sse2 and
+  reduce_lanes_avx2 */
+__attribute__((target("sse2")))
+static void reduce_lanes_setup(const ReduceFormat *f, __m128i *shift,
+                               __m128i *mask)
+{
+    shift[0] = _mm_cvtsi32_si128(RrDefaultRedOffset + f->rs);
+    shift[1] = _mm_cvtsi32_si128(RrDefaultGreenOffset + f->gs);
+    shift[2] = _mm_cvtsi32_si128(RrDefaultBlueOffset + f->bs);
+    shift[3] = _mm_cvtsi32_si128(f->ro);
+    shift[4] = _mm_cvtsi32_si128(f->go);
+    shift[5] = _mm_cvtsi32_si128(f->bo);
+    mask[0] = _mm_set1_epi32(0xFF >> f->rs);
+    mask[1] = _mm_set1_epi32(0xFF >> f->gs);
+    mask[2] = _mm_set1_epi32(0xFF >> f->bs);
+}
+
+__attribute__((target("sse2")))
+static inline __m128i swap32_sse2(__m128i p)
+{
+    p = _mm_or_si128(_mm_slli_epi16(p, 8), _mm_srli_epi16(p, 8));
+    p = _mm_shufflelo_epi16(p, _MM_SHUFFLE(2, 3, 0, 1));
+    return _mm_shufflehi_epi16(p, _MM_SHUFFLE(2, 3, 0, 1));
+}
+
+/* packs the low 16 bits of each 32 bit lane, the sign extension keeps
+   _mm_packs_epi32 from saturating them */
+#define PACK16_SSE2(a, b)                                          \
+    _mm_packs_epi32(_mm_srai_epi32(_mm_slli_epi32((a), 16), 16),   \
+                    _mm_srai_epi32(_mm_slli_epi32((b), 16), 16))
+
+__attribute__((target("sse2")))
+static void reduce32_sse2(const ReduceFormat *f, const RrPixel32 *data,
+                          XImage *im)
+{
+    gint x, y;
+    RrPixel32 *p32 = (RrPixel32 *) im->data;
+    const gboolean copy = f->ro == RrDefaultRedOffset &&
+        f->go == RrDefaultGreenOffset && f->bo == RrDefaultBlueOffset;
+    __m128i shift[6], mask[3], zero, p;
+
+    reduce_lanes_setup(f, shift, mask);
+    zero = _mm_setzero_si128();
+
+    for (y = 0; y < im->height; y++) {
+        for (x = 0; x + 4 <= im->width; x += 4) {
+            p = _mm_loadu_si128((const __m128i*)(data + x));
+            if (!copy)
+                p = reduce_lanes_sse2(p, zero, shift, mask);
+            if (f->swap)
+                p = swap32_sse2(p);
+            _mm_storeu_si128((__m128i*)(p32 + x), p);
+        }
+        for (; x < im->width; x++) {
+            const RrPixel32 q = copy ? data[x] : reduce_pixel(f, data[x], 0);
+            p32[x] = f->swap ? GUINT32_SWAP_LE_BE(q) : q;
+        }
+        data += im->width;
+        p32 += im->bytes_per_line/4;
+    }
+}
+
+__attribute__((target("sse2")))
+static void reduce16_sse2(const ReduceFormat *f, const RrPixel32 *data,
+                          XImage *im)
+{
+    gint x, y;
+    RrPixel16 *p16 = (RrPixel16 *) im->data;
+    RrPixel32 dither[4];
+    __m128i shift[6], mask[3], d, a, b, p;
+
+    reduce_lanes_setup(f, shift, mask);
+
+    for (y = 0; y < im->height; y++) {
+        dither_row(f, y, dither);
+        d = _mm_loadu_si128((const __m128i*)dither);
+        for (x = 0; x + 8 <= im->width; x += 8) {
+            a = _mm_loadu_si128((const __m128i*)(data + x));
+            b = _mm_loadu_si128((const __m128i*)(data + x + 4));
+            a = reduce_lanes_sse2(a, d, shift, mask);
+            b = reduce_lanes_sse2(b, d, shift, mask);
+            p = PACK16_SSE2(a, b);
+            if (f->swap)
+                p = _mm_or_si128(_mm_slli_epi16(p, 8), _mm_srli_epi16(p, 8));
+            _mm_storeu_si128((__m128i*)(p16 + x), p);
+        }
+        for (; x < im->width; x++) {
+            const RrPixel16 q = reduce_pixel(f, data[x], dither[x & 3]);
+            p16[x] = f->swap ? GUINT16_SWAP_LE_BE(q) : q;
+        }
+        data += im->width;
+        p16 += im->bytes_per_line/2;
+    }
+}
+
+__attribute__((target("sse2")))
+static void reduce8_sse2(const ReduceFormat *f, const RrPixel32 *data,
+                         XImage *im)
+{
+    gint x, y, i;
+    RrPixel8 *p8 = (RrPixel8 *) im->data;
+    RrPixel32 dither[4];
+    __m128i shift[6], mask[3], d, v[4];
+
+    reduce_lanes_setup(f, shift, mask);
+
+    for (y = 0; y < im->height; y++) {
+        dither_row(f, y, dither);
+        d = _mm_loadu_si128((const __m128i*)dither);
+        for (x = 0; x + 16 <= im->width; x += 16) {
+            for (i = 0; i < 4; ++i) {
+                v[i] = _mm_loadu_si128((const __m128i*)(data + x + i*4));
+                v[i] = reduce_lanes_sse2(v[i], d, shift, mask);
+            }
+            v[0] = PACK16_SSE2(v[0], v[1]);
+            v[2] = PACK16_SSE2(v[2], v[3]);
+            /* only the low 8 bits are set in each lane */
+            _mm_storeu_si128((__m128i*)(p8 + x),
+                             _mm_packus_epi16(
+                                 _mm_and_si128(v[0], _mm_set1_epi16(0xFF)),
+                                 _mm_and_si128(v[2], _mm_set1_epi16(0xFF))));
+        }
+        for (; x < im->width; x++)
+            p8[x] = reduce_pixel(f, data[x], dither[x & 3]);
+        data += im->width;
+        p8 += im->bytes_per_line;
+    }
+}
+
+__attribute__((target("avx2")))
+static inline __m256i reduce_lanes_avx2(__m256i p, __m256i dither,
+                                        const __m128i *shift,
+                                        const __m256i *mask)
+{
+    __m256i r, g, b;
+
+    p = _mm256_adds_epu8(p, dither);
+    r = _mm256_and_si256(_mm256_srl_epi32(p, shift[0]), mask[0]);
+    g = _mm256_and_si256(_mm256_srl_epi32(p, shift[1]), mask[1]);
+    b = _mm256_and_si256(_mm256_srl_epi32(p, shift[2]), mask[2]);
+    return _mm256_add_epi32(_mm256_add_epi32(_mm256_sll_epi32(r, shift[3]),
+                                             _mm256_sll_epi32(g, shift[4])),
+                            _mm256_sll_epi32(b, shift[5]));
+}
+
+/*! Makes a byte shuffle that puts each channel where it goes in a 32 bit
+  pixel, or returns FALSE if the channels don't all start on a byte */
+static gboolean reduce_shuffle(const ReduceFormat *f, gchar *shuf)
+{
+    gint i, j;
+    const gint offs[3] = { f->ro, f->go, f->bo };
+    const gint from[3] = { RrDefaultRedOffset / 8, RrDefaultGreenOffset / 8,
+                           RrDefaultBlueOffset / 8 };
+
+    for (i = 0; i < 3; ++i)
+        if (offs[i] % 8 || offs[i] > 24)
+            return FALSE;
+
+    for (i = 0; i < 32; i += 4) {
+        for (j = 0; j < 4; ++j)
+            shuf[i+j] = (gchar)0x80; /* zero */
+        for (j = 0; j < 3; ++j) {
+            /* the image's pixels are little endian unless swapped */
+            const gint to = f->swap ? 3 - offs[j] / 8 : offs[j] / 8;
+            shuf[i+to] = (i & 15) + from[j];
+        }
+    }
+    return TRUE;
+}
+
+__attribute__((target("avx2")))
+static void reduce32_avx2(const ReduceFormat *f, const RrPixel32 *data,
+                          XImage *im)
+{
+    gint x, y;
+    RrPixel32 *p32 = (RrPixel32 *) im->data;
+    const gboolean copy = f->ro == RrDefaultRedOffset &&
+        f->go == RrDefaultGreenOffset && f->bo == RrDefaultBlueOffset;
+    gchar shuf[32];
+    __m256i s, p;
+
+    /* when the pixels are only being swapped, keep all 4 bytes of them */
+    if (copy) {
+        gint i;
+        for (i = 0; i < 32; ++i)
+            shuf[i] = (i & ~3) + 3 - (i & 3);
+    } else if (!reduce_shuffle(f, shuf)) {
+        reduce32_sse2(f, data, im);
+        return;
+    }
+    s = _mm256_loadu_si256((const __m256i*)shuf);
+
+    for (y = 0; y < im->height; y++) {
+        for (x = 0; x + 8 <= im->width; x += 8) {
+            p = _mm256_loadu_si256((const __m256i*)(data + x));
+            _mm256_storeu_si256((__m256i*)(p32 + x),
+                                _mm256_shuffle_epi8(p, s));
+        }
+        for (; x < im->width; x++) {
+            const RrPixel32 q = copy ? data[x] : reduce_pixel(f, data[x], 0);
+            p32[x] = f->swap ? GUINT32_SWAP_LE_BE(q) : q;
+        }
+        data += im->width;
+        p32 += im->bytes_per_line/4;
+    }
+}
+
+__attribute__((target("avx2")))
+static void reduce24_avx2(const ReduceFormat *f, const RrPixel32 *data,
+                          XImage *im)
+{
+    gint x, y, i, outx;
+    RrPixel8 *p8 = (RrPixel8 *) im->data;
+    const gboolean msb = im->byte_order == MSBFirst;
+    const guint roff = msb ? (16 - f->ro) / 8 : f->ro / 8;
+    const guint goff = msb ? (16 - f->go) / 8 : f->go / 8;
+    const guint boff = msb ? (16 - f->bo) / 8 : f->bo / 8;
+    gchar shuf[32];
+    __m256i s, p;
+
+    /* pack 4 pixels into the first 12 bytes of each 16 byte lane */
+    for (i = 0; i < 32; ++i)
+        shuf[i] = (gchar)0x80;
+    for (i = 0; i < 4; ++i) {
+        shuf[i*3+roff] = shuf[16+i*3+roff] = i*4 + RrDefaultRedOffset/8;
+        shuf[i*3+goff] = shuf[16+i*3+goff] = i*4 + RrDefaultGreenOffset/8;
+        shuf[i*3+boff] = shuf[16+i*3+boff] = i*4 + RrDefaultBlueOffset/8;
+    }
+    s = _mm256_loadu_si256((const __m256i*)shuf);
+
+    for (y = 0; y < im->height; y++) {
+        /* each 16 byte store writes 4 bytes past the pixels, which the next
+           store fills in, so stop while there is room for that */
+        for (x = 0, outx = 0; x + 10 <= im->width; x += 8, outx += 24) {
+            p = _mm256_loadu_si256((const __m256i*)(data + x));
+            p = _mm256_shuffle_epi8(p, s);
+            _mm_storeu_si128((__m128i*)(p8 + outx),
+                             _mm256_castsi256_si128(p));
+            _mm_storeu_si128((__m128i*)(p8 + outx + 12),
+                             _mm256_extracti128_si256(p, 1));
+        }
+        for (; x < im->width; x++, outx += 3) {
+            p8[outx+roff] = (data[x] >> RrDefaultRedOffset) & 0xFF;
+            p8[outx+goff] = (data[x] >> RrDefaultGreenOffset) & 0xFF;
+            p8[outx+boff] = (data[x] >> RrDefaultBlueOffset) & 0xFF;
+        }
+        data += im->width;
+        p8 += im->bytes_per_line;
+    }
+}
+
+__attribute__((target("avx2")))
+static void reduce16_avx2(const ReduceFormat *f, const RrPixel32 *data,
+                          XImage *im)
+{
+    gint x, y;
+    RrPixel16 *p16 = (RrPixel16 *) im->data;
+    RrPixel32 dither[4];
+    __m128i shift[6], m[3];
+    __m256i mask[3], d, a, b, p;
+
+    reduce_lanes_setup(f, shift, m);
+    mask[0] = _mm256_broadcastsi128_si256(m[0]);
+    mask[1] = _mm256_broadcastsi128_si256(m[1]);
+    mask[2] = _mm256_broadcastsi128_si256(m[2]);
+
+    for (y = 0; y < im->height; y++) {
+        dither_row(f, y, dither);
+        d = _mm256_broadcastsi128_si256(
+            _mm_loadu_si128((const __m128i*)dither));
+        for (x = 0; x + 16 <= im->width; x += 16) {
+            a = _mm256_loadu_si256((const __m256i*)(data + x));
+            b = _mm256_loadu_si256((const __m256i*)(data + x + 8));
+            a = reduce_lanes_avx2(a, d, shift, mask);
+            b = reduce_lanes_avx2(b, d, shift, mask);
+            /* sign extend so the pack doesn't saturate, and then put the
+               64 bit pieces back in order, since it packs within each 128
+               bit lane */
+            p = _mm256_packs_epi32(
+                _mm256_srai_epi32(_mm256_slli_epi32(a, 16), 16),
+                _mm256_srai_epi32(_mm256_slli_epi32(b, 16), 16));
+            p = _mm256_permute4x64_epi64(p, _MM_SHUFFLE(3, 1, 2, 0));
+            if (f->swap)
+                p = _mm256_or_si256(_mm256_slli_epi16(p, 8),
+                                    _mm256_srli_epi16(p, 8));
+            _mm256_storeu_si256((__m256i*)(p16 + x), p);
+        }
+        for (; x < im->width; x++) {
+            const RrPixel16 q = reduce_pixel(f, data[x], dither[x & 3]);
+            p16[x] = f->swap ? GUINT16_SWAP_LE_BE(q) : q;
+        }
+        data += im->width;
+        p16 += im->bytes_per_line/2;
+    }
+}
+
+#endif
+
+void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im)
+{
+    ReduceFormat f;
+    ReduceFunc reduce = NULL;
+#ifdef USE_SIMD
+    RrCpuFeatures cpu = RrCpuGetFeatures();
+#endif
+    gint x, y;
+    RrPixel8 *p8 = (RrPixel8 *) im->data;
+
+    f.ro = RrRedOffset(inst);
+    f.go = RrGreenOffset(inst);
+    f.bo = RrBlueOffset(inst);
+    f.rs = RrRedShift(inst);
+    f.gs = RrGreenShift(inst);
+    f.bs = RrBlueShift(inst);
+    f.swap = im->byte_order != HOST_BYTE_ORDER;
+    f.dither = RrDither(inst);
+
     switch (im->bits_per_pixel) {
     case 32:
-        if ((ro != RrDefaultRedOffset) ||
-            (bo != RrDefaultBlueOffset) ||
-            (go != RrDefaultGreenOffset)) {
-            for (y = 0; y < im->height; y++) {
-                for (x = 0; x < im->width; x++) {
-                    r = (data[x] >> RrDefaultRedOffset) & 0xFF;
-                    g = (data[x] >> RrDefaultGreenOffset) & 0xFF;
-                    b = (data[x] >> RrDefaultBlueOffset) & 0xFF;
-                    p32[x] = (r << ro) + (g << go) + (b << bo);
-                }
-                data += im->width;
-                p32 += im->width;
-            }
-        } else im->data = (gchar*) data;
+        /* the channels are 8 bits or wider, and are not scaled up */
+        f.rs = f.gs = f.bs = 0;
+        if (RrReduceDepthCopies(inst, im))
+            reduce = reduce_copy;
+#ifdef USE_SIMD
+        else if (cpu & RR_CPU_AVX2)
+            reduce = reduce32_avx2;
+        else if (cpu & RR_CPU_SSE2)
+            reduce = reduce32_sse2;
+#endif
+        else
+            reduce = reduce32;
         break;
     case 24:
-    {
-        /* reverse the ordering, shifting left 16bit should be the first byte
-           out of three, etc */
-        const guint roff = (16 - ro) / 8;
-        const guint goff = (16 - go) / 8;
-        const guint boff = (16 - bo) / 8;
-        gint outx;
-        for (y = 0; y < im->height; y++) {
-            for (x = 0, outx = 0; x < im->width; x++, outx += 3) {
-                r = (data[x] >> RrDefaultRedOffset) & 0xFF;
-                g = (data[x] >> RrDefaultGreenOffset) & 0xFF;
-                b = (data[x] >> RrDefaultBlueOffset) & 0xFF;
-                p8[outx+roff] = r;
-                p8[outx+goff] = g;
-                p8[outx+boff] = b;
-            }
-            data += im->width;
-            p8 += im->bytes_per_line;
-        }
+#ifdef USE_SIMD
+        if (cpu & RR_CPU_AVX2)
+            reduce = reduce24_avx2;
+        else
+#endif
+            reduce = reduce24;
         break;
-    }
     case 16:
-        for (y = 0; y < im->height; y++) {
-            for (x = 0; x < im->width; x++) {
-                r = (data[x] >> RrDefaultRedOffset) & 0xFF;
-                r = r >> rs;
-                g = (data[x] >> RrDefaultGreenOffset) & 0xFF;
-                g = g >> gs;
-                b = (data[x] >> RrDefaultBlueOffset) & 0xFF;
-                b = b >> bs;
-                p16[x] = (r << ro) + (g << go) + (b << bo);
-            }
-            data += im->width;
-            p16 += im->bytes_per_line/2;
-        }
+#ifdef USE_SIMD
+        if (cpu & RR_CPU_AVX2)
+            reduce = reduce16_avx2;
+        else if (cpu & RR_CPU_SSE2)
+            reduce = reduce16_sse2;
+        else
+#endif
+            reduce = reduce16;
         break;
     case 8:
         if (RrVisual(inst)->class == TrueColor) {
-            for (y = 0; y < im->height; y++) {
-                for (x = 0; x < im->width; x++) {
-                    r = (data[x] >> RrDefaultRedOffset) & 0xFF;
-                    r = r >> rs;
-                    g = (data[x] >> RrDefaultGreenOffset) & 0xFF;
-                    g = g >> gs;
-                    b = (data[x] >> RrDefaultBlueOffset) & 0xFF;
-                    b = b >> bs;
-                    p8[x] = (r << ro) + (g << go) + (b << bo);
-                }
-                data += im->width;
-                p8 += im->bytes_per_line;
-            }
+#ifdef USE_SIMD
+            if (cpu & RR_CPU_SSE2)
+                reduce = reduce8_sse2;
+            else
+#endif
+                reduce = reduce8;
         } else {
             for (y = 0; y < im->height; y++) {
                 for (x = 0; x < im->width; x++) {
@@ -221,6 +696,18 @@ void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im)
         g_error("This image bit depth (%i) is currently unhandled", im->bits_per_pixel);
 
     }
+
+    if (reduce)
+        reduce(&f, data, im);
+}
+
+gboolean RrReduceDepthCopies(const RrInstance *inst, const XImage *im)
+{
+    return im->bits_per_pixel == 32 &&
+        im->byte_order == HOST_BYTE_ORDER &&
+        RrRedOffset(inst) == RrDefaultRedOffset &&
+        RrGreenOffset(inst) == RrDefaultGreenOffset &&
+        RrBlueOffset(inst) == RrDefaultBlueOffset;
 }
 
 XColor *RrPickColor(const RrInstance *inst, gint r, gint g, gint b)
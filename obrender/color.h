@@ -45,7 +45,11 @@ struct _RrColor {
 
 void RrColorAllocateGC(RrColor *in);
 XColor *RrPickColor(const RrInstance *inst, gint r, gint g, gint b);
+/*! Converts the pixel data into the image's format, and byte order */
 void RrReduceDepth(const RrInstance *inst, RrPixel32 *data, XImage *im);
+/*! Returns TRUE if the image's format is the same as RrPixel32's, so
+  RrReduceDepth() would only copy the pixel data into it */
+gboolean RrReduceDepthCopies(const RrInstance *inst, const XImage *im);
 void RrIncreaseDepth(const RrInstance *inst, RrPixel32 *data, XImage *im);
 
 #endif /* __color_h */
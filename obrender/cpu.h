@@ -0,0 +1,36 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   cpu.h for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __render_cpu_h
+#define __render_cpu_h
+
+#include <glib.h>
+
+typedef enum {
+    RR_CPU_SSE2 = 1 << 0,
+    RR_CPU_AVX2 = 1 << 1
+} RrCpuFeatures;
+
+/*! Returns the vector instruction sets which the processor supports, and
+  which the library was built with code for */
+RrCpuFeatures RrCpuGetFeatures(void);
+/*! Keeps the library from using any instruction sets other than the ones
+  given, so that the code for them can be compared */
+void RrCpuLimitFeatures(RrCpuFeatures allowed);
+
+#endif
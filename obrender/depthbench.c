@@ -0,0 +1,163 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   depthbench.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Measures how fast RrReduceDepth() converts pixel data for each kind of
+   screen it handles, with each set of vector instructions that the
+   processor has, and checks that they all give the same pixels as the plain
+   C code.  The screens are made up, so this doesn't need an X server. */
+
+#include "render.h"
+#include "instance.h"
+#include "color.h"
+#include "cpu.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+
+static const struct {
+    const gchar *name;
+    gint bpp;
+    gint ro, go, bo;
+    gint rs, gs, bs;
+    gboolean swap;
+    gboolean dither;
+} formats[] = {
+    { "32bpp xRGB",             32, 16,  8,  0, 0, 0, 0, FALSE, FALSE },
+    { "32bpp xRGB swapped",     32, 16,  8,  0, 0, 0, 0, TRUE,  FALSE },
+    { "32bpp xBGR",             32,  0,  8, 16, 0, 0, 0, FALSE, FALSE },
+    { "32bpp xBGR swapped",     32,  0,  8, 16, 0, 0, 0, TRUE,  FALSE },
+    { "24bpp RGB",              24, 16,  8,  0, 0, 0, 0, FALSE, FALSE },
+    { "16bpp RGB565",           16, 11,  5,  0, 3, 2, 3, FALSE, FALSE },
+    { "16bpp RGB565 swapped",   16, 11,  5,  0, 3, 2, 3, TRUE,  FALSE },
+    { "16bpp RGB565 dithered",  16, 11,  5,  0, 3, 2, 3, FALSE, TRUE  },
+    { "16bpp RGB555",           16, 10,  5,  0, 3, 3, 3, FALSE, FALSE },
+    { "8bpp RGB332",             8,  5,  2,  0, 5, 5, 6, FALSE, FALSE }
+};
+
+static const struct {
+    const gchar *name;
+    RrCpuFeatures features;
+} kernels[] = {
+    { "c", 0 },
+    { "sse2", RR_CPU_SSE2 },
+    { "avx2", RR_CPU_SSE2 | RR_CPU_AVX2 }
+};
+
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+#define HOST_BYTE_ORDER LSBFirst
+#define SWAPPED_BYTE_ORDER MSBFirst
+#else
+#define HOST_BYTE_ORDER MSBFirst
+#define SWAPPED_BYTE_ORDER LSBFirst
+#endif
+
+#define N_FORMATS (sizeof(formats) / sizeof(formats[0]))
+#define N_KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+gint main(gint argc, gchar **argv)
+{
+    RrInstance inst;
+    Visual visual;
+    XImage im;
+    RrPixel32 *data;
+    gchar *expect;
+    RrCpuFeatures have;
+    GTimer *timer;
+    guint f, k;
+    gint i, n, w, h, size;
+    gboolean ok = TRUE;
+
+    n = argc > 1 ? atoi(argv[1]) : 100;
+    /* a full width surface on a 4K monitor */
+    w = 3840;
+    h = 64;
+
+    data = g_new(RrPixel32, w * h);
+    for (i = 0; i < w * h; ++i)
+        data[i] = g_random_int();
+
+    memset(&visual, 0, sizeof(visual));
+    visual.class = TrueColor;
+
+    have = RrCpuGetFeatures();
+    timer = g_timer_new();
+
+    printf("%dx%d\n", w, h);
+    for (f = 0; f < N_FORMATS; ++f) {
+        memset(&inst, 0, sizeof(inst));
+        inst.visual = &visual;
+        inst.red_offset = formats[f].ro;
+        inst.green_offset = formats[f].go;
+        inst.blue_offset = formats[f].bo;
+        inst.red_shift = formats[f].rs;
+        inst.green_shift = formats[f].gs;
+        inst.blue_shift = formats[f].bs;
+        inst.dither = formats[f].dither;
+
+        memset(&im, 0, sizeof(im));
+        im.width = w;
+        im.height = h;
+        im.format = ZPixmap;
+        im.bitmap_unit = 32;
+        im.bitmap_pad = 32;
+        im.bits_per_pixel = formats[f].bpp;
+        im.depth = MIN(formats[f].bpp, 24);
+        im.bytes_per_line = (w * formats[f].bpp + 31) / 32 * 4;
+        im.byte_order = formats[f].swap ? SWAPPED_BYTE_ORDER : HOST_BYTE_ORDER;
+        im.bitmap_bit_order = im.byte_order;
+
+        size = im.bytes_per_line * h;
+        im.data = g_malloc(size);
+        expect = g_malloc(size);
+
+        printf("  %-24s", formats[f].name);
+        for (k = 0; k < N_KERNELS; ++k) {
+            if ((kernels[k].features & have) != kernels[k].features)
+                continue;
+            RrCpuLimitFeatures(kernels[k].features);
+
+            g_timer_start(timer);
+            for (i = 0; i < n; ++i)
+                RrReduceDepth(&inst, data, &im);
+            g_timer_stop(timer);
+
+            printf(" %s %7.1f Mpx/s", kernels[k].name,
+                   (gdouble)w * h * n / g_timer_elapsed(timer, NULL) / 1e6);
+
+            if (k == 0)
+                memcpy(expect, im.data, size);
+            else if (memcmp(expect, im.data, size)) {
+                printf(" (DIFFERENT)");
+                ok = FALSE;
+            }
+        }
+        printf("\n");
+
+        g_free(expect);
+        g_free(im.data);
+    }
+
+    g_timer_destroy(timer);
+    g_free(data);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,424 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   diskcache.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "diskcache.h"
+
+#include <glib.h>
+#include <string.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <utime.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <sys/types.h>
+
+/* "ObIc", which also comes out different when read with the wrong byte
+   order */
+#define DISK_MAGIC   0x4f624963
+/* change this when the pixels are kept differently */
+#define DISK_VERSION 2
+/* the length of a SHA-256 digest written out in hex */
+#define DIGEST_LEN 64
+
+/*! The start of each file, which is followed by the pixels */
+typedef struct {
+    guint32 magic;
+    guint32 version;
+    gint32 width;
+    gint32 height;
+    gchar digest[DIGEST_LEN]; /* of the picture it was resized from */
+} DiskHeader;
+
+typedef struct {
+    gchar *name;
+    gulong size;
+    time_t used;
+} DiskEntry;
+
+/*! A resized picture waiting to be written to its file */
+typedef struct {
+    gchar *name;
+    DiskHeader hd;
+    RrPixel32 *data;
+} DiskWrite;
+
+struct _RrDiskCache {
+    gchar *dir;
+    gulong max_bytes;
+    gulong bytes; /* the size of all the files in entries */
+    /*! The files in the directory, by name.  Other processes can add files
+      that aren't in here, they are found when they are looked up. */
+    GHashTable *entries;
+
+    /* the disk is only touched for lookups while painting, the rest waits
+       until openbox is idle */
+    GSList *writes; /* the DiskWrites waiting to be written */
+    GSList *used; /* the names of files which were read since then */
+    guint idle; /* the idle callback which does them, or 0 */
+};
+
+static void entry_free(DiskEntry *e)
+{
+    g_free(e->name);
+    g_slice_free(DiskEntry, e);
+}
+
+static void entry_set(RrDiskCache *self, const gchar *name, gulong size,
+                      time_t used)
+{
+    DiskEntry *e;
+
+    if ((e = g_hash_table_lookup(self->entries, name)))
+        self->bytes -= e->size;
+    else {
+        e = g_slice_new(DiskEntry);
+        e->name = g_strdup(name);
+        g_hash_table_insert(self->entries, e->name, e);
+    }
+    e->size = size;
+    e->used = used;
+    self->bytes += size;
+}
+
+static void entry_remove(RrDiskCache *self, DiskEntry *e)
+{
+    self->bytes -= e->size;
+    g_hash_table_remove(self->entries, e->name);
+}
+
+static void find_oldest(gpointer key, gpointer value, gpointer data)
+{
+    DiskEntry *e = value, **oldest = data;
+
+    if (!*oldest || e->used < (*oldest)->used)
+        *oldest = e;
+}
+
+/*! Removes the files used least recently until they fit in the cache's
+  size */
+static void evict(RrDiskCache *self)
+{
+    DiskEntry *e;
+    struct stat st;
+    gchar *path;
+
+    while (self->bytes > self->max_bytes) {
+        e = NULL;
+        g_hash_table_foreach(self->entries, find_oldest, &e);
+
+        path = g_build_filename(self->dir, e->name, NULL);
+        if (stat(path, &st) == 0 && st.st_mtime > e->used)
+            /* another process used it since we looked */
+            e->used = st.st_mtime;
+        else {
+            unlink(path);
+            entry_remove(self, e);
+        }
+        g_free(path);
+    }
+}
+
+/*! Returns the digest of the picture's pixels, which tells it apart from
+  every other picture */
+static gchar* pic_digest(const RrImagePic *src)
+{
+    return g_compute_checksum_for_data(G_CHECKSUM_SHA256,
+                                       (const guchar*)src->data,
+                                       (gsize)src->width * src->height *
+                                       sizeof(RrPixel32));
+}
+
+static gchar* entry_name(const gchar *digest, const RrImagePic *src,
+                         gint area_w, gint area_h, RrScaleFilter filter)
+{
+    return g_strdup_printf("%s-%dx%d-%dx%d-%d", digest,
+                           src->width, src->height, area_w, area_h, filter);
+}
+
+static gboolean write_all(gint fd, gconstpointer buf, gsize size)
+{
+    gssize n;
+
+    while (size > 0) {
+        if ((n = write(fd, buf, size)) < 0)
+            return FALSE;
+        buf = (const gchar*)buf + n;
+        size -= n;
+    }
+    return TRUE;
+}
+
+static void write_free(DiskWrite *w)
+{
+    g_free(w->name);
+    g_free(w->data);
+    g_slice_free(DiskWrite, w);
+}
+
+/*! Writes the picture to its file */
+static void write_file(RrDiskCache *self, DiskWrite *w)
+{
+    gchar *path, *tmp;
+    gsize size;
+    gboolean ok;
+    gint fd;
+
+    size = (gsize)w->hd.width * w->hd.height * sizeof(RrPixel32);
+    path = g_build_filename(self->dir, w->name, NULL);
+    /* other processes skip names with a '.' in them */
+    tmp = g_strdup_printf("%s.%d", path, (gint)getpid());
+
+    ok = FALSE;
+    if ((fd = open(tmp, O_WRONLY | O_CREAT | O_TRUNC, 0600)) >= 0) {
+        ok = write_all(fd, &w->hd, sizeof(w->hd)) &&
+            write_all(fd, w->data, size);
+        ok = close(fd) == 0 && ok;
+    }
+    if (ok && rename(tmp, path) == 0)
+        entry_set(self, w->name, sizeof(w->hd) + size, time(NULL));
+    else
+        unlink(tmp);
+
+    g_free(tmp);
+    g_free(path);
+}
+
+/*! Marks the files which were read as used, so other processes don't remove
+  them first, and removes the files which don't fit anymore */
+static void finish(RrDiskCache *self)
+{
+    gchar *path;
+
+    while (self->used) {
+        path = g_build_filename(self->dir, self->used->data, NULL);
+        utime(path, NULL);
+        g_free(path);
+        g_free(self->used->data);
+        self->used = g_slist_delete_link(self->used, self->used);
+    }
+    evict(self);
+}
+
+/*! Does everything that was waiting for openbox to be idle */
+static void flush(RrDiskCache *self)
+{
+    self->writes = g_slist_reverse(self->writes);
+    while (self->writes) {
+        write_file(self, self->writes->data);
+        write_free(self->writes->data);
+        self->writes = g_slist_delete_link(self->writes, self->writes);
+    }
+    finish(self);
+}
+
+/*! Writes one picture each time openbox is idle, and then does the rest */
+static gboolean flush_idle(gpointer data)
+{
+    RrDiskCache *self = data;
+    GSList *last;
+
+    if (self->writes) {
+        /* the oldest is at the end */
+        last = g_slist_last(self->writes);
+        write_file(self, last->data);
+        write_free(last->data);
+        self->writes = g_slist_delete_link(self->writes, last);
+        return TRUE; /* repeat */
+    }
+
+    finish(self);
+    self->idle = 0;
+    return FALSE; /* don't repeat */
+}
+
+static void flush_later(RrDiskCache *self)
+{
+    if (!self->idle)
+        self->idle = g_idle_add_full(G_PRIORITY_LOW, flush_idle, self, NULL);
+}
+
+static DiskWrite* find_write(RrDiskCache *self, const gchar *name)
+{
+    GSList *it;
+
+    for (it = self->writes; it; it = g_slist_next(it)) {
+        DiskWrite *w = it->data;
+        if (!strcmp(w->name, name)) return w;
+    }
+    return NULL;
+}
+
+RrDiskCache* RrDiskCacheNew(const gchar *dir, gulong max_bytes)
+{
+    RrDiskCache *self;
+    GDir *d;
+    const gchar *name;
+    gchar *path;
+    struct stat st;
+
+    if (!(d = g_dir_open(dir, 0, NULL)))
+        return NULL;
+
+    self = g_slice_new(RrDiskCache);
+    self->dir = g_strdup(dir);
+    self->max_bytes = max_bytes;
+    self->bytes = 0;
+    self->entries = g_hash_table_new_full(g_str_hash, g_str_equal, NULL,
+                                          (GDestroyNotify)entry_free);
+    self->writes = NULL;
+    self->used = NULL;
+    self->idle = 0;
+
+    while ((name = g_dir_read_name(d))) {
+        /* skip files which are still being written */
+        if (strchr(name, '.')) continue;
+
+        path = g_build_filename(dir, name, NULL);
+        if (stat(path, &st) == 0 && S_ISREG(st.st_mode))
+            entry_set(self, name, st.st_size, st.st_mtime);
+        g_free(path);
+    }
+    g_dir_close(d);
+
+    evict(self);
+    return self;
+}
+
+void RrDiskCacheFree(RrDiskCache *self)
+{
+    if (self) {
+        if (self->idle) g_source_remove(self->idle);
+        flush(self);
+        g_hash_table_destroy(self->entries);
+        g_free(self->dir);
+        g_slice_free(RrDiskCache, self);
+    }
+}
+
+gboolean RrDiskCacheIs(const RrDiskCache *self, const gchar *dir,
+                       gulong max_bytes)
+{
+    return self->max_bytes == max_bytes && !strcmp(self->dir, dir);
+}
+
+RrPixel32* RrDiskCacheLookup(RrDiskCache *self, const RrImagePic *src,
+                             gint area_w, gint area_h, RrScaleFilter filter,
+                             gint *w, gint *h)
+{
+    RrPixel32 *data = NULL;
+    const DiskHeader *hd;
+    DiskWrite *wr;
+    gchar *digest, *name, *path;
+    struct stat st;
+    gpointer map;
+    gint fd;
+
+    digest = pic_digest(src);
+    name = entry_name(digest, src, area_w, area_h, filter);
+
+    if ((wr = find_write(self, name))) {
+        /* it isn't written yet */
+        *w = wr->hd.width;
+        *h = wr->hd.height;
+        g_free(name);
+        g_free(digest);
+        return g_memdup(wr->data, (gsize)*w * *h * sizeof(RrPixel32));
+    }
+
+    path = g_build_filename(self->dir, name, NULL);
+
+    if ((fd = open(path, O_RDONLY)) >= 0) {
+        if (fstat(fd, &st) == 0 && st.st_size >= sizeof(DiskHeader) &&
+            (map = mmap(NULL, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0))
+            != MAP_FAILED)
+        {
+            hd = map;
+            if (hd->magic == DISK_MAGIC && hd->version == DISK_VERSION &&
+                /* it was made from the same picture */
+                !strncmp(hd->digest, digest, DIGEST_LEN) &&
+                hd->width > 0 && hd->width <= area_w &&
+                hd->height > 0 && hd->height <= area_h &&
+                st.st_size == sizeof(DiskHeader) +
+                (gsize)hd->width * hd->height * sizeof(RrPixel32))
+            {
+                *w = hd->width;
+                *h = hd->height;
+                data = g_memdup(hd + 1, st.st_size - sizeof(DiskHeader));
+            }
+            munmap(map, st.st_size);
+        }
+        close(fd);
+
+        if (data) {
+            /* move it to the back of the line for being removed, and tell
+               other processes so once openbox is idle */
+            entry_set(self, name, st.st_size, time(NULL));
+            if (!g_slist_find_custom(self->used, name, (GCompareFunc)strcmp))
+                self->used = g_slist_prepend(self->used, g_strdup(name));
+            flush_later(self);
+        }
+        else {
+            /* it was from an older openbox, or broken */
+            unlink(path);
+            if (g_hash_table_lookup(self->entries, name))
+                entry_remove(self, g_hash_table_lookup(self->entries, name));
+        }
+    }
+
+    g_free(path);
+    g_free(name);
+    g_free(digest);
+    return data;
+}
+
+void RrDiskCacheAdd(RrDiskCache *self, const RrImagePic *src,
+                    gint area_w, gint area_h, RrScaleFilter filter,
+                    const RrImagePic *resized)
+{
+    DiskWrite *w;
+    gchar *digest, *name;
+    gsize size;
+
+    size = (gsize)resized->width * resized->height * sizeof(RrPixel32);
+    if (sizeof(DiskHeader) + size > self->max_bytes)
+        return;
+
+    digest = pic_digest(src);
+    g_assert(strlen(digest) == DIGEST_LEN);
+    name = entry_name(digest, src, area_w, area_h, filter);
+
+    if (find_write(self, name)) {
+        g_free(name);
+        g_free(digest);
+        return;
+    }
+
+    w = g_slice_new(DiskWrite);
+    w->name = name;
+    w->hd.magic = DISK_MAGIC;
+    w->hd.version = DISK_VERSION;
+    w->hd.width = resized->width;
+    w->hd.height = resized->height;
+    memcpy(w->hd.digest, digest, DIGEST_LEN);
+    w->data = g_memdup(resized->data, size);
+    self->writes = g_slist_prepend(self->writes, w);
+    flush_later(self);
+
+    g_free(digest);
+}
@@ -0,0 +1,59 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   diskcache.h for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __render_diskcache_h
+#define __render_diskcache_h
+
+#include "render.h"
+
+#include <glib.h>
+
+/*! A directory of resized pictures, one per file, which is shared by every
+  process using it.  Files are written under a temporary name and then
+  renamed, so they are never seen half written.  Each file holds a digest
+  of the picture it was resized from, which has to match for it to be used.
+  When the files add up to more than the cache's size, the ones used least
+  recently are removed.
+*/
+typedef struct _RrDiskCache RrDiskCache;
+
+/*! Opens the cache in @dir, which must already exist.  Returns NULL if it
+  can't be read. */
+RrDiskCache* RrDiskCacheNew(const gchar *dir, gulong max_bytes);
+void         RrDiskCacheFree(RrDiskCache *self);
+/*! Returns TRUE if the cache was opened in @dir with a size of @max_bytes */
+gboolean     RrDiskCacheIs(const RrDiskCache *self, const gchar *dir,
+                           gulong max_bytes);
+
+/*! Finds the picture made from resizing @src to fit in an area of
+  @area_w x @area_h.
+  @return A new array of pixels, to be freed with g_free(), or NULL if the
+    cache doesn't have it.  The picture's size is returned in @w and @h.
+*/
+RrPixel32* RrDiskCacheLookup(RrDiskCache *self, const RrImagePic *src,
+                             gint area_w, gint area_h, RrScaleFilter filter,
+                             gint *w, gint *h);
+/*! Saves @resized, which was made by resizing @src to fit in an area of
+  @area_w x @area_h.  The file is written, and files are removed to make room
+  for it, from an idle callback in the main loop, or when the cache is
+  freed. */
+void       RrDiskCacheAdd(RrDiskCache *self, const RrImagePic *src,
+                          gint area_w, gint area_h, RrScaleFilter filter,
+                          const RrImagePic *resized);
+
+#endif
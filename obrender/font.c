@@ -31,6 +31,137 @@
 #include <stdlib.h>
 #include <locale.h>
 
+/*! The most layouts kept for each font.  A menu is measured and then drawn
+  with the same layouts, so this is enough for a menu with hundreds of
+  items to be shown again without laying it out again. */
+#define FONT_LAYOUTS 1024
+
+/*! A string laid out in a font */
+typedef struct _RrFontLayout {
+    gchar *string;
+    gboolean flow;
+    gint width; /*!< In pango units, or -1 for no limit */
+    PangoEllipsizeMode ellipsize;
+    gint shortcut; /*!< The index of the underlined character, or -1 */
+
+    PangoLayout *layout;
+    PangoRectangle rect; /*!< The layout's logical extents */
+    GList *lru; /*!< The layout's link in the font's layouts_lru */
+} RrFontLayout;
+
+static gulong layout_hits = 0;
+static gulong layout_misses = 0;
+
+static guint layout_hash(gconstpointer p)
+{
+    const RrFontLayout *l = p;
+
+    return g_str_hash(l->string) ^ ((guint)l->width * 31) ^
+        ((guint)l->ellipsize << 24) ^ ((guint)(l->shortcut + 1) << 16) ^
+        (guint)l->flow;
+}
+
+static gboolean layout_equal(gconstpointer p1, gconstpointer p2)
+{
+    const RrFontLayout *l1 = p1, *l2 = p2;
+
+    return l1->flow == l2->flow && l1->width == l2->width &&
+        l1->ellipsize == l2->ellipsize && l1->shortcut == l2->shortcut &&
+        !strcmp(l1->string, l2->string);
+}
+
+static void layout_remove(const RrFont *f, RrFontLayout *l)
+{
+    g_hash_table_remove(f->layouts, l);
+    g_queue_delete_link(f->layouts_lru, l->lru);
+    g_object_unref(l->layout);
+    g_free(l->string);
+    g_slice_free(RrFontLayout, l);
+}
+
+/*! Returns the string laid out in the font, from the font's layouts if it
+  is there */
+static RrFontLayout* font_layout(const RrFont *f, const gchar *str,
+                                 gboolean flow, gint width,
+                                 PangoEllipsizeMode ellipsize, gint shortcut)
+{
+    RrFontLayout key, *l;
+    PangoAttrList *attrlist;
+    PangoAttribute *underline;
+
+    key.string = (gchar*)str;
+    key.flow = flow;
+    key.width = width;
+    key.ellipsize = ellipsize;
+    key.shortcut = shortcut;
+
+    if ((l = g_hash_table_lookup(f->layouts, &key))) {
+        ++layout_hits;
+        /* move it to the front of the line */
+        g_queue_unlink(f->layouts_lru, l->lru);
+        g_queue_push_head_link(f->layouts_lru, l->lru);
+        return l;
+    }
+    ++layout_misses;
+
+    l = g_slice_new(RrFontLayout);
+    *l = key;
+    l->string = g_strdup(str);
+
+    l->layout = pango_layout_new(f->inst->pango);
+    pango_layout_set_font_description(l->layout, f->font_desc);
+    pango_layout_set_wrap(l->layout, PANGO_WRAP_WORD_CHAR);
+    pango_layout_set_single_paragraph_mode(l->layout, !flow);
+    pango_layout_set_width(l->layout, width);
+    pango_layout_set_ellipsize(l->layout, ellipsize);
+
+    if (shortcut >= 0) {
+        underline = pango_attr_underline_new(PANGO_UNDERLINE_SINGLE);
+        underline->start_index = shortcut;
+        underline->end_index = g_utf8_next_char(str + shortcut) - str;
+
+        /* the attributes are owned by the layout */
+        attrlist = pango_attr_list_new();
+        pango_attr_list_insert(attrlist, underline);
+        pango_layout_set_attributes(l->layout, attrlist);
+        pango_attr_list_unref(attrlist);
+    }
+
+    pango_layout_set_text(l->layout, str, -1);
+    /* this lays out the string, which is the slow part */
+    pango_layout_get_extents(l->layout, NULL, &l->rect);
+
+    g_queue_push_head(f->layouts_lru, l);
+    l->lru = g_queue_peek_head_link(f->layouts_lru);
+    g_hash_table_insert(f->layouts, l, l);
+
+    if (g_queue_get_length(f->layouts_lru) > FONT_LAYOUTS)
+        layout_remove(f, g_queue_peek_tail(f->layouts_lru));
+
+    return l;
+}
+
+/*! Gets the area of a layout's text in pixels */
+static void layout_pixel_extents(const RrFontLayout *l, PangoRectangle *rect)
+{
+    *rect = l->rect;
+#if PANGO_VERSION_MAJOR > 1 || \
+    (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
+    /* pass the logical rect as the ink rect, this is on purpose so we get the
+       full area for the text */
+    pango_extents_to_pixels(rect, NULL);
+#else
+    rect->width = (rect->width + PANGO_SCALE - 1) / PANGO_SCALE;
+    rect->height = (rect->height + PANGO_SCALE - 1) / PANGO_SCALE;
+#endif
+}
+
+void RrFontCacheStats(gulong *hits, gulong *misses)
+{
+    *hits = layout_hits;
+    *misses = layout_misses;
+}
+
 static void measure_font(const RrInstance *inst, RrFont *f)
 {
     PangoFontMetrics *metrics;
@@ -66,23 +197,13 @@ RrFont *RrFontOpen(const RrInstance *inst, const gchar *name, gint size,
     RrFont *out;
     PangoWeight pweight;
     PangoStyle pstyle;
-    PangoAttrList *attrlist;
 
     out = g_slice_new(RrFont);
     out->inst = inst;
     out->ref = 1;
     out->font_desc = pango_font_description_new();
-    out->layout = pango_layout_new(inst->pango);
-    out->shortcut_underline = pango_attr_underline_new(PANGO_UNDERLINE_SINGLE);
-    out->shortcut_underline->start_index = 0;
-    out->shortcut_underline->end_index = 0;
-
-    attrlist = pango_attr_list_new();
-    /* shortcut_underline is owned by the attrlist */
-    pango_attr_list_insert(attrlist, out->shortcut_underline);
-    /* the attributes are owned by the layout */
-    pango_layout_set_attributes(out->layout, attrlist);
-    pango_attr_list_unref(attrlist);
+    out->layouts = g_hash_table_new(layout_hash, layout_equal);
+    out->layouts_lru = g_queue_new();
 
     switch (weight) {
     case RR_FONTWEIGHT_LIGHT:     pweight = PANGO_WEIGHT_LIGHT;     break;
@@ -106,10 +227,6 @@ RrFont *RrFontOpen(const RrInstance *inst, const gchar *name, gint size,
     pango_font_description_set_style(out->font_desc, pstyle);
     pango_font_description_set_size(out->font_desc, size * PANGO_SCALE);
 
-    /* setup the layout */
-    pango_layout_set_font_description(out->layout, out->font_desc);
-    pango_layout_set_wrap(out->layout, PANGO_WRAP_WORD_CHAR);
-
     /* get the ascent and descent */
     measure_font(inst, out);
 
@@ -131,7 +248,10 @@ void RrFontClose(RrFont *f)
 {
     if (f) {
         if (--f->ref < 1) {
-            g_object_unref(f->layout);
+            while (!g_queue_is_empty(f->layouts_lru))
+                layout_remove(f, g_queue_peek_tail(f->layouts_lru));
+            g_queue_free(f->layouts_lru);
+            g_hash_table_destroy(f->layouts);
             pango_font_description_free(f->font_desc);
             g_slice_free(RrFont, f);
         }
@@ -142,33 +262,19 @@ static void font_measure_full(const RrFont *f, const gchar *str,
                               gint *x, gint *y, gint shadow_x, gint shadow_y,
                               gboolean flow, gint maxwidth)
 {
+    RrFontLayout *l;
     PangoRectangle rect;
 
-    pango_layout_set_text(f->layout, str, -1);
-    if (flow) {
-        pango_layout_set_single_paragraph_mode(f->layout, FALSE);
-        pango_layout_set_width(f->layout, maxwidth * PANGO_SCALE);
-        pango_layout_set_ellipsize(f->layout, PANGO_ELLIPSIZE_NONE);
-    }
-    else {
+    if (flow)
+        l = font_layout(f, str, TRUE, maxwidth * PANGO_SCALE,
+                        PANGO_ELLIPSIZE_NONE, -1);
+    else
         /* single line mode */
-        pango_layout_set_single_paragraph_mode(f->layout, TRUE);
-        pango_layout_set_width(f->layout, -1);
-        pango_layout_set_ellipsize(f->layout, PANGO_ELLIPSIZE_MIDDLE);
-    }
+        l = font_layout(f, str, FALSE, -1, PANGO_ELLIPSIZE_MIDDLE, -1);
 
     /* pango_layout_get_pixel_extents lies! this is the right way to get the
        size of the text's area */
-    pango_layout_get_extents(f->layout, NULL, &rect);
-#if PANGO_VERSION_MAJOR > 1 || \
-    (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
-    /* pass the logical rect as the ink rect, this is on purpose so we get the
-       full area for the text */
-    pango_extents_to_pixels(&rect, NULL);
-#else
-    rect.width = (rect.width + PANGO_SCALE - 1) / PANGO_SCALE;
-    rect.height = (rect.height + PANGO_SCALE - 1) / PANGO_SCALE;
-#endif
+    layout_pixel_extents(l, &rect);
     *x = rect.width + ABS(shadow_x) + 4 /* we put a 2 px edge on each side */;
     *y = rect.height + ABS(shadow_y);
 }
@@ -219,10 +325,10 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
 {
     gint x,y,w;
     XftColor c;
-    gint mw;
+    gint mw, shortcut;
     PangoRectangle rect;
-    PangoAttrList *attrlist;
     PangoEllipsizeMode ell;
+    RrFontLayout *l;
 
     g_assert(!t->flow || t->maxwidth > 0);
 
@@ -263,14 +369,23 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
         }
     }
 
-    pango_layout_set_text(t->font->layout, t->string, -1);
-    pango_layout_set_width(t->font->layout, w * PANGO_SCALE);
-    pango_layout_set_ellipsize(t->font->layout, ell);
-    pango_layout_set_single_paragraph_mode(t->font->layout, !t->flow);
+    shortcut = t->shortcut ? t->shortcut_pos : -1;
+    l = NULL;
+    if (!t->flow && shortcut < 0) {
+        /* the string was probably measured before being drawn, and that
+           layout looks the same as long as it fits */
+        l = font_layout(t->font, t->string, FALSE, -1,
+                        PANGO_ELLIPSIZE_MIDDLE, -1);
+        if (l->rect.width > w * PANGO_SCALE)
+            l = NULL;
+    }
+    if (!l)
+        l = font_layout(t->font, t->string, t->flow, w * PANGO_SCALE, ell,
+                        shortcut);
 
     /* * * end of setting up the layout * * */
 
-    pango_layout_get_pixel_extents(t->font->layout, NULL, &rect);
+    layout_pixel_extents(l, &rect);
     mw = rect.width;
 
     /* pango_layout_set_alignment doesn't work with
@@ -312,15 +427,15 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
                 (d, &c,
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
-                 pango_layout_get_line_readonly(t->font->layout, 0),
+                 pango_layout_get_line_readonly(l->layout, 0),
 #else
-                 pango_layout_get_line(t->font->layout, 0),
+                 pango_layout_get_line(l->layout, 0),
 #endif
                  (x + t->shadow_offset_x) * PANGO_SCALE,
                  (y + t->shadow_offset_y) * PANGO_SCALE);
         }
         else {
-            pango_xft_render_layout(d, &c, t->font->layout,
+            pango_xft_render_layout(d, &c, l->layout,
                                     (x + t->shadow_offset_x) * PANGO_SCALE,
                                     (y + t->shadow_offset_y) * PANGO_SCALE);
         }
@@ -332,22 +447,6 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
     c.color.alpha = 0xff | 0xff << 8; /* fully opaque text */
     c.pixel = t->color->pixel;
 
-    if (t->shortcut) {
-        const gchar *s = t->string + t->shortcut_pos;
-
-        t->font->shortcut_underline->start_index = t->shortcut_pos;
-        t->font->shortcut_underline->end_index = t->shortcut_pos +
-            (g_utf8_next_char(s) - s);
-
-        /* the attributes are owned by the layout.
-           re-add the attributes to the layout after changing the
-           start and end index */
-        attrlist = pango_layout_get_attributes(t->font->layout);
-        pango_attr_list_ref(attrlist);
-        pango_layout_set_attributes(t->font->layout, attrlist);
-        pango_attr_list_unref(attrlist);
-    }
-
     /* layout_line() uses y to specify the baseline
        The line doesn't need to be freed, it's a part of the layout */
     if (!t->flow) {
@@ -355,28 +454,16 @@ void RrFontDraw(XftDraw *d, RrTextureText *t, RrRect *area)
             (d, &c,
 #if PANGO_VERSION_MAJOR > 1 || \
     (PANGO_VERSION_MAJOR == 1 && PANGO_VERSION_MINOR >= 16)
-             pango_layout_get_line_readonly(t->font->layout, 0),
+             pango_layout_get_line_readonly(l->layout, 0),
 #else
-             pango_layout_get_line(t->font->layout, 0),
+             pango_layout_get_line(l->layout, 0),
 #endif
              x * PANGO_SCALE,
              y * PANGO_SCALE);
     }
     else {
-        pango_xft_render_layout(d, &c, t->font->layout,
+        pango_xft_render_layout(d, &c, l->layout,
                                 x * PANGO_SCALE,
                                 y * PANGO_SCALE);
     }
-
-    if (t->shortcut) {
-        t->font->shortcut_underline->start_index = 0;
-        t->font->shortcut_underline->end_index = 0;
-        /* the attributes are owned by the layout.
-           re-add the attributes to the layout after changing the
-           start and end index */
-        attrlist = pango_layout_get_attributes(t->font->layout);
-        pango_attr_list_ref(attrlist);
-        pango_layout_set_attributes(t->font->layout, attrlist);
-        pango_attr_list_unref(attrlist);
-    }
 }
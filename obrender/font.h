@@ -27,8 +27,11 @@ struct _RrFont {
     const RrInstance *inst;
     gint ref;
     PangoFontDescription *font_desc;
-    PangoLayout *layout; /*!< Used for measuring and rendering strings */
-    PangoAttribute *shortcut_underline; /*< For underlining the shortcut key */
+    /*! Layouts for the strings measured and drawn recently, so they don't
+      have to be laid out again.  These are keyed by the string and
+      everything else that changes how it is laid out. */
+    GHashTable *layouts;
+    GQueue *layouts_lru; /*!< The most recently used layout is at the head */
     gint ascent; /*!< The font's ascent in pango-units */
     gint descent; /*!< The font's descent in pango-units */
 };
@@ -21,9 +21,22 @@
 #include "render.h"
 #include "gradient.h"
 #include "color.h"
+#include "cpu.h"
 #include <glib.h>
 #include <string.h>
 
+/*! Fills @len pixels with a gradient from @from to @to, giving exactly the
+  colors that stepping through it with SETUP and NEXT gives.  SETUP doesn't
+  reset the error, so @error is carried from one span into the next, the
+  same as it was when each row was stepped through with the macros. */
+typedef void (*GradientSpanFunc)(RrPixel32 *data, gint len,
+                                 const RrColor *from, const RrColor *to,
+                                 gint *error);
+
+/*! The fastest GradientSpanFunc the processor can run */
+static GradientSpanFunc gradient_span;
+
+static GradientSpanFunc pick_span(void);
 static void highlight(RrSurface *s, RrPixel32 *x, RrPixel32 *y,
                       gboolean raised);
 static void gradient_parentrelative(RrAppearance *a, gint w, gint h);
@@ -43,6 +56,8 @@ void RrRender(RrAppearance *a, gint w, gint h)
     guint r,g,b;
     register gint off, x;
 
+    gradient_span = pick_span();
+
     switch (a->surface.grad) {
     case RR_SURFACE_PARENTREL:
         gradient_parentrelative(a, w, h);
@@ -332,7 +347,8 @@ static void gradient_solid(RrAppearance *l, gint w, gint h)
     for (i = 0; i < w * h; i++)
         *data++ = pix;
 
-    if (sp->interlaced)
+    /* there is no pixmap when only the pixel data is wanted */
+    if (sp->interlaced || l->pixmap == None)
         return;
 
     XFillRectangle(RrDisplay(l->inst), l->pixmap, RrColorGC(sp->primary),
@@ -456,6 +472,11 @@ static void gradient_solid(RrAppearance *l, gint w, gint h)
     c->g = color##x[1];                      \
     c->b = color##x[2]
 
+#define COLOR_OF(c)                   \
+    ((c->r << RrDefaultRedOffset) +   \
+     (c->g << RrDefaultGreenOffset) + \
+     (c->b << RrDefaultBlueOffset))
+
 #define COLOR(x)                             \
     ((color##x[0] << RrDefaultRedOffset) +   \
      (color##x[1] << RrDefaultGreenOffset) + \
@@ -491,6 +512,235 @@ static void gradient_solid(RrAppearance *l, gint w, gint h)
     }                                                     \
 }
 
+static void span_scalar(RrPixel32 *data, gint len,
+                        const RrColor *from, const RrColor *to, gint *error)
+{
+    register gint x;
+
+    VARS(x);
+    SETUP(x, from, to, len);
+    errorx[0] = error[0];
+    errorx[1] = error[1];
+    errorx[2] = error[2];
+
+    for (x = len - 1; x > 0; --x) {  /* 0 -> len - 1 */
+        *(data++) = COLOR(x);
+        NEXT(x);
+    }
+    *data = COLOR(x);
+
+    error[0] = errorx[0];
+    error[1] = errorx[1];
+    error[2] = errorx[2];
+}
+
+#ifdef USE_SIMD
+
+#include <immintrin.h>
+
+/* spans shorter than this aren't worth setting up the lanes for */
+#define SPAN_MIN_VECTOR 16
+#define SPAN_MAX_LANES 8
+
+/* When NEXT moves a color channel by d over len pixels, starting with an
+   error of e, then after k > 0 pixels it has moved by
+   floor((a + 2kd) / 2len), where a is len + 2e if d <= len, and
+   2len - 1 - d - 2e otherwise.  For d <= len this can go below 0 when the
+   error left by a steeper gradient is very negative, where NEXT would not
+   have moved yet.
+
+   So each lane of a vector can hold a different pixel, and every lane can
+   be moved forward by the number of lanes at once, as the same division
+   with a remainder. */
+typedef struct {
+    gint moved[SPAN_MAX_LANES]; /* the quotient */
+    gint rem[SPAN_MAX_LANES];   /* the remainder, in [0, 2len) */
+    gint step;     /* how far moved goes when stepping all the lanes */
+    gint steprem;  /* how far rem goes when stepping all the lanes */
+    gint neg;      /* -1 if the color goes down, or 0 */
+} SpanLanes;
+
+static gint floor_div(gint a, gint b)
+{
+    return a >= 0 ? a / b : -((b - 1 - a) / b);
+}
+
+/*! Sets up the lanes for one color channel, and moves @error to where NEXT
+  would leave it at the end of the span */
+static void span_lanes(SpanLanes *l, gint from, gint to, gint len,
+                       gint *error, gint lanes)
+{
+    gint d, den, num, j, last;
+
+    d = ABS(to - from);
+    den = len << 1;
+    num = d > len ? den - 1 - d - (*error << 1) : len + (*error << 1);
+    l->neg = to < from ? -1 : 0;
+
+    l->moved[0] = floor_div(num, den);
+    l->rem[0] = num - l->moved[0] * den;
+    for (j = 1; j < lanes; ++j) {
+        l->moved[j] = l->moved[j-1] + (d << 1) / den;
+        l->rem[j] = l->rem[j-1] + (d << 1) % den;
+        if (l->rem[j] >= den) {
+            ++l->moved[j];
+            l->rem[j] -= den;
+        }
+    }
+    l->step = (lanes * d << 1) / den;
+    l->steprem = (lanes * d << 1) % den;
+
+    if (d && len > 1) {
+        last = MAX(floor_div(num + (len - 1) * (d << 1), den), 0);
+        if (d > len)
+            *error += last * len - (len - 1) * d;
+        else
+            *error += (len - 1) * d - last * len;
+    }
+}
+
+__attribute__((target("sse2")))
+static void span_sse2(RrPixel32 *data, gint len,
+                      const RrColor *from, const RrColor *to, gint *error)
+{
+    SpanLanes l[3];
+    __m128i moved[3], rem[3], step[3], steprem[3], neg[3], start[3];
+    __m128i den, max, one, over, c[3], p;
+    RrPixel32 tail[4];
+    gint i, k;
+
+    if (len < SPAN_MIN_VECTOR) {
+        span_scalar(data, len, from, to, error);
+        return;
+    }
+
+    span_lanes(&l[0], from->r, to->r, len, &error[0], 4);
+    span_lanes(&l[1], from->g, to->g, len, &error[1], 4);
+    span_lanes(&l[2], from->b, to->b, len, &error[2], 4);
+    start[0] = _mm_set1_epi32(from->r);
+    start[1] = _mm_set1_epi32(from->g);
+    start[2] = _mm_set1_epi32(from->b);
+    for (i = 0; i < 3; ++i) {
+        moved[i] = _mm_loadu_si128((__m128i*)l[i].moved);
+        rem[i] = _mm_loadu_si128((__m128i*)l[i].rem);
+        step[i] = _mm_set1_epi32(l[i].step);
+        steprem[i] = _mm_set1_epi32(l[i].steprem);
+        neg[i] = _mm_set1_epi32(l[i].neg);
+    }
+    den = _mm_set1_epi32(len << 1);
+    max = _mm_set1_epi32((len << 1) - 1);
+    one = _mm_set1_epi32(1);
+
+    for (k = 0; ; k += 4) {
+        for (i = 0; i < 3; ++i) {
+            /* don't go back past the start, and then add or subtract */
+            c[i] = _mm_andnot_si128(_mm_srai_epi32(moved[i], 31), moved[i]);
+            c[i] = _mm_sub_epi32(_mm_xor_si128(c[i], neg[i]), neg[i]);
+            c[i] = _mm_add_epi32(start[i], c[i]);
+        }
+        /* add, not or, so colors that went past 0 or 255 come out the same
+           as from COLOR */
+        p = _mm_add_epi32(
+            _mm_add_epi32(_mm_slli_epi32(c[0], RrDefaultRedOffset),
+                          _mm_slli_epi32(c[1], RrDefaultGreenOffset)),
+            _mm_slli_epi32(c[2], RrDefaultBlueOffset));
+        if (k + 4 > len) {
+            _mm_storeu_si128((__m128i*)tail, p);
+            memcpy(data + k, tail, (len - k) * sizeof(RrPixel32));
+            break;
+        }
+        _mm_storeu_si128((__m128i*)(data + k), p);
+
+        for (i = 0; i < 3; ++i) {
+            rem[i] = _mm_add_epi32(rem[i], steprem[i]);
+            over = _mm_cmpgt_epi32(rem[i], max);
+            rem[i] = _mm_sub_epi32(rem[i], _mm_and_si128(over, den));
+            moved[i] = _mm_add_epi32(_mm_add_epi32(moved[i], step[i]),
+                                     _mm_and_si128(over, one));
+        }
+    }
+
+    /* the formula doesn't hold for the first pixel */
+    data[0] = COLOR_OF(from);
+}
+
+__attribute__((target("avx2")))
+static void span_avx2(RrPixel32 *data, gint len,
+                      const RrColor *from, const RrColor *to, gint *error)
+{
+    SpanLanes l[3];
+    __m256i moved[3], rem[3], step[3], steprem[3], neg[3], start[3];
+    __m256i den, max, one, over, c[3], p;
+    RrPixel32 tail[8];
+    gint i, k;
+
+    if (len < SPAN_MIN_VECTOR) {
+        span_scalar(data, len, from, to, error);
+        return;
+    }
+
+    span_lanes(&l[0], from->r, to->r, len, &error[0], 8);
+    span_lanes(&l[1], from->g, to->g, len, &error[1], 8);
+    span_lanes(&l[2], from->b, to->b, len, &error[2], 8);
+    start[0] = _mm256_set1_epi32(from->r);
+    start[1] = _mm256_set1_epi32(from->g);
+    start[2] = _mm256_set1_epi32(from->b);
+    for (i = 0; i < 3; ++i) {
+        moved[i] = _mm256_loadu_si256((__m256i*)l[i].moved);
+        rem[i] = _mm256_loadu_si256((__m256i*)l[i].rem);
+        step[i] = _mm256_set1_epi32(l[i].step);
+        steprem[i] = _mm256_set1_epi32(l[i].steprem);
+        neg[i] = _mm256_set1_epi32(l[i].neg);
+    }
+    den = _mm256_set1_epi32(len << 1);
+    max = _mm256_set1_epi32((len << 1) - 1);
+    one = _mm256_set1_epi32(1);
+
+    for (k = 0; ; k += 8) {
+        for (i = 0; i < 3; ++i) {
+            c[i] = _mm256_max_epi32(moved[i], _mm256_setzero_si256());
+            c[i] = _mm256_sub_epi32(_mm256_xor_si256(c[i], neg[i]), neg[i]);
+            c[i] = _mm256_add_epi32(start[i], c[i]);
+        }
+        p = _mm256_add_epi32(
+            _mm256_add_epi32(_mm256_slli_epi32(c[0], RrDefaultRedOffset),
+                             _mm256_slli_epi32(c[1],
+                                               RrDefaultGreenOffset)),
+            _mm256_slli_epi32(c[2], RrDefaultBlueOffset));
+        if (k + 8 > len) {
+            _mm256_storeu_si256((__m256i*)tail, p);
+            memcpy(data + k, tail, (len - k) * sizeof(RrPixel32));
+            break;
+        }
+        _mm256_storeu_si256((__m256i*)(data + k), p);
+
+        for (i = 0; i < 3; ++i) {
+            rem[i] = _mm256_add_epi32(rem[i], steprem[i]);
+            over = _mm256_cmpgt_epi32(rem[i], max);
+            rem[i] = _mm256_sub_epi32(rem[i], _mm256_and_si256(over, den));
+            moved[i] = _mm256_add_epi32(_mm256_add_epi32(moved[i], step[i]),
+                                        _mm256_and_si256(over, one));
+        }
+    }
+
+    data[0] = COLOR_OF(from);
+}
+
+#endif
+
+static GradientSpanFunc pick_span(void)
+{
+#ifdef USE_SIMD
+    RrCpuFeatures f = RrCpuGetFeatures();
+
+    if (f & RR_CPU_AVX2)
+        return span_avx2;
+    if (f & RR_CPU_SSE2)
+        return span_sse2;
+#endif
+    return span_scalar;
+}
+
 static void gradient_splitvertical(RrAppearance *a, gint w, gint h)
 {
     register gint y1, y2, y3;
@@ -562,22 +812,14 @@ static void gradient_splitvertical(RrAppearance *a, gint w, gint h)
 
 static void gradient_horizontal(RrSurface *sf, gint w, gint h)
 {
-    register gint x, y, cpbytes;
+    register gint y, cpbytes;
     RrPixel32 *data = sf->pixel_data, *datav;
     gchar *datac;
-
-    VARS(x);
-    SETUP(x, sf->primary, sf->secondary, w);
+    gint error[3] = { 0, 0, 0 };
 
     /* set the color values for the first row */
-    datav = data;
-    for (x = w - 1; x > 0; --x) {  /* 0 -> w - 1 */
-        *datav = COLOR(x);
-        ++datav;
-        NEXT(x);
-    }
-    *datav = COLOR(x);
-    ++datav;
+    gradient_span(data, w, sf->primary, sf->secondary, error);
+    datav = data + w;
 
     /* copy the first row to the rest in O(logn) copies */
     datac = (gchar*)datav;
@@ -667,14 +909,14 @@ static void gradient_vertical(RrSurface *sf, gint w, gint h)
 
 static void gradient_diagonal(RrSurface *sf, gint w, gint h)
 {
-    register gint x, y;
+    register gint y;
     RrPixel32 *data = sf->pixel_data;
     RrColor left, right;
     RrColor extracorner;
+    gint error[3] = { 0, 0, 0 };
 
     VARS(lefty);
     VARS(righty);
-    VARS(x);
 
     extracorner.r = (sf->primary->r + sf->secondary->r) / 2;
     extracorner.g = (sf->primary->g + sf->secondary->g) / 2;
@@ -687,14 +929,8 @@ static void gradient_diagonal(RrSurface *sf, gint w, gint h)
         COLOR_RR(lefty, (&left));
         COLOR_RR(righty, (&right));
 
-        SETUP(x, (&left), (&right), w);
-
-        for (x = w - 1; x > 0; --x) {  /* 0 -> w-1 */
-            *(data++) = COLOR(x);
-
-            NEXT(x);
-        }
-        *(data++) = COLOR(x);
+        gradient_span(data, w, &left, &right, error);
+        data += w;
 
         NEXT(lefty);
         NEXT(righty);
@@ -702,26 +938,19 @@ static void gradient_diagonal(RrSurface *sf, gint w, gint h)
     COLOR_RR(lefty, (&left));
     COLOR_RR(righty, (&right));
 
-    SETUP(x, (&left), (&right), w);
-
-    for (x = w - 1; x > 0; --x) {  /* 0 -> w-1 */
-        *(data++) = COLOR(x);
-
-        NEXT(x);
-    }
-    *data = COLOR(x);
+    gradient_span(data, w, &left, &right, error);
 }
 
 static void gradient_crossdiagonal(RrSurface *sf, gint w, gint h)
 {
-    register gint x, y;
+    register gint y;
     RrPixel32 *data = sf->pixel_data;
     RrColor left, right;
     RrColor extracorner;
+    gint error[3] = { 0, 0, 0 };
 
     VARS(lefty);
     VARS(righty);
-    VARS(x);
 
     extracorner.r = (sf->primary->r + sf->secondary->r) / 2;
     extracorner.g = (sf->primary->g + sf->secondary->g) / 2;
@@ -734,14 +963,8 @@ static void gradient_crossdiagonal(RrSurface *sf, gint w, gint h)
         COLOR_RR(lefty, (&left));
         COLOR_RR(righty, (&right));
 
-        SETUP(x, (&left), (&right), w);
-
-        for (x = w - 1; x > 0; --x) {  /* 0 -> w-1 */
-            *(data++) = COLOR(x);
-
-            NEXT(x);
-        }
-        *(data++) = COLOR(x);
+        gradient_span(data, w, &left, &right, error);
+        data += w;
 
         NEXT(lefty);
         NEXT(righty);
@@ -749,14 +972,7 @@ static void gradient_crossdiagonal(RrSurface *sf, gint w, gint h)
     COLOR_RR(lefty, (&left));
     COLOR_RR(righty, (&right));
 
-    SETUP(x, (&left), (&right), w);
-
-    for (x = w - 1; x > 0; --x) {  /* 0 -> w-1 */
-        *(data++) = COLOR(x);
-
-        NEXT(x);
-    }
-    *data = COLOR(x);
+    gradient_span(data, w, &left, &right, error);
 }
 
 static void gradient_pyramid(RrSurface *sf, gint w, gint h)
@@ -766,10 +982,10 @@ static void gradient_pyramid(RrSurface *sf, gint w, gint h)
     RrColor left, right;
     RrColor extracorner;
     register gint x, y, halfw, halfh, midx, midy;
+    gint error[3] = { 0, 0, 0 };
 
     VARS(lefty);
     VARS(righty);
-    VARS(x);
 
     extracorner.r = (sf->primary->r + sf->secondary->r) / 2;
     extracorner.g = (sf->primary->g + sf->secondary->g) / 2;
@@ -785,30 +1001,22 @@ static void gradient_pyramid(RrSurface *sf, gint w, gint h)
 
     /* draw the top half
 
-       it is faster to draw both top quarters together than to draw one and
-       then copy it over to the other side.
+       each row of the left quarter is mirrored into the right quarter while
+       it is still in the cache, rather than copying over the whole quarter
+       afterward.
     */
 
     ldata = sf->pixel_data;
     rdata = ldata + w - 1;
     for (y = halfh + midy; y > 0; --y) {  /* 0 -> (h+1)/2 */
-        RrPixel32 c;
-
         COLOR_RR(lefty, (&left));
         COLOR_RR(righty, (&right));
 
-        SETUP(x, (&left), (&right), halfw + midx);
-
-        for (x = halfw + midx - 1; x > 0; --x) {  /* 0 -> (w+1)/2 */
-            c = COLOR(x);
-            *(ldata++) = *(rdata--) = c;
-
-            NEXT(x);
-        }
-        c = COLOR(x);
-        *ldata = *rdata = c;
-        ldata += halfw + 1;
-        rdata += halfw - 1 + midx + w;
+        gradient_span(ldata, halfw + midx, &left, &right, error);
+        for (x = halfw + midx; x > 0; --x)  /* 0 -> (w+1)/2 */
+            *(rdata--) = *(ldata++);
+        ldata += halfw;
+        rdata += halfw + midx + w;
 
         NEXT(lefty);
         NEXT(righty);
@@ -0,0 +1,147 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   gradientbench.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Renders each type of gradient at the sizes of titlebars and menus on a
+   4K monitor, once with each set of vector instructions that the processor
+   has, and checks that they all give the same pixels as the plain C code. */
+
+#include "render.h"
+#include "gradient.h"
+#include "cpu.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+#include <X11/Xlib.h>
+
+static const struct {
+    const gchar *name;
+    RrSurfaceColorType grad;
+} grads[] = {
+    { "vertical", RR_SURFACE_VERTICAL },
+    { "splitvertical", RR_SURFACE_SPLIT_VERTICAL },
+    { "horizontal", RR_SURFACE_HORIZONTAL },
+    { "mirrorhorizontal", RR_SURFACE_MIRROR_HORIZONTAL },
+    { "diagonal", RR_SURFACE_DIAGONAL },
+    { "crossdiagonal", RR_SURFACE_CROSS_DIAGONAL },
+    { "pyramid", RR_SURFACE_PYRAMID }
+};
+
+static const struct {
+    const gchar *name;
+    gint w, h;
+} sizes[] = {
+    { "title", 3840, 24 },
+    { "menu item", 3840, 20 },
+    { "menu", 640, 2160 }
+};
+
+static const struct {
+    const gchar *name;
+    RrCpuFeatures features;
+} kernels[] = {
+    { "c", 0 },
+    { "sse2", RR_CPU_SSE2 },
+    { "avx2", RR_CPU_SSE2 | RR_CPU_AVX2 }
+};
+
+#define N_GRADS (sizeof(grads) / sizeof(grads[0]))
+#define N_SIZES (sizeof(sizes) / sizeof(sizes[0]))
+#define N_KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+
+gint main(gint argc, gchar **argv)
+{
+    Display *d;
+    RrInstance *inst;
+    RrAppearance *a;
+    RrPixel32 *expect;
+    RrCpuFeatures have;
+    GTimer *timer;
+    guint g, s, k;
+    gint i, n;
+    gboolean ok = TRUE;
+
+    n = argc > 1 ? atoi(argv[1]) : 100;
+
+    d = XOpenDisplay(NULL);
+    if (d == NULL) {
+        fprintf(stderr, "couldn't connect to X server\n");
+        return 0;
+    }
+    inst = RrInstanceNew(d, DefaultScreen(d));
+
+    a = RrAppearanceNew(inst, 0);
+    a->surface.primary = RrColorNew(inst, 0x28, 0x4e, 0x8c);
+    a->surface.secondary = RrColorNew(inst, 0xd6, 0xa2, 0x31);
+    a->surface.split_primary = RrColorNew(inst, 0x10, 0x20, 0x40);
+    a->surface.split_secondary = RrColorNew(inst, 0xf0, 0xe0, 0xc0);
+    a->surface.relief = RR_RELIEF_FLAT;
+
+    have = RrCpuGetFeatures();
+    timer = g_timer_new();
+
+    for (s = 0; s < N_SIZES; ++s) {
+        gint w = sizes[s].w, h = sizes[s].h;
+
+        a->surface.pixel_data = g_new(RrPixel32, w * h);
+        expect = g_new(RrPixel32, w * h);
+
+        printf("%s (%dx%d)\n", sizes[s].name, w, h);
+        for (g = 0; g < N_GRADS; ++g) {
+            a->surface.grad = grads[g].grad;
+            printf("  %-18s", grads[g].name);
+
+            for (k = 0; k < N_KERNELS; ++k) {
+                if ((kernels[k].features & have) != kernels[k].features)
+                    continue;
+                RrCpuLimitFeatures(kernels[k].features);
+
+                g_timer_start(timer);
+                for (i = 0; i < n; ++i)
+                    RrRender(a, w, h);
+                g_timer_stop(timer);
+
+                printf(" %s %8.3f ms", kernels[k].name,
+                       g_timer_elapsed(timer, NULL) * 1000.0 / n);
+
+                if (k == 0)
+                    memcpy(expect, a->surface.pixel_data,
+                           w * h * sizeof(RrPixel32));
+                else if (memcmp(expect, a->surface.pixel_data,
+                                w * h * sizeof(RrPixel32)))
+                {
+                    printf(" (DIFFERENT)");
+                    ok = FALSE;
+                }
+            }
+            printf("\n");
+        }
+
+        g_free(expect);
+        g_free(a->surface.pixel_data);
+        a->surface.pixel_data = NULL;
+    }
+
+    g_timer_destroy(timer);
+    RrAppearanceFree(a);
+    RrInstanceFree(inst);
+    XCloseDisplay(d);
+
+    return ok ? 0 : 1;
+}
@@ -21,6 +21,8 @@
 #include "image.h"
 #include "color.h"
 #include "imagecache.h"
+#include "scale.h"
+#include "cpu.h"
 #ifdef USE_IMLIB2
 #include <Imlib2.h>
 #endif
@@ -31,8 +33,6 @@
 
 #include <glib.h>
 
-#define FRACTION        12
-#define FLOOR(i)        ((i) & (~0UL << FRACTION))
 #define AVERAGE(a, b)   (((((a) ^ (b)) & 0xfefefefeL) >> 1) + ((a) & (b)))
 
 /************************************************************************
@@ -66,17 +66,18 @@ static void RrImagePicInit(RrImagePic *pic, gint w, gint h, RrPixel32 *data)
 }
 
 /*! Create a new RrImagePic from some picture data.
-  This makes a duplicate of the data.
+  This takes ownership of the data, which should come from Premultiply().
 */
 static RrImagePic* RrImagePicNew(gint w, gint h, RrPixel32 *data)
 {
     RrImagePic *pic;
 
     pic = g_slice_new(RrImagePic);
-    RrImagePicInit(pic, w, h, g_memdup(data, w*h*sizeof(RrPixel32)));
+    RrImagePicInit(pic, w, h, data);
     return pic;
 }
 
+static RrPixel32* Premultiply(const RrPixel32 *data, gint n);
 
 /*! Destroy an RrImagePic.
   This frees the RrImagePic object and everything inside it.
@@ -421,12 +422,14 @@ void RrImageAddFromData(RrImage *self, RrPixel32 *data, gint w, gint h)
     g_return_if_fail(data != NULL);
     g_return_if_fail(w > 0 && h > 0);
 
-    RrImagePicInit(&pic, w, h, data);
+    RrImagePicInit(&pic, w, h, Premultiply(data, w*h));
     set = g_hash_table_lookup(self->set->cache->pic_table, &pic);
-    if (set)
+    if (set) {
         self->set = RrImageSetMergeSets(self->set, set);
+        g_free(pic.data);
+    }
     else {
-        ppic = RrImagePicNew(w, h, data);
+        ppic = RrImagePicNew(w, h, pic.data);
         RrImageSetAddPicture(self->set, ppic, TRUE);
     }
 }
@@ -444,11 +447,12 @@ RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
 
     /* finds a picture in the cache, if it is already in there, and use the
        RrImageSet the picture lives in. */
-    RrImagePicInit(&pic, w, h, data);
+    RrImagePicInit(&pic, w, h, Premultiply(data, w*h));
     set = g_hash_table_lookup(cache->pic_table, &pic);
     if (set) {
         self = set->images->data; /* just grab any RrImage from the list */
         RrImageRef(self);
+        g_free(pic.data);
         return self;
     }
 
@@ -462,7 +466,7 @@ RrImage* RrImageNewFromData(RrImageCache *cache, RrPixel32 *data,
     self->set->cache = cache;
     self->set->images = g_slist_append(self->set->images, self);
 
-    ppic = RrImagePicNew(w, h, data);
+    ppic = RrImagePicNew(w, h, pic.data);
     RrImageSetAddPicture(self->set, ppic, TRUE);
 
     return self;
@@ -699,18 +703,16 @@ RrImage* RrImageNewFromName(RrImageCache *cache, const gchar *name)
   requested size (but keep its aspect ratio).  If the image does not need to
   be resized (it is already the right size) then this returns NULL.  Otherwise
   it returns a newly allocated RrImagePic with the resized picture inside it
+  @param filter How to make the picture smaller, see RrScale().
   @return Returns a newly allocated RrImagePic object with a new version of the
     image in the requested size (keeping aspect ratio).
 */
 static RrImagePic* ResizeImage(RrPixel32 *src,
                                gulong srcW, gulong srcH,
-                               gulong dstW, gulong dstH)
+                               gulong dstW, gulong dstH,
+                               RrScaleFilter filter)
 {
-    RrPixel32 *dst, *dststart;
     RrImagePic *pic;
-    gulong dstX, dstY, srcX, srcY;
-    gulong srcX1, srcX2, srcY1, srcY2;
-    gulong ratioX, ratioY;
     gulong aspectW, aspectH;
 
     g_assert(srcW > 0);
@@ -731,154 +733,300 @@ static RrImagePic* ResizeImage(RrPixel32 *src,
     if (srcW == dstW && srcH == dstH)
         return NULL; /* no scaling needed! */
 
-    dststart = dst = g_new(RrPixel32, dstW * dstH);
-
-    ratioX = (srcW << FRACTION) / dstW;
-    ratioY = (srcH << FRACTION) / dstH;
-
-    srcY2 = 0;
-    for (dstY = 0; dstY < dstH; dstY++) {
-        srcY1 = srcY2;
-        srcY2 += ratioY;
-
-        srcX2 = 0;
-        for (dstX = 0; dstX < dstW; dstX++) {
-            gulong red = 0, green = 0, blue = 0, alpha = 0;
-            gulong portionX, portionY, portionXY, sumXY = 0;
-            RrPixel32 pixel;
-
-            srcX1 = srcX2;
-            srcX2 += ratioX;
-
-            for (srcY = srcY1; srcY < srcY2; srcY += (1UL << FRACTION)) {
-                if (srcY == srcY1) {
-                    srcY = FLOOR(srcY);
-                    portionY = (1UL << FRACTION) - (srcY1 - srcY);
-                    if (portionY > srcY2 - srcY1)
-                        portionY = srcY2 - srcY1;
-                }
-                else if (srcY == FLOOR(srcY2))
-                    portionY = srcY2 - srcY;
-                else
-                    portionY = (1UL << FRACTION);
-
-                for (srcX = srcX1; srcX < srcX2; srcX += (1UL << FRACTION)) {
-                    if (srcX == srcX1) {
-                        srcX = FLOOR(srcX);
-                        portionX = (1UL << FRACTION) - (srcX1 - srcX);
-                        if (portionX > srcX2 - srcX1)
-                            portionX = srcX2 - srcX1;
-                    }
-                    else if (srcX == FLOOR(srcX2))
-                        portionX = srcX2 - srcX;
-                    else
-                        portionX = (1UL << FRACTION);
-
-                    portionXY = (portionX * portionY) >> FRACTION;
-                    sumXY += portionXY;
-
-                    pixel = *(src + (srcY >> FRACTION) * srcW
-                            + (srcX >> FRACTION));
-                    red   += ((pixel >> RrDefaultRedOffset)   & 0xFF)
-                             * portionXY;
-                    green += ((pixel >> RrDefaultGreenOffset) & 0xFF)
-                             * portionXY;
-                    blue  += ((pixel >> RrDefaultBlueOffset)  & 0xFF)
-                             * portionXY;
-                    alpha += ((pixel >> RrDefaultAlphaOffset) & 0xFF)
-                             * portionXY;
-                }
-            }
+    pic = g_slice_new(RrImagePic);
+    RrImagePicInit(pic, dstW, dstH,
+                   RrScale(src, srcW, srcH, dstW, dstH, filter));
+
+    return pic;
+}
+
+/*! Blends @n premultiplied pixels from @source over @dest, with the
+  source's alpha multiplied by @alpha as well */
+typedef void (*BlendFunc)(RrPixel32 *dest, const RrPixel32 *source, gint n,
+                          guint alpha);
 
-            g_assert(sumXY != 0);
-            red   /= sumXY;
-            green /= sumXY;
-            blue  /= sumXY;
-            alpha /= sumXY;
+/*! Divides both 16 bit halves of @x by 255, rounded */
+static inline guint32 div255_pair(guint32 x)
+{
+    x += 0x00800080;
+    return ((x + ((x >> 8) & 0x00ff00ff)) >> 8) & 0x00ff00ff;
+}
 
-            *dst++ = (red   << RrDefaultRedOffset)   |
-                     (green << RrDefaultGreenOffset) |
-                     (blue  << RrDefaultBlueOffset)  |
-                     (alpha << RrDefaultAlphaOffset);
+/*! Makes any half of @x that went past 255 into 255 */
+static inline guint32 clamp_pair(guint32 x)
+{
+    return (x | (((x >> 8) & 0x00010001) * 0xff)) & 0x00ff00ff;
+}
+
+static void blend_scalar(RrPixel32 *dest, const RrPixel32 *source, gint n,
+                         guint alpha)
+{
+    guint32 rb, ag, a;
+
+    /* the colors are done two at a time, in the halves of a 32 bit number,
+       red with blue, and alpha with green */
+    for (; n > 0; --n, ++dest, ++source) {
+        rb = *source & 0x00ff00ff;
+        ag = (*source >> 8) & 0x00ff00ff;
+        if (alpha != 0xff) {
+            rb = div255_pair(rb * alpha);
+            ag = div255_pair(ag * alpha);
         }
+        a = 0xff - (ag >> 16);
+        rb += div255_pair((*dest & 0x00ff00ff) * a);
+        ag += div255_pair(((*dest >> 8) & 0x00ff00ff) * a);
+        /* pictures which were scaled can have colors a bit over their
+           alpha */
+        *dest = clamp_pair(rb) | ((clamp_pair(ag) & 0xff) << 8);
     }
+}
 
-    pic = g_slice_new(RrImagePic);
-    RrImagePicInit(pic, dstW, dstH, dststart);
+/*! Copies @n pixels from @source to @dest with each color multiplied by the
+  pixel's alpha */
+typedef void (*PremultiplyFunc)(RrPixel32 *dest, const RrPixel32 *source,
+                                gint n);
 
-    return pic;
+static void premultiply_scalar(RrPixel32 *dest, const RrPixel32 *source,
+                               gint n)
+{
+    guint32 a;
+
+    for (; n > 0; --n, ++dest, ++source) {
+        a = *source >> RrDefaultAlphaOffset;
+        if (a == 0xff)
+            *dest = *source;
+        else
+            /* red with blue, and green on its own, in the halves of a 32
+               bit number */
+            *dest = (a << RrDefaultAlphaOffset) |
+                div255_pair((*source & 0x00ff00ff) * a) |
+                ((div255_pair(((*source >> 8) & 0xff) * a)) << 8);
+    }
+}
+
+#ifdef USE_SIMD
+
+#include <immintrin.h>
+
+/* The vector code works on the bytes of each pixel in the order they are in
+   memory, so the alpha is the 4th one, on x86.  The colors are 16 bits each
+   while they are blended, and the 4th one of each pixel is copied into the
+   others to multiply the colors by the alpha. */
+#define BLEND_ALPHA(x) \
+    _mm_shufflehi_epi16(_mm_shufflelo_epi16(x, 0xff), 0xff)
+#define BLEND_ALPHA256(x) \
+    _mm256_shufflehi_epi16(_mm256_shufflelo_epi16(x, 0xff), 0xff)
+
+__attribute__((target("sse2")))
+static inline __m128i div255_sse2(__m128i x)
+{
+    return _mm_mulhi_epu16(_mm_add_epi16(x, _mm_set1_epi16(128)),
+                           _mm_set1_epi16(257));
+}
+
+__attribute__((target("sse2")))
+static inline __m128i blend_half_sse2(__m128i s, __m128i d, __m128i alpha,
+                                      gboolean opaque)
+{
+    if (!opaque)
+        s = div255_sse2(_mm_mullo_epi16(s, alpha));
+    d = _mm_mullo_epi16(d, _mm_sub_epi16(_mm_set1_epi16(0xff),
+                                         BLEND_ALPHA(s)));
+    return _mm_add_epi16(s, div255_sse2(d));
+}
+
+__attribute__((target("sse2")))
+static void blend_sse2(RrPixel32 *dest, const RrPixel32 *source, gint n,
+                       guint alpha)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i mask = _mm_set1_epi32(~(0xff << RrDefaultAlphaOffset));
+    const __m128i a = _mm_set1_epi16(alpha);
+    const gboolean opaque = alpha == 0xff;
+    __m128i s, d, lo, hi;
+
+    for (; n >= 4; n -= 4, dest += 4, source += 4) {
+        s = _mm_loadu_si128((const __m128i*)source);
+        d = _mm_loadu_si128((const __m128i*)dest);
+        lo = blend_half_sse2(_mm_unpacklo_epi8(s, zero),
+                             _mm_unpacklo_epi8(d, zero), a, opaque);
+        hi = blend_half_sse2(_mm_unpackhi_epi8(s, zero),
+                             _mm_unpackhi_epi8(d, zero), a, opaque);
+        /* packus clamps colors that went over */
+        _mm_storeu_si128((__m128i*)dest,
+                         _mm_and_si128(_mm_packus_epi16(lo, hi), mask));
+    }
+    blend_scalar(dest, source, n, alpha);
+}
+
+__attribute__((target("avx2")))
+static inline __m256i div255_avx2(__m256i x)
+{
+    return _mm256_mulhi_epu16(_mm256_add_epi16(x, _mm256_set1_epi16(128)),
+                              _mm256_set1_epi16(257));
+}
+
+__attribute__((target("avx2")))
+static inline __m256i blend_half_avx2(__m256i s, __m256i d, __m256i alpha,
+                                      gboolean opaque)
+{
+    if (!opaque)
+        s = div255_avx2(_mm256_mullo_epi16(s, alpha));
+    d = _mm256_mullo_epi16(d, _mm256_sub_epi16(_mm256_set1_epi16(0xff),
+                                               BLEND_ALPHA256(s)));
+    return _mm256_add_epi16(s, div255_avx2(d));
 }
 
-/*! This draws an RGBA picture into the target, within the rectangle specified
-  by the area parameter.  If the area's size differs from the source's then it
-  will be centered within the rectangle */
-void DrawRGBA(RrPixel32 *target, gint target_w, gint target_h,
-              RrPixel32 *source, gint source_w, gint source_h,
-              gint alpha, RrRect *area)
+__attribute__((target("avx2")))
+static void blend_avx2(RrPixel32 *dest, const RrPixel32 *source, gint n,
+                       guint alpha)
 {
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i mask = _mm256_set1_epi32(~(0xff << RrDefaultAlphaOffset));
+    const __m256i a = _mm256_set1_epi16(alpha);
+    const gboolean opaque = alpha == 0xff;
+    __m256i s, d, lo, hi;
+
+    /* the unpacks and the pack both work within each half, so the pixels
+       stay in order */
+    for (; n >= 8; n -= 8, dest += 8, source += 8) {
+        s = _mm256_loadu_si256((const __m256i*)source);
+        d = _mm256_loadu_si256((const __m256i*)dest);
+        lo = blend_half_avx2(_mm256_unpacklo_epi8(s, zero),
+                             _mm256_unpacklo_epi8(d, zero), a, opaque);
+        hi = blend_half_avx2(_mm256_unpackhi_epi8(s, zero),
+                             _mm256_unpackhi_epi8(d, zero), a, opaque);
+        _mm256_storeu_si256((__m256i*)dest,
+                            _mm256_and_si256(_mm256_packus_epi16(lo, hi),
+                                             mask));
+    }
+    _mm256_zeroupper();
+    blend_scalar(dest, source, n, alpha);
+}
+
+__attribute__((target("sse2")))
+static void premultiply_sse2(RrPixel32 *dest, const RrPixel32 *source,
+                             gint n)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i amask = _mm_set1_epi32(0xff << RrDefaultAlphaOffset);
+    __m128i s, lo, hi;
+
+    for (; n >= 4; n -= 4, dest += 4, source += 4) {
+        s = _mm_loadu_si128((const __m128i*)source);
+        lo = _mm_unpacklo_epi8(s, zero);
+        hi = _mm_unpackhi_epi8(s, zero);
+        lo = div255_sse2(_mm_mullo_epi16(lo, BLEND_ALPHA(lo)));
+        hi = div255_sse2(_mm_mullo_epi16(hi, BLEND_ALPHA(hi)));
+        /* the alpha was multiplied by itself, so put it back */
+        _mm_storeu_si128((__m128i*)dest,
+                         _mm_or_si128(_mm_andnot_si128(amask,
+                                                       _mm_packus_epi16(lo,
+                                                                        hi)),
+                                      _mm_and_si128(s, amask)));
+    }
+    premultiply_scalar(dest, source, n);
+}
+
+__attribute__((target("avx2")))
+static void premultiply_avx2(RrPixel32 *dest, const RrPixel32 *source,
+                             gint n)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i amask = _mm256_set1_epi32(0xff << RrDefaultAlphaOffset);
+    __m256i s, lo, hi, p;
+
+    for (; n >= 8; n -= 8, dest += 8, source += 8) {
+        s = _mm256_loadu_si256((const __m256i*)source);
+        lo = _mm256_unpacklo_epi8(s, zero);
+        hi = _mm256_unpackhi_epi8(s, zero);
+        lo = div255_avx2(_mm256_mullo_epi16(lo, BLEND_ALPHA256(lo)));
+        hi = div255_avx2(_mm256_mullo_epi16(hi, BLEND_ALPHA256(hi)));
+        p = _mm256_andnot_si256(amask, _mm256_packus_epi16(lo, hi));
+        _mm256_storeu_si256((__m256i*)dest,
+                            _mm256_or_si256(p, _mm256_and_si256(s, amask)));
+    }
+    _mm256_zeroupper();
+    premultiply_scalar(dest, source, n);
+}
+
+#endif
+
+static BlendFunc pick_blend(void)
+{
+#ifdef USE_SIMD
+    RrCpuFeatures f = RrCpuGetFeatures();
+
+    if (f & RR_CPU_AVX2)
+        return blend_avx2;
+    if (f & RR_CPU_SSE2)
+        return blend_sse2;
+#endif
+    return blend_scalar;
+}
+
+static PremultiplyFunc pick_premultiply(void)
+{
+#ifdef USE_SIMD
+    RrCpuFeatures f = RrCpuGetFeatures();
+
+    if (f & RR_CPU_AVX2)
+        return premultiply_avx2;
+    if (f & RR_CPU_SSE2)
+        return premultiply_sse2;
+#endif
+    return premultiply_scalar;
+}
+
+/*! Returns a copy of some picture data with each color multiplied by the
+  pixel's alpha, which is how RrImagePics keep their pictures.  Then drawing
+  them only has to blend the background in. */
+static RrPixel32* Premultiply(const RrPixel32 *data, gint n)
+{
+    RrPixel32 *out;
+
+    out = g_new(RrPixel32, n);
+    pick_premultiply()(out, data, n);
+    return out;
+}
+
+/*! This draws a premultiplied picture into the target, centered within the
+  rectangle specified by the area parameter.  The picture must already fit
+  in the area, which ResizeImage() makes sure of */
+static void DrawRGBA(RrPixel32 *target, gint target_w, gint target_h,
+                     RrPixel32 *source, gint source_w, gint source_h,
+                     gint alpha, RrRect *area)
+{
+    BlendFunc blend;
     RrPixel32 *dest;
-    gint col, num_pixels;
-    gint dw, dh;
+    gint y;
 
     g_assert(source_w <= area->width && source_h <= area->height);
     g_assert(area->x + area->width <= target_w);
     g_assert(area->y + area->height <= target_h);
 
-    /* keep the aspect ratio */
-    dw = area->width;
-    dh = (gint)(dw * ((gdouble)source_h / source_w));
-    if (dh > area->height) {
-        dh = area->height;
-        dw = (gint)(dh * ((gdouble)source_w / source_h));
-    }
-
-    /* copy source -> dest, and apply the alpha channel.
-       center the image if it is smaller than the area */
-    col = 0;
-    num_pixels = dw * dh;
-    dest = target + area->x + (area->width - dw) / 2 +
-        (target_w * (area->y + (area->height - dh) / 2));
-    while (num_pixels-- > 0) {
-        guchar a, r, g, b, bgr, bgg, bgb;
-
-        /* apply the rgba's opacity as well */
-        a = ((*source >> RrDefaultAlphaOffset) * alpha) >> 8;
-        r = *source >> RrDefaultRedOffset;
-        g = *source >> RrDefaultGreenOffset;
-        b = *source >> RrDefaultBlueOffset;
-
-        /* background color */
-        bgr = *dest >> RrDefaultRedOffset;
-        bgg = *dest >> RrDefaultGreenOffset;
-        bgb = *dest >> RrDefaultBlueOffset;
-
-        r = bgr + (((r - bgr) * a) >> 8);
-        g = bgg + (((g - bgg) * a) >> 8);
-        b = bgb + (((b - bgb) * a) >> 8);
-
-        *dest = ((r << RrDefaultRedOffset) |
-                 (g << RrDefaultGreenOffset) |
-                 (b << RrDefaultBlueOffset));
-
-        dest++;
-        source++;
-
-        if (++col >= dw) {
-            col = 0;
-            dest += target_w - dw;
-        }
+    blend = pick_blend();
+    dest = target + area->x + (area->width - source_w) / 2 +
+        (target_w * (area->y + (area->height - source_h) / 2));
+    for (y = 0; y < source_h; ++y) {
+        blend(dest, source, source_w, alpha);
+        dest += target_w;
+        source += source_w;
     }
 }
 
 /*! Draw an RGBA texture into a target pixel buffer. */
 void RrImageDrawRGBA(RrPixel32 *target, RrTextureRGBA *rgba,
                      gint target_w, gint target_h,
-                     RrRect *area)
+                     RrRect *area, RrScaleFilter filter)
 {
     RrImagePic *scaled;
+    RrPixel32 *data;
 
-    scaled = ResizeImage(rgba->data, rgba->width, rgba->height,
-                         area->width, area->height);
+    /* these aren't kept around, so they are premultiplied each time */
+    data = Premultiply(rgba->data, rgba->width * rgba->height);
+    scaled = ResizeImage(data, rgba->width, rgba->height,
+                         area->width, area->height, filter);
 
     if (scaled) {
 #ifdef DEBUG
@@ -892,8 +1040,9 @@ void RrImageDrawRGBA(RrPixel32 *target, RrTextureRGBA *rgba,
     }
     else
         DrawRGBA(target, target_w, target_h,
-                 rgba->data, rgba->width, rgba->height,
+                 data, rgba->width, rgba->height,
                  rgba->alpha, area);
+    g_free(data);
 }
 
 /*! Draw an RrImage texture into a target pixel buffer.  If the RrImage does
@@ -903,7 +1052,7 @@ void RrImageDrawRGBA(RrPixel32 *target, RrTextureRGBA *rgba,
  */
 void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
                       gint target_w, gint target_h,
-                      RrRect *area)
+                      RrRect *area, RrScaleFilter filter)
 {
     gint i, min_diff, min_i, min_aspect_diff, min_aspect_i;
     RrImage *self;
@@ -993,11 +1142,30 @@ void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
         if (min_aspect_i >= 0)
             min_i = min_aspect_i;
 
-        /* resize the original to the given area */
-        pic = ResizeImage(set->original[min_i]->data,
-                          set->original[min_i]->width,
-                          set->original[min_i]->height,
-                          area->width, area->height);
+        /* resize the original to the given area, unless that was done
+           before and saved on disk */
+        pic = NULL;
+        if (set->cache->disk) {
+            RrPixel32 *data;
+            gint w, h;
+
+            data = RrDiskCacheLookup(set->cache->disk, set->original[min_i],
+                                     area->width, area->height, filter,
+                                     &w, &h);
+            if (data) {
+                pic = g_slice_new(RrImagePic);
+                RrImagePicInit(pic, w, h, data);
+            }
+        }
+        if (!pic) {
+            pic = ResizeImage(set->original[min_i]->data,
+                              set->original[min_i]->width,
+                              set->original[min_i]->height,
+                              area->width, area->height, filter);
+            if (set->cache->disk)
+                RrDiskCacheAdd(set->cache->disk, set->original[min_i],
+                               area->width, area->height, filter, pic);
+        }
 
         /* is it already in the cache ? */
         cache_set = g_hash_table_lookup(set->cache->pic_table, pic);
@@ -24,9 +24,9 @@
 
 void RrImageDrawImage(RrPixel32 *target, RrTextureImage *img,
                       gint target_w, gint target_h,
-                      RrRect *area);
+                      RrRect *area, RrScaleFilter filter);
 void RrImageDrawRGBA(RrPixel32 *target, RrTextureRGBA *rgba,
                      gint target_w, gint target_h,
-                     RrRect *area);
+                     RrRect *area, RrScaleFilter filter);
 
 #endif
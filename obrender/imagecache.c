@@ -35,6 +35,7 @@ RrImageCache* RrImageCacheNew(gint max_resized_saved)
     self->pic_table = g_hash_table_new((GHashFunc)RrImagePicHash,
                                        (GEqualFunc)RrImagePicEqual);
     self->name_table = g_hash_table_new(g_str_hash, g_str_equal);
+    self->disk = NULL;
     return self;
 }
 
@@ -43,6 +44,17 @@ void RrImageCacheRef(RrImageCache *self)
     ++self->ref;
 }
 
+void RrImageCacheSetDiskCache(RrImageCache *self, const gchar *dir,
+                              gulong max_bytes)
+{
+    /* opening it reads the whole directory, so keep it if it's the same */
+    if (self->disk && max_bytes && RrDiskCacheIs(self->disk, dir, max_bytes))
+        return;
+
+    RrDiskCacheFree(self->disk);
+    self->disk = max_bytes ? RrDiskCacheNew(dir, max_bytes) : NULL;
+}
+
 void RrImageCacheUnref(RrImageCache *self)
 {
     if (self && --self->ref == 0) {
@@ -54,6 +66,8 @@ void RrImageCacheUnref(RrImageCache *self)
         g_hash_table_destroy(self->name_table);
         self->name_table = NULL;
 
+        RrDiskCacheFree(self->disk);
+
         g_slice_free(RrImageCache, self);
     }
 }
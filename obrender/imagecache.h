@@ -19,6 +19,8 @@
 #ifndef __imagecache_h
 #define __imagecache_h
 
+#include "diskcache.h"
+
 #include <glib.h>
 
 struct _RrImagePic;
@@ -53,6 +55,10 @@ struct _RrImageCache {
     /*! Used to find out if an image file has already been loaded into an
       image set. Provides a quick file_name -> RrImageSet lookup. */
     GHashTable *name_table;
+
+    /*! Resized pictures are saved here as well, so they can be used again
+      after a restart.  NULL if pictures aren't saved on disk. */
+    RrDiskCache *disk;
 };
 
 #endif
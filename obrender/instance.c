@@ -20,10 +20,29 @@
 #include "render.h"
 #include "instance.h"
 
+/* the number of unused pixmaps of each size to keep in the pool */
+#define POOL_PER_SIZE 4
+/* the default amount of memory for the render cache's pixmaps */
+#define RENDER_CACHE_SIZE (4 * 1024 * 1024)
+
+typedef struct _RrPixmapKey {
+    gint w, h, depth;
+} RrPixmapKey;
+
+/*! The unused pixmaps of one size */
+typedef struct _RrPixmapSize {
+    RrPixmapKey key;
+    GSList *pixmaps;
+    guint n;
+} RrPixmapSize;
+
 static RrInstance *definst = NULL;
+static gulong pixmaps_made = 0, pixmaps_reused = 0;
 
 static void RrTrueColorSetup (RrInstance *inst);
 static void RrPseudoColorSetup (RrInstance *inst);
+static guint pixmap_key_hash(gconstpointer p);
+static gboolean pixmap_key_equal(gconstpointer p1, gconstpointer p2);
 
 #ifdef DEBUG
 #include "color.h"
@@ -70,6 +89,10 @@ RrInstance* RrInstanceNew (Display *display, gint screen)
 
     definst->color_hash = g_hash_table_new_full(g_int_hash, g_int_equal,
                                                 NULL, dest);
+    definst->pixmap_pool = g_hash_table_new(pixmap_key_hash,
+                                            pixmap_key_equal);
+    definst->painted = g_hash_table_new(g_direct_hash, g_direct_equal);
+    definst->render_cache = RrRenderCacheNew(RENDER_CACHE_SIZE);
 
     switch (definst->visual->class) {
     case TrueColor:
@@ -86,6 +109,10 @@ RrInstance* RrInstanceNew (Display *display, gint screen)
         g_free (definst);
         return definst = NULL;
     }
+
+    definst->shm = RrShmPoolNew(display);
+    definst->dither = FALSE;
+    definst->image_filter = RR_SCALE_BOX;
     return definst;
 }
 
@@ -205,12 +232,97 @@ static void RrPseudoColorSetup (RrInstance *inst)
     }
 }
 
+static guint pixmap_key_hash(gconstpointer p)
+{
+    const RrPixmapKey *k = p;
+    return (k->w << 16) ^ k->h ^ (k->depth << 8);
+}
+
+static gboolean pixmap_key_equal(gconstpointer p1, gconstpointer p2)
+{
+    const RrPixmapKey *k1 = p1, *k2 = p2;
+    return k1->w == k2->w && k1->h == k2->h && k1->depth == k2->depth;
+}
+
+static gboolean pool_free(gpointer key, gpointer value, gpointer data)
+{
+    RrPixmapSize *ps = value;
+    RrInstance *inst = data;
+    GSList *it;
+
+    for (it = ps->pixmaps; it; it = g_slist_next(it))
+        XFreePixmap(inst->display, (Pixmap)GPOINTER_TO_SIZE(it->data));
+    g_slist_free(ps->pixmaps);
+    g_slice_free(RrPixmapSize, ps);
+    return TRUE;
+}
+
+Pixmap RrPixmapPoolGet(const RrInstance *inst, gint w, gint h)
+{
+    RrPixmapKey k;
+    RrPixmapSize *ps;
+    Pixmap p;
+
+    k.w = w;
+    k.h = h;
+    k.depth = RrDepth(inst);
+    ps = g_hash_table_lookup(RrPixmapPool(inst), &k);
+    if (ps && ps->pixmaps) {
+        p = (Pixmap)GPOINTER_TO_SIZE(ps->pixmaps->data);
+        ps->pixmaps = g_slist_delete_link(ps->pixmaps, ps->pixmaps);
+        --ps->n;
+        ++pixmaps_reused;
+        return p;
+    }
+
+    ++pixmaps_made;
+    p = XCreatePixmap(RrDisplay(inst), RrRootWindow(inst), w, h,
+                      RrDepth(inst));
+    g_assert(p != None);
+    return p;
+}
+
+void RrPixmapPoolStats(gulong *made, gulong *reused)
+{
+    *made = pixmaps_made;
+    *reused = pixmaps_reused;
+}
+
+void RrPixmapPoolPut(const RrInstance *inst, Pixmap p, gint w, gint h)
+{
+    RrPixmapKey k;
+    RrPixmapSize *ps;
+
+    k.w = w;
+    k.h = h;
+    k.depth = RrDepth(inst);
+    if (!(ps = g_hash_table_lookup(RrPixmapPool(inst), &k))) {
+        ps = g_slice_new(RrPixmapSize);
+        ps->key = k;
+        ps->pixmaps = NULL;
+        ps->n = 0;
+        g_hash_table_insert(RrPixmapPool(inst), &ps->key, ps);
+    }
+
+    if (ps->n < POOL_PER_SIZE) {
+        ps->pixmaps = g_slist_prepend(ps->pixmaps, GSIZE_TO_POINTER(p));
+        ++ps->n;
+    }
+    else
+        XFreePixmap(RrDisplay(inst), p);
+}
+
 void RrInstanceFree (RrInstance *inst)
 {
     if (inst) {
         if (inst == definst) definst = NULL;
         g_free(inst->pseudo_colors);
         g_hash_table_destroy(inst->color_hash);
+        RrShmPoolFree(inst->shm, inst->display);
+        RrRenderCacheFree(inst->render_cache, inst->display);
+        g_hash_table_foreach_remove(inst->pixmap_pool, pool_free, inst);
+        g_hash_table_destroy(inst->pixmap_pool);
+        g_hash_table_destroy(inst->painted);
         g_object_unref(inst->pango);
         g_slice_free(RrInstance, inst);
     }
@@ -305,3 +417,48 @@ GHashTable* RrColorHash (const RrInstance *inst)
 {
     return (inst ? inst : definst)->color_hash;
 }
+
+RrShmPool* RrShm (const RrInstance *inst)
+{
+    return (inst ? inst : definst)->shm;
+}
+
+GHashTable* RrPixmapPool (const RrInstance *inst)
+{
+    return (inst ? inst : definst)->pixmap_pool;
+}
+
+GHashTable* RrPaintedWindows (const RrInstance *inst)
+{
+    return (inst ? inst : definst)->painted;
+}
+
+RrRenderCache* RrRenderCacheFor (const RrInstance *inst)
+{
+    return (inst ? inst : definst)->render_cache;
+}
+
+void RrSetRenderCacheSize (const RrInstance *inst, gulong bytes)
+{
+    RrRenderCacheSetSize(RrRenderCacheFor(inst), RrDisplay(inst), bytes);
+}
+
+gboolean RrDither (const RrInstance *inst)
+{
+    return (inst ? inst : definst)->dither;
+}
+
+void RrSetDither (RrInstance *inst, gboolean dither)
+{
+    (inst ? inst : definst)->dither = dither;
+}
+
+RrScaleFilter RrImageFilter (const RrInstance *inst)
+{
+    return (inst ? inst : definst)->image_filter;
+}
+
+void RrSetImageFilter (RrInstance *inst, RrScaleFilter filter)
+{
+    (inst ? inst : definst)->image_filter = filter;
+}
@@ -23,6 +23,9 @@
 #include <glib.h>
 #include <pango/pangoxft.h>
 
+#include "shm.h"
+#include "rendercache.h"
+
 struct _RrInstance {
     Display *display;
     gint screen;
@@ -48,10 +51,28 @@ struct _RrInstance {
     XColor *pseudo_colors;
 
     GHashTable *color_hash;
+
+    RrShmPool *shm; /* NULL when the X server can't share memory with us */
+    gboolean dither; /* dither colors which lose bits on the screen */
+    RrScaleFilter image_filter; /* for making images smaller */
+
+    GHashTable *pixmap_pool; /* unused pixmaps, by size */
+    GHashTable *painted; /* the pixmaps RrPaint kept for each window */
+    RrRenderCache *render_cache;
 };
 
 guint       RrPseudoBPC    (const RrInstance *inst);
 XColor*     RrPseudoColors (const RrInstance *inst);
 GHashTable* RrColorHash    (const RrInstance *inst);
+RrShmPool*  RrShm          (const RrInstance *inst);
+GHashTable* RrPixmapPool   (const RrInstance *inst);
+GHashTable* RrPaintedWindows(const RrInstance *inst);
+RrRenderCache* RrRenderCacheFor(const RrInstance *inst);
+
+/*! Returns a pixmap of the given size from the pool, or makes a new one */
+Pixmap RrPixmapPoolGet(const RrInstance *inst, gint w, gint h);
+/*! Gives a pixmap which is not used anywhere anymore to the pool, or frees it
+  if the pool has enough of that size already */
+void   RrPixmapPoolPut(const RrInstance *inst, Pixmap p, gint w, gint h);
 
 #endif
@@ -0,0 +1,136 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   paintbench.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Measures how fast RrPaint() repaints titlebars with one appearance, like
+   the unfocused title shared by every frame, and checks that once each
+   window has been painted, repainting them, resizing them back and forth and
+   replacing a few of them makes no new pixmaps in the X server. */
+
+#include "render.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <glib.h>
+#include <X11/Xlib.h>
+
+#define N_WINDOWS 32
+/* no more than the pool keeps of each size */
+#define N_REPLACED 4
+#define W 600
+#define H 20
+
+static gboolean check(const gchar *name, gulong before)
+{
+    gulong made, reused;
+
+    RrPixmapPoolStats(&made, &reused);
+    if (made != before) {
+        printf("  %s made %lu pixmaps (WRONG)\n", name, made - before);
+        return FALSE;
+    }
+    return TRUE;
+}
+
+gint main(gint argc, gchar **argv)
+{
+    Display *d;
+    RrInstance *inst;
+    RrAppearance *a;
+    Window wins[N_WINDOWS];
+    GTimer *timer;
+    gulong made, reused;
+    gint i, j, n;
+    gboolean ok = TRUE;
+
+    n = argc > 1 ? atoi(argv[1]) : 100;
+
+    d = XOpenDisplay(NULL);
+    if (d == NULL) {
+        fprintf(stderr, "couldn't connect to X server\n");
+        return 0;
+    }
+    inst = RrInstanceNew(d, DefaultScreen(d));
+    /* paint every time, rather than sharing what was painted */
+    RrSetRenderCacheSize(inst, 0);
+
+    a = RrAppearanceNew(inst, 0);
+    a->surface.grad = RR_SURFACE_VERTICAL;
+    a->surface.primary = RrColorNew(inst, 0x28, 0x4e, 0x8c);
+    a->surface.secondary = RrColorNew(inst, 0xd6, 0xa2, 0x31);
+    a->surface.relief = RR_RELIEF_RAISED;
+    a->surface.bevel = RR_BEVEL_1;
+
+    for (i = 0; i < N_WINDOWS; ++i) {
+        wins[i] = XCreateSimpleWindow(d, DefaultRootWindow(d),
+                                      0, 0, W, H, 0, 0, 0);
+        RrPaint(a, wins[i], W, H);
+    }
+    /* and one of each size for resizing to go back and forth between */
+    RrPaint(a, wins[0], W / 2, H);
+    RrPaint(a, wins[0], W, H);
+    XSync(d, FALSE);
+
+    RrPixmapPoolStats(&made, &reused);
+    printf("%d windows (%dx%d), after painting each once: %lu pixmaps\n",
+           N_WINDOWS, W, H, made);
+
+    timer = g_timer_new();
+    for (i = 0; i < n; ++i)
+        for (j = 0; j < N_WINDOWS; ++j)
+            RrPaint(a, wins[j], W, H);
+    XSync(d, FALSE);
+    g_timer_stop(timer);
+    printf("  repaint %8.3f ms\n",
+           g_timer_elapsed(timer, NULL) * 1000.0 / n / N_WINDOWS);
+    ok = check("repainting", made) && ok;
+
+    g_timer_start(timer);
+    for (i = 0; i < n; ++i) {
+        RrPaint(a, wins[0], W / 2, H);
+        RrPaint(a, wins[0], W, H);
+    }
+    XSync(d, FALSE);
+    g_timer_stop(timer);
+    printf("  resize  %8.3f ms\n",
+           g_timer_elapsed(timer, NULL) * 1000.0 / n / 2);
+    ok = check("resizing", made) && ok;
+
+    g_timer_start(timer);
+    for (i = 0; i < n; ++i)
+        for (j = 0; j < N_REPLACED; ++j) {
+            XDestroyWindow(d, wins[j]);
+            RrPaintForget(inst, wins[j]);
+            wins[j] = XCreateSimpleWindow(d, DefaultRootWindow(d),
+                                          0, 0, W, H, 0, 0, 0);
+            RrPaint(a, wins[j], W, H);
+        }
+    XSync(d, FALSE);
+    g_timer_stop(timer);
+    printf("  replace %8.3f ms\n",
+           g_timer_elapsed(timer, NULL) * 1000.0 / n / N_REPLACED);
+    ok = check("replacing windows", made) && ok;
+
+    g_timer_destroy(timer);
+    for (i = 0; i < N_WINDOWS; ++i)
+        XDestroyWindow(d, wins[i]);
+    RrAppearanceFree(a);
+    RrInstanceFree(inst);
+    XCloseDisplay(d);
+
+    return ok ? 0 : 1;
+}
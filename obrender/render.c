@@ -25,61 +25,231 @@
 #include "color.h"
 #include "image.h"
 #include "theme.h"
+#include "shm.h"
+#include "instance.h"
+#include "rendercache.h"
 
 #include <glib.h>
 #include <X11/Xlib.h>
 #include <X11/Xutil.h>
 #include <X11/Xft/Xft.h>
+#include <string.h>
 
 #ifdef HAVE_STDLIB_H
 #  include <stdlib.h>
 #endif
 
+/*! A pixmap which an appearance painted, and set as the background of a
+  window.  The pixmap is never set on any other window, so it is safe to draw
+  into it again when repainting that window.  It is kept until the window is
+  destroyed, or the appearance is freed. */
+typedef struct _RrPainted {
+    RrAppearance *a;
+    Window win;
+    Pixmap pixmap;
+    gint w, h;
+} RrPainted;
+
 static void pixel_data_to_pixmap(RrAppearance *l,
                                  gint x, gint y, gint w, gint h);
 
-Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
+#define HASH_INIT G_GUINT64_CONSTANT(14695981039346656037)
+#define HASH_PRIME G_GUINT64_CONSTANT(1099511628211)
+
+static guint64 hash_bytes(guint64 hash, gconstpointer p, gsize n)
 {
-    gint i, transferred = 0, force_transfer = 0;
-    Pixmap oldp = None;
-    RrRect tarea; /* area in which to draw textures */
-    gboolean resized;
+    const guchar *c = p;
+
+    while (n--) {
+        hash ^= *c++;
+        hash *= HASH_PRIME;
+    }
+    return hash;
+}
 
-    if (w <= 0 || h <= 0) return None;
+static void key_bytes(GByteArray *key, gconstpointer p, gsize n)
+{
+    g_byte_array_append(key, p, n);
+}
+
+static void key_int(GByteArray *key, gint i)
+{
+    key_bytes(key, &i, sizeof(i));
+}
+
+static void key_color(GByteArray *key, const RrColor *c)
+{
+    if (!c) {
+        key_int(key, -1);
+        return;
+    }
+    key_int(key, c->r);
+    key_int(key, c->g);
+    key_int(key, c->b);
+}
+
+/*! Puts everything that goes into painting the appearance at the given size
+  into a->key, and returns a hash of it, or 0 if it can't be shared through
+  the render cache.  Pixmaps in the cache are found by the hash, and then
+  their keys are compared. */
+static guint64 appearance_hash(RrAppearance *a, gint w, gint h)
+{
+    RrSurface *s = &a->surface;
+    GByteArray *key;
+    guint64 hash;
+    gchar *font;
+    gint i;
+
+    if (!RrRenderCacheEnabled(RrRenderCacheFor(a->inst)))
+        return 0;
+
+    if (!a->key)
+        a->key = g_byte_array_new();
+    key = a->key;
+    g_byte_array_set_size(key, 0);
+
+    key_int(key, w);
+    key_int(key, h);
+    key_int(key, RrDither(a->inst));
+    key_int(key, RrImageFilter(a->inst));
+    key_int(key, s->grad);
+    key_int(key, s->relief);
+    key_int(key, s->bevel);
+    key_int(key, s->interlaced);
+    key_int(key, s->border);
+    key_int(key, s->bevel_dark_adjust);
+    key_int(key, s->bevel_light_adjust);
+    key_color(key, s->primary);
+    key_color(key, s->secondary);
+    key_color(key, s->border_color);
+    key_color(key, s->bevel_dark);
+    key_color(key, s->bevel_light);
+    key_color(key, s->interlace_color);
+    key_color(key, s->split_primary);
+    key_color(key, s->split_secondary);
+    if (s->grad == RR_SURFACE_PARENTREL) {
+        /* the parent's key is of what is in its pixel data */
+        if (!s->parent->hash) return 0;
+        key_int(key, s->parent->key->len);
+        key_bytes(key, s->parent->key->data, s->parent->key->len);
+        key_int(key, s->parentx);
+        key_int(key, s->parenty);
+    }
+
+    for (i = 0; i < a->textures; i++) {
+        RrTextureData *d = &a->texture[i].data;
+
+        key_int(key, a->texture[i].type);
+        switch (a->texture[i].type) {
+        case RR_TEXTURE_NONE:
+            break;
+        case RR_TEXTURE_TEXT:
+            font = pango_font_description_to_string(d->text.font->font_desc);
+            key_bytes(key, font, strlen(font) + 1);
+            g_free(font);
+            if (d->text.string)
+                key_bytes(key, d->text.string, strlen(d->text.string) + 1);
+            else
+                key_int(key, -1);
+            key_int(key, d->text.justify);
+            key_color(key, d->text.color);
+            key_int(key, d->text.shadow_offset_x);
+            key_int(key, d->text.shadow_offset_y);
+            key_color(key, d->text.shadow_color);
+            key_int(key, d->text.shadow_alpha);
+            key_int(key, d->text.shortcut);
+            key_int(key, d->text.shortcut_pos);
+            key_int(key, d->text.ellipsize);
+            key_int(key, d->text.flow);
+            key_int(key, d->text.maxwidth);
+            break;
+        case RR_TEXTURE_LINE_ART:
+            key_color(key, d->lineart.color);
+            key_int(key, d->lineart.x1);
+            key_int(key, d->lineart.y1);
+            key_int(key, d->lineart.x2);
+            key_int(key, d->lineart.y2);
+            break;
+        case RR_TEXTURE_MASK:
+            key_color(key, d->mask.color);
+            if (d->mask.mask) {
+                key_int(key, d->mask.mask->width);
+                key_int(key, d->mask.mask->height);
+                key_bytes(key, d->mask.mask->data,
+                          (d->mask.mask->width + 7) / 8 *
+                          d->mask.mask->height);
+            }
+            break;
+        case RR_TEXTURE_RGBA:
+            key_int(key, d->rgba.width);
+            key_int(key, d->rgba.height);
+            key_int(key, d->rgba.alpha);
+            key_int(key, d->rgba.tx);
+            key_int(key, d->rgba.ty);
+            key_int(key, d->rgba.twidth);
+            key_int(key, d->rgba.theight);
+            if (d->rgba.data)
+                key_bytes(key, d->rgba.data, d->rgba.width *
+                          d->rgba.height * sizeof(RrPixel32));
+            break;
+        case RR_TEXTURE_IMAGE:
+            /* the pictures in an RrImage can change, and a new one can end up
+               at the same address as an old one */
+            return 0;
+        case RR_TEXTURE_NUM_TYPES:
+            g_assert_not_reached();
+        }
+    }
+
+    hash = hash_bytes(HASH_INIT, key->data, key->len);
+    return hash ? hash : 1;
+}
+
+static gboolean can_paint(RrAppearance *a, gint w, gint h)
+{
+    if (w <= 0 || h <= 0) return FALSE;
 
     if (a->surface.parentx < 0 || a->surface.parenty < 0) {
         /* ob_debug("Invalid parent co-ordinates\n"); */
-        return None;
+        return FALSE;
     }
 
     if (a->surface.grad == RR_SURFACE_PARENTREL &&
         (a->surface.parentx >= a->surface.parent->w ||
          a->surface.parenty >= a->surface.parent->h))
     {
-        return None;
+        return FALSE;
     }
+    return TRUE;
+}
 
-    resized = (a->w != w || a->h != h);
-
-    oldp = a->pixmap; /* save to free after changing the visible pixmap */
-    a->pixmap = XCreatePixmap(RrDisplay(a->inst),
-                              RrRootWindow(a->inst),
-                              w, h, RrDepth(a->inst));
+/*! Renders the surface and any images into the appearance's pixel data, and
+  draws the parts of a solid surface into a->pixmap if it is not None.
+  Returns TRUE if images were drawn into the pixel data. */
+static gboolean render_pixels(RrAppearance *a, gint w, gint h)
+{
+    gint i;
+    RrRect tarea; /* area in which to draw textures */
+    RrAppearance *parent = a->surface.parent;
+    gboolean images = FALSE;
 
-    g_assert(a->pixmap != None);
-    a->w = w;
-    a->h = h;
+    /* the parent was painted from the render cache, so get its pixel data
+       up to date for us to use */
+    if (a->surface.grad == RR_SURFACE_PARENTREL && parent->stale) {
+        Pixmap p = parent->pixmap;
 
-    if (a->xftdraw != NULL)
-        XftDrawDestroy(a->xftdraw);
-    a->xftdraw = XftDrawCreate(RrDisplay(a->inst), a->pixmap,
-                               RrVisual(a->inst), RrColormap(a->inst));
-    g_assert(a->xftdraw != NULL);
+        parent->pixmap = None;
+        render_pixels(parent, parent->w, parent->h);
+        parent->pixmap = p;
+    }
 
-    if (resized) {
+    if (!a->surface.pixel_data || a->w != w || a->h != h) {
         g_free(a->surface.pixel_data);
         a->surface.pixel_data = g_new(RrPixel32, w * h);
     }
+    a->w = w;
+    a->h = h;
+    a->stale = FALSE;
 
     RrRender(a, w, h);
 
@@ -89,6 +259,76 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
         RECT_SET(tarea, l, t, w - l - r, h - t - b);
     }
 
+    /* images always come before the textures which are drawn on the pixmap */
+    for (i = 0; i < a->textures; i++) {
+        switch (a->texture[i].type) {
+        case RR_TEXTURE_IMAGE:
+            {
+                RrRect narea = tarea;
+                RrTextureImage *img = &a->texture[i].data.image;
+                narea.x += img->tx;
+                narea.width -= img->tx;
+                narea.y += img->ty;
+                narea.height -= img->ty;
+                if (img->twidth)
+                    narea.width = MIN(narea.width, img->twidth);
+                if (img->theight)
+                    narea.height = MIN(narea.height, img->theight);
+                RrImageDrawImage(a->surface.pixel_data,
+                                 &a->texture[i].data.image,
+                                 a->w, a->h,
+                                 &narea, RrImageFilter(a->inst));
+            }
+            images = TRUE;
+            break;
+        case RR_TEXTURE_RGBA:
+            {
+                RrRect narea = tarea;
+                RrTextureRGBA *rgb = &a->texture[i].data.rgba;
+                narea.x += rgb->tx;
+                narea.width -= rgb->tx;
+                narea.y += rgb->ty;
+                narea.height -= rgb->ty;
+                if (rgb->twidth)
+                    narea.width = MIN(narea.width, rgb->twidth);
+                if (rgb->theight)
+                    narea.height = MIN(narea.height, rgb->theight);
+                RrImageDrawRGBA(a->surface.pixel_data,
+                                &a->texture[i].data.rgba,
+                                a->w, a->h,
+                                &narea, RrImageFilter(a->inst));
+            }
+            images = TRUE;
+            break;
+        default:
+            break;
+        }
+    }
+    return images;
+}
+
+/*! Renders the appearance into a->pixmap, which is w by h in size */
+static void paint(RrAppearance *a, gint w, gint h)
+{
+    gint i, transferred = 0, force_transfer = 0;
+    RrRect tarea; /* area in which to draw textures */
+
+    if (a->xftdraw == NULL) {
+        a->xftdraw = XftDrawCreate(RrDisplay(a->inst), a->pixmap,
+                                   RrVisual(a->inst), RrColormap(a->inst));
+        g_assert(a->xftdraw != NULL);
+    }
+    else if (XftDrawDrawable(a->xftdraw) != a->pixmap)
+        XftDrawChange(a->xftdraw, a->pixmap);
+
+    force_transfer = render_pixels(a, w, h);
+
+    {
+        gint l, t, r, b;
+        RrMargins(a, &l, &t, &r, &b);
+        RECT_SET(tarea, l, t, w - l - r, h - t - b);
+    }
+
     for (i = 0; i < a->textures; i++) {
         switch (a->texture[i].type) {
         case RR_TEXTURE_NONE:
@@ -100,11 +340,6 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
                     || (a->surface.interlaced))
                     pixel_data_to_pixmap(a, 0, 0, w, h);
             }
-            if (a->xftdraw == NULL) {
-                a->xftdraw = XftDrawCreate(RrDisplay(a->inst), a->pixmap,
-                                           RrVisual(a->inst),
-                                           RrColormap(a->inst));
-            }
             RrFontDraw(a->xftdraw, &a->texture[i].data.text, &tarea);
             break;
         case RR_TEXTURE_LINE_ART:
@@ -131,45 +366,10 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
             RrPixmapMaskDraw(a->pixmap, &a->texture[i].data.mask, &tarea);
             break;
         case RR_TEXTURE_IMAGE:
-            g_assert(!transferred);
-            {
-                RrRect narea = tarea;
-                RrTextureImage *img = &a->texture[i].data.image;
-                narea.x += img->tx;
-                narea.width -= img->tx;
-                narea.y += img->ty;
-                narea.height -= img->ty;
-                if (img->twidth)
-                    narea.width = MIN(narea.width, img->twidth);
-                if (img->theight)
-                    narea.height = MIN(narea.height, img->theight);
-                RrImageDrawImage(a->surface.pixel_data,
-                                 &a->texture[i].data.image,
-                                 a->w, a->h,
-                                 &narea);
-            }
-            force_transfer = 1;
-            break;
         case RR_TEXTURE_RGBA:
+            /* these were drawn into the pixel data already */
             g_assert(!transferred);
-            {
-                RrRect narea = tarea;
-                RrTextureRGBA *rgb = &a->texture[i].data.rgba;
-                narea.x += rgb->tx;
-                narea.width -= rgb->tx;
-                narea.y += rgb->ty;
-                narea.height -= rgb->ty;
-                if (rgb->twidth)
-                    narea.width = MIN(narea.width, rgb->twidth);
-                if (rgb->theight)
-                    narea.height = MIN(narea.height, rgb->theight);
-                RrImageDrawRGBA(a->surface.pixel_data,
-                                &a->texture[i].data.rgba,
-                                a->w, a->h,
-                                &narea);
-            }
-            force_transfer = 1;
-        break;
+            break;
         case RR_TEXTURE_NUM_TYPES:
             g_assert_not_reached();
         }
@@ -183,19 +383,144 @@ Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
             pixel_data_to_pixmap(a, 0, 0, w, h);
         }
     }
+}
+
+Pixmap RrPaintPixmap(RrAppearance *a, gint w, gint h)
+{
+    Pixmap oldp;
+
+    if (!can_paint(a, w, h)) return None;
 
+    oldp = a->pixmap; /* save to free after changing the visible pixmap */
+    a->pixmap = XCreatePixmap(RrDisplay(a->inst),
+                              RrRootWindow(a->inst),
+                              w, h, RrDepth(a->inst));
+    g_assert(a->pixmap != None);
+
+    a->hash = appearance_hash(a, w, h);
+    paint(a, w, h);
     return oldp;
 }
 
+/*! Finds the pixmap the appearance painted for the window */
+static RrPainted* find_painted(RrAppearance *a, Window win)
+{
+    GHashTable *painted = RrPaintedWindows(a->inst);
+    GSList *list, *it;
+    RrPainted *p;
+
+    list = g_hash_table_lookup(painted, GSIZE_TO_POINTER(win));
+    for (it = list; it; it = g_slist_next(it)) {
+        p = it->data;
+        if (p->a == a) return p;
+    }
+
+    p = g_slice_new(RrPainted);
+    p->a = a;
+    p->win = win;
+    p->pixmap = None;
+    p->w = p->h = 0;
+    a->painted = g_slist_prepend(a->painted, p);
+    g_hash_table_insert(painted, GSIZE_TO_POINTER(win),
+                        g_slist_prepend(list, p));
+    return p;
+}
+
+/*! Paints the appearance for the render cache, or uses the pixmap already in
+  the cache for it */
+static void paint_cached(RrAppearance *a, Window win, gint w, gint h)
+{
+    RrRenderCache *cache = RrRenderCacheFor(a->inst);
+    Pixmap own, p;
+
+    if ((p = RrRenderCacheFind(cache, a->hash, a->key->data, a->key->len,
+                               w, h)))
+    {
+        /* the pixel data isn't filled in, unless someone needs it */
+        if (a->w != w || a->h != h) {
+            g_free(a->surface.pixel_data);
+            a->surface.pixel_data = NULL;
+        }
+        a->w = w;
+        a->h = h;
+        a->stale = TRUE;
+
+        XSetWindowBackgroundPixmap(RrDisplay(a->inst), win, p);
+        XClearWindow(RrDisplay(a->inst), win);
+        return;
+    }
+
+    /* this pixmap is shared once it is in the cache, so it is never drawn
+       into again */
+    p = RrPixmapPoolGet(a->inst, w, h);
+    own = a->pixmap;
+    a->pixmap = p;
+    paint(a, w, h);
+    a->pixmap = own;
+
+    XSetWindowBackgroundPixmap(RrDisplay(a->inst), win, p);
+    XClearWindow(RrDisplay(a->inst), win);
+    RrRenderCacheAdd(cache, RrDisplay(a->inst), a->hash,
+                     a->key->data, a->key->len, w, h, RrDepth(a->inst), p);
+}
+
+void RrPaintForget(const RrInstance *inst, Window win)
+{
+    GHashTable *painted = RrPaintedWindows(inst);
+    GSList *list, *it;
+
+    list = g_hash_table_lookup(painted, GSIZE_TO_POINTER(win));
+    g_hash_table_remove(painted, GSIZE_TO_POINTER(win));
+
+    for (it = list; it; it = g_slist_next(it)) {
+        RrPainted *p = it->data;
+
+        p->a->painted = g_slist_remove(p->a->painted, p);
+        /* nothing shows the pixmap anymore */
+        if (p->pixmap) RrPixmapPoolPut(inst, p->pixmap, p->w, p->h);
+        g_slice_free(RrPainted, p);
+    }
+    g_slist_free(list);
+}
+
 void RrPaint(RrAppearance *a, Window win, gint w, gint h)
 {
-    Pixmap oldp;
+    RrPainted *p;
+    Pixmap own, oldp = None;
+    gint oldw = 0, oldh = 0;
+
+    if (!can_paint(a, w, h)) return;
+
+    if ((a->hash = appearance_hash(a, w, h))) {
+        paint_cached(a, win, w, h);
+        return;
+    }
 
-    oldp = RrPaintPixmap(a, w, h);
-    XSetWindowBackgroundPixmap(RrDisplay(a->inst), win, a->pixmap);
+    p = find_painted(a, win);
+    if (p->pixmap && (p->w != w || p->h != h)) {
+        /* the window changed size, so its pixmap can go back to the pool
+           once the window is done with it */
+        oldp = p->pixmap;
+        oldw = p->w;
+        oldh = p->h;
+        p->pixmap = None;
+    }
+    if (!p->pixmap) {
+        p->pixmap = RrPixmapPoolGet(a->inst, w, h);
+        p->w = w;
+        p->h = h;
+    }
+
+    /* RrPaintPixmap's pixmap stays with the appearance */
+    own = a->pixmap;
+    a->pixmap = p->pixmap;
+    paint(a, w, h);
+    a->pixmap = own;
+
+    XSetWindowBackgroundPixmap(RrDisplay(a->inst), win, p->pixmap);
     XClearWindow(RrDisplay(a->inst), win);
-    /* free this after changing the visible pixmap */
-    if (oldp) XFreePixmap(RrDisplay(a->inst), oldp);
+    /* give this back after changing the visible pixmap */
+    if (oldp) RrPixmapPoolPut(a->inst, oldp, oldw, oldh);
 }
 
 RrAppearance *RrAppearanceNew(const RrInstance *inst, gint numtex)
@@ -315,6 +640,10 @@ RrAppearance *RrAppearanceCopy(RrAppearance *orig)
     copy->pixmap = None;
     copy->xftdraw = NULL;
     copy->w = copy->h = 0;
+    copy->painted = NULL;
+    copy->hash = 0;
+    copy->key = NULL;
+    copy->stale = FALSE;
     return copy;
 }
 
@@ -323,7 +652,27 @@ void RrAppearanceFree(RrAppearance *a)
 {
     if (a) {
         RrSurface *p;
+        GSList *it;
+
         if (a->pixmap != None) XFreePixmap(RrDisplay(a->inst), a->pixmap);
+        for (it = a->painted; it; it = g_slist_next(it)) {
+            RrPainted *pw = it->data;
+            GHashTable *painted = RrPaintedWindows(a->inst);
+            GSList *list;
+
+            list = g_hash_table_lookup(painted, GSIZE_TO_POINTER(pw->win));
+            list = g_slist_remove(list, pw);
+            if (list)
+                g_hash_table_insert(painted, GSIZE_TO_POINTER(pw->win), list);
+            else
+                g_hash_table_remove(painted, GSIZE_TO_POINTER(pw->win));
+
+            /* the window can still be showing it */
+            if (pw->pixmap) XFreePixmap(RrDisplay(a->inst), pw->pixmap);
+            g_slice_free(RrPainted, pw);
+        }
+        g_slist_free(a->painted);
+        if (a->key) g_byte_array_free(a->key, TRUE);
         if (a->xftdraw != NULL) XftDrawDestroy(a->xftdraw);
         if (a->textures)
             g_free(a->texture);
@@ -348,19 +697,32 @@ static void pixel_data_to_pixmap(RrAppearance *l,
     RrPixel32 *in, *scratch;
     Pixmap out;
     XImage *im = NULL;
-    im = XCreateImage(RrDisplay(l->inst), RrVisual(l->inst), RrDepth(l->inst),
-                      ZPixmap, 0, NULL, w, h, 32, 0);
-    g_assert(im != NULL);
+    RrShmSegment *seg;
 
     in = l->surface.pixel_data;
     out = l->pixmap;
 
-/* this malloc is a complete waste of time on normal 32bpp
-   as reduce_depth just sets im->data = data and returns
-*/
-    scratch = g_new(RrPixel32, im->width * im->height);
-    im->data = (gchar*) scratch;
-    RrReduceDepth(l->inst, in, im);
+    /* convert straight into memory that the server can read from, so the
+       image doesn't have to be sent through the socket */
+    if ((im = RrShmImageNew(l->inst, w, h, &seg))) {
+        RrReduceDepth(l->inst, in, im);
+        RrShmPutImage(l->inst, out, im, seg, x, y);
+        return;
+    }
+
+    im = XCreateImage(RrDisplay(l->inst), RrVisual(l->inst), RrDepth(l->inst),
+                      ZPixmap, 0, NULL, w, h, 32, 0);
+    g_assert(im != NULL);
+
+    if (RrReduceDepthCopies(l->inst, im)) {
+        /* the pixel data is already in the image's format */
+        scratch = NULL;
+        im->data = (gchar*) in;
+    } else {
+        scratch = g_new(RrPixel32, im->width * im->height);
+        im->data = (gchar*) scratch;
+        RrReduceDepth(l->inst, in, im);
+    }
     XPutImage(RrDisplay(l->inst), out,
               DefaultGC(RrDisplay(l->inst), RrScreen(l->inst)),
               im, 0, 0, x, y, w, h);
@@ -53,6 +53,11 @@ typedef guint32 RrPixel32;  /* ARGB format, not premultiplied alpha */
 typedef guint16 RrPixel16;
 typedef guchar  RrPixel8;
 
+typedef enum {
+    RR_SCALE_BOX,     /* averages the pixels under each new pixel */
+    RR_SCALE_LANCZOS  /* keeps small pictures sharper */
+} RrScaleFilter;
+
 typedef enum {
     RR_RELIEF_FLAT,
     RR_RELIEF_RAISED,
@@ -231,12 +236,17 @@ struct _RrAppearance {
 
     /* cached for internal use */
     gint w, h;
+    GSList *painted; /* pixmaps kept for the windows painted by RrPaint, until
+                        they are destroyed */
+    guint64 hash; /* what was painted last, or 0 if it can't be cached */
+    GByteArray *key; /* what the hash is of */
+    gboolean stale; /* pixel_data is not filled in for what was painted */
 };
 
 /*! Holds a RGBA image picture */
 struct _RrImagePic {
     gint width, height;
-    RrPixel32 *data;
+    RrPixel32 *data; /* with the colors premultiplied by the alpha */
     /* The sum of all the pixels.  This is used to compare pictures if their
        hashes match. */
     gint sum;
@@ -363,6 +373,8 @@ gint     RrBlueShift    (const RrInstance *inst);
 gint     RrRedMask      (const RrInstance *inst);
 gint     RrGreenMask    (const RrInstance *inst);
 gint     RrBlueMask     (const RrInstance *inst);
+gboolean RrDither       (const RrInstance *inst);
+RrScaleFilter RrImageFilter (const RrInstance *inst);
 
 RrColor *RrColorNew   (const RrInstance *inst, gint r, gint g, gint b);
 RrColor *RrColorCopy  (RrColor *c);
@@ -397,12 +409,30 @@ RrSize *RrFontMeasureString (const RrFont *f, const gchar *str,
                              gboolean flow, gint maxwidth);
 gint    RrFontHeight        (const RrFont *f, gint shadow_offset_y);
 gint    RrFontMaxCharWidth  (const RrFont *f);
+/*! Returns the number of times a string was measured or drawn with a layout
+  that fonts kept from before, and the number of times it had to be laid
+  out */
+void    RrFontCacheStats    (gulong *hits, gulong *misses);
+/*! Returns how many pixmaps were made for painting into, and how many unused
+  ones were painted into again instead */
+void    RrPixmapPoolStats   (gulong *made, gulong *reused);
 
 /* Paint into the appearance. The old pixmap is returned (if there was one). It
    is the responsibility of the caller to call XFreePixmap on the return when
    it is non-null. */
 Pixmap RrPaintPixmap (RrAppearance *a, gint w, gint h);
 void   RrPaint       (RrAppearance *a, Window win, gint w, gint h);
+/*! Lets go of the pixmaps RrPaint kept for the window.  Call this once the
+  window is destroyed. */
+void   RrPaintForget (const RrInstance *inst, Window win);
+/*! Sets the most memory that pixmaps kept for sharing between identical
+  appearances can use.  0 turns off sharing them. */
+void   RrSetRenderCacheSize(const RrInstance *inst, gulong bytes);
+/*! Sets if colors are dithered when they lose bits, for screens with 16 bits
+  per pixel or fewer */
+void   RrSetDither   (RrInstance *inst, gboolean dither);
+/*! Sets how images are made smaller to fit where they are drawn */
+void   RrSetImageFilter(RrInstance *inst, RrScaleFilter filter);
 void   RrMinSize     (RrAppearance *a, gint *w, gint *h);
 gint   RrMinWidth    (RrAppearance *a);
 /* For text textures, if flow is TRUE, then the string must be set before
@@ -420,6 +450,10 @@ gboolean RrPixmapToRGBA(const RrInstance *inst,
 RrImageCache* RrImageCacheNew(gint max_resized_saved);
 void          RrImageCacheRef(RrImageCache *self);
 void          RrImageCacheUnref(RrImageCache *self);
+/*! Saves resized pictures as files in @dir as well, using up to @max_bytes,
+  so they don't need to be resized again after a restart.  0 turns it off */
+void          RrImageCacheSetDiskCache(RrImageCache *self, const gchar *dir,
+                                       gulong max_bytes);
 
 /*! Create a new image, or return one from the cache that matches.
   @param cache The image cache.
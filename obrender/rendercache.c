@@ -0,0 +1,144 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   rendercache.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "rendercache.h"
+
+#include <string.h>
+
+typedef struct _RrRenderCacheEntry {
+    guint64 hash;
+    guint8 *key; /* a copy of what was hashed, to tell apart collisions */
+    guint key_len;
+    gint w, h;
+    Pixmap pixmap;
+    gulong bytes;
+    GList *lru; /* the entry's link in the lru queue */
+} RrRenderCacheEntry;
+
+struct _RrRenderCache {
+    gulong max_bytes;
+    gulong bytes;
+    GHashTable *table; /* hash -> RrRenderCacheEntry */
+    GQueue lru; /* the most recently used entry is at the head */
+};
+
+static guint hash_hash(gconstpointer p)
+{
+    const guint64 h = *(const guint64*)p;
+    return (guint)(h ^ (h >> 32));
+}
+
+static gboolean hash_equal(gconstpointer p1, gconstpointer p2)
+{
+    return *(const guint64*)p1 == *(const guint64*)p2;
+}
+
+static void entry_remove(RrRenderCache *c, Display *d, RrRenderCacheEntry *e)
+{
+    g_hash_table_remove(c->table, &e->hash);
+    g_queue_delete_link(&c->lru, e->lru);
+    c->bytes -= e->bytes;
+    /* windows using it as their background keep it until they are done */
+    XFreePixmap(d, e->pixmap);
+    g_free(e->key);
+    g_slice_free(RrRenderCacheEntry, e);
+}
+
+/*! Removes the least recently used pixmaps until the cache fits in its size */
+static void trim(RrRenderCache *c, Display *d)
+{
+    while (c->bytes > c->max_bytes)
+        entry_remove(c, d, g_queue_peek_tail(&c->lru));
+}
+
+RrRenderCache* RrRenderCacheNew(gulong max_bytes)
+{
+    RrRenderCache *c;
+
+    c = g_slice_new(RrRenderCache);
+    c->max_bytes = max_bytes;
+    c->bytes = 0;
+    c->table = g_hash_table_new(hash_hash, hash_equal);
+    g_queue_init(&c->lru);
+    return c;
+}
+
+void RrRenderCacheFree(RrRenderCache *c, Display *d)
+{
+    if (c) {
+        c->max_bytes = 0;
+        trim(c, d);
+        g_hash_table_destroy(c->table);
+        g_slice_free(RrRenderCache, c);
+    }
+}
+
+void RrRenderCacheSetSize(RrRenderCache *c, Display *d, gulong max_bytes)
+{
+    c->max_bytes = max_bytes;
+    trim(c, d);
+}
+
+gboolean RrRenderCacheEnabled(RrRenderCache *c)
+{
+    return c->max_bytes > 0;
+}
+
+Pixmap RrRenderCacheFind(RrRenderCache *c, guint64 hash,
+                         const guint8 *key, guint key_len, gint w, gint h)
+{
+    RrRenderCacheEntry *e;
+
+    e = g_hash_table_lookup(c->table, &hash);
+    if (!e || e->w != w || e->h != h || e->key_len != key_len ||
+        memcmp(e->key, key, key_len))
+        return None;
+
+    /* move it to the front of the line */
+    g_queue_unlink(&c->lru, e->lru);
+    g_queue_push_head_link(&c->lru, e->lru);
+    return e->pixmap;
+}
+
+void RrRenderCacheAdd(RrRenderCache *c, Display *d, guint64 hash,
+                      const guint8 *key, guint key_len,
+                      gint w, gint h, gint depth, Pixmap p)
+{
+    RrRenderCacheEntry *e;
+
+    if ((e = g_hash_table_lookup(c->table, &hash)))
+        entry_remove(c, d, e);
+
+    e = g_slice_new(RrRenderCacheEntry);
+    e->hash = hash;
+    e->key = g_memdup(key, key_len);
+    e->key_len = key_len;
+    e->w = w;
+    e->h = h;
+    e->pixmap = p;
+    /* pixmaps are stored with at least a byte per pixel, and at most 32 bits
+       for any depth over 16 */
+    e->bytes = (gulong)w * h * (depth > 16 ? 4 : (depth > 8 ? 2 : 1)) +
+        key_len;
+    g_queue_push_head(&c->lru, e);
+    e->lru = g_queue_peek_head_link(&c->lru);
+    g_hash_table_insert(c->table, &e->hash, e);
+    c->bytes += e->bytes;
+
+    trim(c, d);
+}
@@ -0,0 +1,53 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   rendercache.h for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __rendercache_h
+#define __rendercache_h
+
+#include <X11/Xlib.h>
+#include <glib.h>
+
+typedef struct _RrRenderCache RrRenderCache;
+
+/*! Create a new render cache.  A render cache holds pixmaps that appearances
+  were painted into, with their key being everything that went into painting
+  them, and found by a hash of the key.  Appearances that would paint the same thing can use
+  the pixmap in the cache instead, so the pixmaps must never be drawn into
+  once they are in the cache.
+  @param max_bytes The most memory the pixmaps in the cache can use.  When
+    this is exceeded, the least recently used pixmaps are removed.
+*/
+RrRenderCache* RrRenderCacheNew(gulong max_bytes);
+void RrRenderCacheFree(RrRenderCache *c, Display *d);
+
+void RrRenderCacheSetSize(RrRenderCache *c, Display *d, gulong max_bytes);
+/*! Returns FALSE if the cache's size is 0, so nothing is kept in it */
+gboolean RrRenderCacheEnabled(RrRenderCache *c);
+
+/*! Returns the pixmap painted for the key, or None if it is not in the
+  cache */
+Pixmap RrRenderCacheFind(RrRenderCache *c, guint64 hash,
+                         const guint8 *key, guint key_len, gint w, gint h);
+/*! Adds a pixmap to the cache, which then owns it.  Pixmaps that are removed
+  from the cache are freed, but windows that have them as their background
+  keep them until they stop using them. */
+void RrRenderCacheAdd(RrRenderCache *c, Display *d, guint64 hash,
+                      const guint8 *key, guint key_len,
+                      gint w, gint h, gint depth, Pixmap p);
+
+#endif
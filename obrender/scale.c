@@ -0,0 +1,451 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   scale.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "scale.h"
+#include "cpu.h"
+
+#include <math.h>
+#include <glib.h>
+
+/* the weights for each destination pixel add up to 1 << WEIGHT_BITS */
+#define WEIGHT_BITS 14
+/* the rows are kept with this many bits below the 8 bits of each channel in
+   between the two passes */
+#define TMP_BITS    6
+
+#define ROW_SHIFT   (WEIGHT_BITS - TMP_BITS)
+#define ROW_ROUND   (1 << (ROW_SHIFT - 1))
+#define COL_SHIFT   (WEIGHT_BITS + TMP_BITS)
+#define COL_ROUND   (1 << (COL_SHIFT - 1))
+
+/* how many lobes of the sinc function the lanczos filter uses */
+#define LANCZOS_LOBES 3
+
+/*! The source pixels which make up one destination pixel, along a row or a
+  column */
+typedef struct {
+    gint start;       /* the first source pixel */
+    gint n;           /* the number of source pixels */
+    const gint16 *w;  /* a weight for each one.  when n is odd there is a 0
+                         after the last one, so they can be read in pairs */
+} ScaleTap;
+
+typedef struct {
+    ScaleTap *taps;   /* one for each destination pixel */
+    gint16 *weights;
+} ScaleTable;
+
+/*! Scales one row of pixels into a row of 16 bit channels */
+typedef void (*ScaleRowFunc)(const RrPixel32 *src, gint16 *dst,
+                             const ScaleTable *t, gint dstW);
+/*! Makes one row of destination pixels from the scaled rows, which are
+  @stride channels apart */
+typedef void (*ScaleColFunc)(const gint16 *tmp, gint stride,
+                             const ScaleTap *tap, RrPixel32 *dst, gint dstW);
+
+/*! Works out the weights for scaling @src pixels into @dst pixels */
+static void table_init(ScaleTable *t, gint src, gint dst,
+                       RrScaleFilter filter)
+{
+    gdouble scale, support, a, b, sum, x, r;
+    gdouble s1, c1, s2, c2, step, s1step, c1step, s2step, c2step;
+    gdouble *f;
+    gint i, j, j1, j2, stride, n, big, total;
+    gint16 *w;
+    gboolean smooth;
+
+    scale = (gdouble)src / dst;
+    smooth = filter == RR_SCALE_LANCZOS && dst < src;
+    support = smooth ? LANCZOS_LOBES * scale : scale;
+
+    /* the lanczos filter is sin(x) * sin(x / lobes) / x^2, and x goes up by
+       the same step from one source pixel to the next.  so the sines are
+       stepped along by rotating them, rather than worked out again for each
+       source pixel */
+    step = G_PI / scale;
+    s1step = sin(step);
+    c1step = cos(step);
+    s2step = sin(step / LANCZOS_LOBES);
+    c2step = cos(step / LANCZOS_LOBES);
+
+    /* room for every source pixel a destination pixel can touch, and the 0
+       after them */
+    stride = MIN((gint)ceil(support * 2) + 2, src + 1);
+    stride = (stride + 1) & ~1;
+
+    t->taps = g_new(ScaleTap, dst);
+    t->weights = g_new0(gint16, dst * stride);
+    f = g_new(gdouble, stride);
+
+    for (i = 0; i < dst; ++i) {
+        w = t->weights + i * stride;
+
+        if (smooth) {
+            /* the center of the destination pixel, in the source */
+            a = (i + 0.5) * scale - 0.5;
+            j1 = (gint)floor(a - support) + 1;
+            j2 = (gint)ceil(a + support) - 1;
+
+            n = MIN(j2, src - 1) - MAX(j1, 0) + 1;
+            for (j = 0; j < n; ++j)
+                f[j] = 0.0;
+            x = (j1 - a) * step;
+            s1 = sin(x);
+            c1 = cos(x);
+            s2 = sin(x / LANCZOS_LOBES);
+            c2 = cos(x / LANCZOS_LOBES);
+            for (j = j1; j <= j2; ++j) {
+                x = (j - a) * step;
+                /* the pixels past the edges are made from the ones on the
+                   edges */
+                f[CLAMP(j, 0, src - 1) - MAX(j1, 0)] +=
+                    fabs(x) < 1e-9 ? 1.0 : LANCZOS_LOBES * s1 * s2 / (x * x);
+
+                r = s1 * c1step + c1 * s1step;
+                c1 = c1 * c1step - s1 * s1step;
+                s1 = r;
+                r = s2 * c2step + c2 * s2step;
+                c2 = c2 * c2step - s2 * s2step;
+                s2 = r;
+            }
+            j1 = MAX(j1, 0);
+        }
+        else {
+            /* how much of each source pixel the destination pixel covers */
+            a = i * scale;
+            b = i == dst - 1 ? src : (i + 1) * scale;
+            j1 = (gint)floor(a);
+            j2 = MIN((gint)ceil(b) - 1, src - 1);
+
+            n = j2 - j1 + 1;
+            for (j = 0; j < n; ++j)
+                f[j] = MIN(b, j1 + j + 1) - MAX(a, j1 + j);
+        }
+
+        sum = 0.0;
+        for (j = 0; j < n; ++j)
+            sum += f[j];
+
+        /* round the weights so they still add up to 1 */
+        total = big = 0;
+        for (j = 0; j < n; ++j) {
+            w[j] = (gint16)floor(f[j] / sum * (1 << WEIGHT_BITS) + 0.5);
+            total += w[j];
+            if (w[j] > w[big]) big = j;
+        }
+        w[big] += (1 << WEIGHT_BITS) - total;
+
+        t->taps[i].start = j1;
+        t->taps[i].n = n;
+        t->taps[i].w = w;
+    }
+
+    g_free(f);
+}
+
+static void table_free(ScaleTable *t)
+{
+    g_free(t->taps);
+    g_free(t->weights);
+}
+
+static void row_scalar(const RrPixel32 *src, gint16 *dst,
+                       const ScaleTable *t, gint dstW)
+{
+    const ScaleTap *tap;
+    const RrPixel32 *p;
+    gint32 s0, s1, s2, s3;
+    gint x, i;
+
+    for (x = 0; x < dstW; ++x) {
+        tap = &t->taps[x];
+        p = src + tap->start;
+        s0 = s1 = s2 = s3 = 0;
+        for (i = 0; i < tap->n; ++i) {
+            s0 += (gint32)( p[i]        & 0xff) * tap->w[i];
+            s1 += (gint32)((p[i] >>  8) & 0xff) * tap->w[i];
+            s2 += (gint32)((p[i] >> 16) & 0xff) * tap->w[i];
+            s3 += (gint32)( p[i] >> 24        ) * tap->w[i];
+        }
+        *(dst++) = (s0 + ROW_ROUND) >> ROW_SHIFT;
+        *(dst++) = (s1 + ROW_ROUND) >> ROW_SHIFT;
+        *(dst++) = (s2 + ROW_ROUND) >> ROW_SHIFT;
+        *(dst++) = (s3 + ROW_ROUND) >> ROW_SHIFT;
+    }
+}
+
+static void col_scalar(const gint16 *tmp, gint stride, const ScaleTap *tap,
+                       RrPixel32 *dst, gint dstW)
+{
+    const gint16 *p;
+    gint32 s[4], v;
+    gint x, i, c;
+
+    for (x = 0; x < dstW; ++x) {
+        p = tmp + tap->start * stride + x * 4;
+        s[0] = s[1] = s[2] = s[3] = 0;
+        for (i = 0; i < tap->n; ++i, p += stride)
+            for (c = 0; c < 4; ++c)
+                s[c] += (gint32)p[c] * tap->w[i];
+
+        dst[x] = 0;
+        for (c = 0; c < 4; ++c) {
+            v = (s[c] + COL_ROUND) >> COL_SHIFT;
+            dst[x] |= (RrPixel32)CLAMP(v, 0, 255) << (c * 8);
+        }
+    }
+}
+
+#ifdef USE_SIMD
+
+#include <immintrin.h>
+
+/* The vector code treats the bytes of a pixel in the order they are in
+   memory, which is the same as the shifts in the C code on x86.
+
+   Two source pixels are added up at a time with pmaddwd, by putting the same
+   channel from each one next to each other, and multiplying them by a pair
+   of weights. */
+#define WEIGHT_PAIR(w) \
+    ((guint32)(guint16)(w)[0] | ((guint32)(guint16)(w)[1] << 16))
+
+__attribute__((target("sse2")))
+static inline __m128i row_pairs_sse2(const RrPixel32 *p, const gint16 *w,
+                                     gint i, gint n, __m128i acc)
+{
+    const __m128i zero = _mm_setzero_si128();
+    __m128i px;
+
+    for (; i + 1 < n; i += 2) {
+        px = _mm_loadl_epi64((const __m128i*)(p + i));
+        px = _mm_unpacklo_epi8(px, zero);
+        px = _mm_unpacklo_epi16(px, _mm_srli_si128(px, 8));
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(
+                                px, _mm_set1_epi32(WEIGHT_PAIR(w + i))));
+    }
+    if (i < n) {
+        px = _mm_unpacklo_epi8(_mm_cvtsi32_si128(p[i]), zero);
+        px = _mm_unpacklo_epi16(px, zero);
+        acc = _mm_add_epi32(acc, _mm_madd_epi16(
+                                px, _mm_set1_epi32(WEIGHT_PAIR(w + i))));
+    }
+    return acc;
+}
+
+__attribute__((target("sse2")))
+static inline void row_store_sse2(gint16 *dst, __m128i acc)
+{
+    acc = _mm_add_epi32(acc, _mm_set1_epi32(ROW_ROUND));
+    acc = _mm_srai_epi32(acc, ROW_SHIFT);
+    _mm_storel_epi64((__m128i*)dst, _mm_packs_epi32(acc, acc));
+}
+
+__attribute__((target("sse2")))
+static void row_sse2(const RrPixel32 *src, gint16 *dst,
+                     const ScaleTable *t, gint dstW)
+{
+    const ScaleTap *tap;
+    gint x;
+
+    for (x = 0; x < dstW; ++x) {
+        tap = &t->taps[x];
+        row_store_sse2(dst + x * 4,
+                       row_pairs_sse2(src + tap->start, tap->w, 0, tap->n,
+                                      _mm_setzero_si128()));
+    }
+}
+
+__attribute__((target("avx2")))
+static void row_avx2(const RrPixel32 *src, gint16 *dst,
+                     const ScaleTable *t, gint dstW)
+{
+    const ScaleTap *tap;
+    const RrPixel32 *p;
+    /* puts the first pair of weights in the bottom half, and the second
+       pair in the top half */
+    const __m256i spread = _mm256_setr_epi32(0, 0, 0, 0, 1, 1, 1, 1);
+    __m256i acc, px, w;
+    gint x, i;
+
+    for (x = 0; x < dstW; ++x) {
+        tap = &t->taps[x];
+        p = src + tap->start;
+        acc = _mm256_setzero_si256();
+
+        /* two pairs of pixels at a time, one in each half */
+        for (i = 0; i + 3 < tap->n; i += 4) {
+            px = _mm256_cvtepu8_epi16(_mm_loadu_si128((const __m128i*)(p+i)));
+            px = _mm256_unpacklo_epi16(px, _mm256_srli_si256(px, 8));
+            w = _mm256_permutevar8x32_epi32(
+                _mm256_castsi128_si256(
+                    _mm_loadl_epi64((const __m128i*)(tap->w + i))), spread);
+            acc = _mm256_add_epi32(acc, _mm256_madd_epi16(px, w));
+        }
+
+        row_store_sse2(dst + x * 4,
+                       row_pairs_sse2(p, tap->w, i, tap->n,
+                                      _mm_add_epi32(
+                                          _mm256_castsi256_si128(acc),
+                                          _mm256_extracti128_si256(acc, 1))));
+    }
+}
+
+__attribute__((target("sse2")))
+static inline __m128i col_finish_sse2(__m128i acc)
+{
+    acc = _mm_add_epi32(acc, _mm_set1_epi32(COL_ROUND));
+    return _mm_srai_epi32(acc, COL_SHIFT);
+}
+
+/*! Makes the destination pixels from @x to the end of the row */
+__attribute__((target("sse2")))
+static void cols_sse2(const gint16 *tmp, gint stride, const ScaleTap *tap,
+                      RrPixel32 *dst, gint dstW, gint x)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const gint16 *p;
+    __m128i lo, hi, a, b, w;
+    gint i;
+
+    /* two pixels at a time */
+    for (; x + 2 <= dstW; x += 2) {
+        p = tmp + tap->start * stride + x * 4;
+        lo = hi = zero;
+        for (i = 0; i < tap->n; i += 2, p += stride * 2) {
+            a = _mm_loadu_si128((const __m128i*)p);
+            b = i + 1 < tap->n ? _mm_loadu_si128((const __m128i*)(p+stride))
+                               : zero;
+            w = _mm_set1_epi32(WEIGHT_PAIR(tap->w + i));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b),
+                                                  w));
+            hi = _mm_add_epi32(hi, _mm_madd_epi16(_mm_unpackhi_epi16(a, b),
+                                                  w));
+        }
+        a = _mm_packs_epi32(col_finish_sse2(lo), col_finish_sse2(hi));
+        _mm_storel_epi64((__m128i*)(dst + x), _mm_packus_epi16(a, a));
+    }
+
+    if (x < dstW) {
+        p = tmp + tap->start * stride + x * 4;
+        lo = zero;
+        for (i = 0; i < tap->n; i += 2, p += stride * 2) {
+            a = _mm_loadl_epi64((const __m128i*)p);
+            b = i + 1 < tap->n ? _mm_loadl_epi64((const __m128i*)(p+stride))
+                               : zero;
+            w = _mm_set1_epi32(WEIGHT_PAIR(tap->w + i));
+            lo = _mm_add_epi32(lo, _mm_madd_epi16(_mm_unpacklo_epi16(a, b),
+                                                  w));
+        }
+        a = _mm_packs_epi32(col_finish_sse2(lo), zero);
+        dst[x] = _mm_cvtsi128_si32(_mm_packus_epi16(a, a));
+    }
+}
+
+__attribute__((target("sse2")))
+static void col_sse2(const gint16 *tmp, gint stride, const ScaleTap *tap,
+                     RrPixel32 *dst, gint dstW)
+{
+    cols_sse2(tmp, stride, tap, dst, dstW, 0);
+}
+
+__attribute__((target("avx2")))
+static void col_avx2(const gint16 *tmp, gint stride, const ScaleTap *tap,
+                     RrPixel32 *dst, gint dstW)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i round = _mm256_set1_epi32(COL_ROUND);
+    const gint16 *p;
+    __m256i lo, hi, a, b, w;
+    gint x, i;
+
+    /* four pixels at a time.  the unpacks work within each half, and the
+       packs put them back in order within each half */
+    for (x = 0; x + 4 <= dstW; x += 4) {
+        p = tmp + tap->start * stride + x * 4;
+        lo = hi = zero;
+        for (i = 0; i < tap->n; i += 2, p += stride * 2) {
+            a = _mm256_loadu_si256((const __m256i*)p);
+            b = i + 1 < tap->n ?
+                _mm256_loadu_si256((const __m256i*)(p + stride)) : zero;
+            w = _mm256_set1_epi32(WEIGHT_PAIR(tap->w + i));
+            lo = _mm256_add_epi32(lo, _mm256_madd_epi16(
+                                      _mm256_unpacklo_epi16(a, b), w));
+            hi = _mm256_add_epi32(hi, _mm256_madd_epi16(
+                                      _mm256_unpackhi_epi16(a, b), w));
+        }
+        lo = _mm256_srai_epi32(_mm256_add_epi32(lo, round), COL_SHIFT);
+        hi = _mm256_srai_epi32(_mm256_add_epi32(hi, round), COL_SHIFT);
+        a = _mm256_packs_epi32(lo, hi);
+        a = _mm256_packus_epi16(a, a);
+        a = _mm256_permute4x64_epi64(a, 0x08);
+        _mm_storeu_si128((__m128i*)(dst + x), _mm256_castsi256_si128(a));
+    }
+
+    /* gcc leaves the top halves dirty when it makes this a jump, and mixing
+       those with the sse2 code is slow */
+    _mm256_zeroupper();
+    cols_sse2(tmp, stride, tap, dst, dstW, x);
+}
+
+#endif
+
+RrPixel32* RrScale(const RrPixel32 *src, gint srcW, gint srcH,
+                   gint dstW, gint dstH, RrScaleFilter filter)
+{
+    ScaleTable tx, ty;
+    ScaleRowFunc row = row_scalar;
+    ScaleColFunc col = col_scalar;
+    RrPixel32 *dst;
+    gint16 *tmp;
+    gint y, stride;
+#ifdef USE_SIMD
+    RrCpuFeatures f = RrCpuGetFeatures();
+
+    if (f & RR_CPU_AVX2) {
+        row = row_avx2;
+        col = col_avx2;
+    }
+    else if (f & RR_CPU_SSE2) {
+        row = row_sse2;
+        col = col_sse2;
+    }
+#endif
+
+    g_assert(srcW > 0);
+    g_assert(srcH > 0);
+    g_assert(dstW > 0);
+    g_assert(dstH > 0);
+
+    table_init(&tx, srcW, dstW, filter);
+    table_init(&ty, srcH, dstH, filter);
+
+    /* scale each row across, and then scale those down */
+    stride = dstW * 4;
+    tmp = g_new(gint16, stride * srcH);
+    for (y = 0; y < srcH; ++y)
+        row(src + y * srcW, tmp + y * stride, &tx, dstW);
+
+    dst = g_new(RrPixel32, dstW * dstH);
+    for (y = 0; y < dstH; ++y)
+        col(tmp, stride, &ty.taps[y], dst + y * dstW, dstW);
+
+    g_free(tmp);
+    table_free(&tx);
+    table_free(&ty);
+    return dst;
+}
@@ -0,0 +1,35 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   scale.h for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __render_scale_h
+#define __render_scale_h
+
+#include "render.h"
+
+#include <glib.h>
+
+/*! Scales a picture to a new size.  Each of the 4 channels in a pixel is
+  scaled on its own, first across the rows and then down the columns.
+  @param filter Picks how the picture is made smaller.  Pictures which are
+    made bigger always use RR_SCALE_BOX.
+  @return A new array of dstW * dstH pixels, to be freed with g_free().
+*/
+RrPixel32* RrScale(const RrPixel32 *src, gint srcW, gint srcH,
+                   gint dstW, gint dstH, RrScaleFilter filter);
+
+#endif
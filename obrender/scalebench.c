@@ -0,0 +1,261 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   scalebench.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Measures how fast RrScale() makes a 256x256 icon smaller, with each
+   filter and each set of vector instructions that the processor has, next
+   to the resizing code that it replaced.  It prints how far each one's
+   pixels are from the old code's, and checks that the vector code gives the
+   same pixels as the plain C code. */
+
+#include "render.h"
+#include "scale.h"
+#include "cpu.h"
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <glib.h>
+
+#define FRACTION        12
+#define FLOOR(i)        ((i) & (~0UL << FRACTION))
+
+static const gint sizes[] = { 16, 48, 128 };
+
+static const struct {
+    const gchar *name;
+    RrCpuFeatures features;
+} kernels[] = {
+    { "c", 0 },
+    { "sse2", RR_CPU_SSE2 },
+    { "avx2", RR_CPU_SSE2 | RR_CPU_AVX2 }
+};
+
+static const struct {
+    const gchar *name;
+    RrScaleFilter filter;
+} filters[] = {
+    { "box", RR_SCALE_BOX },
+    { "lanczos", RR_SCALE_LANCZOS }
+};
+
+#define N_SIZES (sizeof(sizes) / sizeof(sizes[0]))
+#define N_KERNELS (sizeof(kernels) / sizeof(kernels[0]))
+#define N_FILTERS (sizeof(filters) / sizeof(filters[0]))
+
+/*! The way pictures were resized before RrScale() */
+static RrPixel32* old_scale(RrPixel32 *src, gulong srcW, gulong srcH,
+                            gulong dstW, gulong dstH)
+{
+    RrPixel32 *dst, *dststart;
+    gulong dstX, dstY, srcX, srcY;
+    gulong srcX1, srcX2, srcY1, srcY2;
+    gulong ratioX, ratioY;
+
+    dststart = dst = g_new(RrPixel32, dstW * dstH);
+
+    ratioX = (srcW << FRACTION) / dstW;
+    ratioY = (srcH << FRACTION) / dstH;
+
+    srcY2 = 0;
+    for (dstY = 0; dstY < dstH; dstY++) {
+        srcY1 = srcY2;
+        srcY2 += ratioY;
+
+        srcX2 = 0;
+        for (dstX = 0; dstX < dstW; dstX++) {
+            gulong red = 0, green = 0, blue = 0, alpha = 0;
+            gulong portionX, portionY, portionXY, sumXY = 0;
+            RrPixel32 pixel;
+
+            srcX1 = srcX2;
+            srcX2 += ratioX;
+
+            for (srcY = srcY1; srcY < srcY2; srcY += (1UL << FRACTION)) {
+                if (srcY == srcY1) {
+                    srcY = FLOOR(srcY);
+                    portionY = (1UL << FRACTION) - (srcY1 - srcY);
+                    if (portionY > srcY2 - srcY1)
+                        portionY = srcY2 - srcY1;
+                }
+                else if (srcY == FLOOR(srcY2))
+                    portionY = srcY2 - srcY;
+                else
+                    portionY = (1UL << FRACTION);
+
+                for (srcX = srcX1; srcX < srcX2; srcX += (1UL << FRACTION)) {
+                    if (srcX == srcX1) {
+                        srcX = FLOOR(srcX);
+                        portionX = (1UL << FRACTION) - (srcX1 - srcX);
+                        if (portionX > srcX2 - srcX1)
+                            portionX = srcX2 - srcX1;
+                    }
+                    else if (srcX == FLOOR(srcX2))
+                        portionX = srcX2 - srcX;
+                    else
+                        portionX = (1UL << FRACTION);
+
+                    portionXY = (portionX * portionY) >> FRACTION;
+                    sumXY += portionXY;
+
+                    pixel = *(src + (srcY >> FRACTION) * srcW
+                            + (srcX >> FRACTION));
+                    red   += ((pixel >> RrDefaultRedOffset)   & 0xFF)
+                             * portionXY;
+                    green += ((pixel >> RrDefaultGreenOffset) & 0xFF)
+                             * portionXY;
+                    blue  += ((pixel >> RrDefaultBlueOffset)  & 0xFF)
+                             * portionXY;
+                    alpha += ((pixel >> RrDefaultAlphaOffset) & 0xFF)
+                             * portionXY;
+                }
+            }
+
+            red   /= sumXY;
+            green /= sumXY;
+            blue  /= sumXY;
+            alpha /= sumXY;
+
+            *dst++ = (red   << RrDefaultRedOffset)   |
+                     (green << RrDefaultGreenOffset) |
+                     (blue  << RrDefaultBlueOffset)  |
+                     (alpha << RrDefaultAlphaOffset);
+        }
+    }
+    return dststart;
+}
+
+/*! Makes something like an icon: a round shape with a shaded fill, a sharp
+  outline, some fine detail and a transparent background */
+static void make_icon(RrPixel32 *data, gint size)
+{
+    gint x, y, dx, dy, r2, c;
+    guint a, r, g, b;
+
+    c = size / 2;
+    for (y = 0; y < size; ++y)
+        for (x = 0; x < size; ++x) {
+            dx = x - c;
+            dy = y - c;
+            r2 = dx * dx + dy * dy;
+            if (r2 > (c - 8) * (c - 8)) {
+                a = 0;
+                r = g = b = 0;
+            }
+            else if (r2 > (c - 12) * (c - 12)) {
+                a = 255;
+                r = g = b = 20;
+            }
+            else {
+                a = 255 - (x + y) * 64 / size;
+                r = x * 255 / size;
+                g = y * 255 / size;
+                b = ((x / 4 + y / 4) & 1) ? 230 : 40;
+            }
+            *(data++) = (a << RrDefaultAlphaOffset) |
+                        (r << RrDefaultRedOffset) |
+                        (g << RrDefaultGreenOffset) |
+                        (b << RrDefaultBlueOffset);
+        }
+}
+
+/*! Prints the mean and largest difference in any channel */
+static void print_error(const RrPixel32 *a, const RrPixel32 *b, gint n)
+{
+    gint i, c, d, most = 0;
+    gdouble sum = 0;
+
+    for (i = 0; i < n; ++i)
+        for (c = 0; c < 32; c += 8) {
+            d = ABS((gint)((a[i] >> c) & 0xff) - (gint)((b[i] >> c) & 0xff));
+            sum += d;
+            most = MAX(most, d);
+        }
+    printf(" error %5.2f/%3d", sum / (n * 4), most);
+}
+
+gint main(gint argc, gchar **argv)
+{
+    RrPixel32 *icon, *old, *out, *expect;
+    RrCpuFeatures have;
+    GTimer *timer;
+    guint s, f, k;
+    gint i, n, src, dst;
+    gboolean ok = TRUE;
+
+    n = argc > 1 ? atoi(argv[1]) : 200;
+    src = 256;
+
+    icon = g_new(RrPixel32, src * src);
+    make_icon(icon, src);
+
+    have = RrCpuGetFeatures();
+    timer = g_timer_new();
+
+    for (s = 0; s < N_SIZES; ++s) {
+        dst = sizes[s];
+        printf("%dx%d -> %dx%d (icons per second, error against the old "
+               "code as mean/max)\n", src, src, dst, dst);
+
+        g_timer_start(timer);
+        for (i = 0; i < n; ++i)
+            g_free(old_scale(icon, src, src, dst, dst));
+        g_timer_stop(timer);
+        old = old_scale(icon, src, src, dst, dst);
+        printf("  %-8s %-5s %9.0f\n", "old", "",
+               n / g_timer_elapsed(timer, NULL));
+
+        for (f = 0; f < N_FILTERS; ++f) {
+            expect = NULL;
+            for (k = 0; k < N_KERNELS; ++k) {
+                if ((kernels[k].features & have) != kernels[k].features)
+                    continue;
+                RrCpuLimitFeatures(kernels[k].features);
+
+                g_timer_start(timer);
+                for (i = 0; i < n; ++i)
+                    g_free(RrScale(icon, src, src, dst, dst,
+                                   filters[f].filter));
+                g_timer_stop(timer);
+
+                out = RrScale(icon, src, src, dst, dst, filters[f].filter);
+                printf("  %-8s %-5s %9.0f", filters[f].name, kernels[k].name,
+                       n / g_timer_elapsed(timer, NULL));
+                print_error(old, out, dst * dst);
+
+                if (!expect)
+                    expect = out;
+                else {
+                    if (memcmp(expect, out, dst * dst * sizeof(RrPixel32))) {
+                        printf(" (DIFFERENT)");
+                        ok = FALSE;
+                    }
+                    g_free(out);
+                }
+                printf("\n");
+            }
+            g_free(expect);
+        }
+        RrCpuLimitFeatures(~0);
+        g_free(old);
+    }
+
+    g_timer_destroy(timer);
+    g_free(icon);
+
+    return ok ? 0 : 1;
+}
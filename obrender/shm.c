@@ -0,0 +1,253 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   shm.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "render.h"
+#include "instance.h"
+#include "shm.h"
+
+#ifdef MITSHM
+
+#include <sys/ipc.h>
+#include <sys/shm.h>
+#include <X11/extensions/XShm.h>
+
+/* segments are made in sizes which are powers of two, starting from this */
+#define MIN_SEGMENT_SIZE (64 * 1024)
+/* images bigger than this go through the socket, rather than keeping such a
+   big segment around */
+#define MAX_SEGMENT_SIZE (8 * 1024 * 1024)
+/* the number of segments of each size to keep, so that one can be filled
+   while the server is still reading the others.  when they are all busy the
+   image goes through the socket instead of waiting for the server. */
+#define SEGMENTS_PER_SIZE 3
+
+struct _RrShmSegment {
+    XShmSegmentInfo info;
+    gsize size;
+    gulong serial; /* the request which last read from the segment */
+};
+
+struct _RrShmPool {
+    GSList *segments;
+};
+
+static gboolean attach_failed;
+
+static gint attach_error_handler(Display *d, XErrorEvent *e)
+{
+    attach_failed = TRUE;
+    return 0;
+}
+
+static RrShmSegment* segment_new(Display *d, gsize size)
+{
+    RrShmSegment *s;
+    XErrorHandler old;
+
+    s = g_slice_new(RrShmSegment);
+    s->size = size;
+    s->serial = 0;
+
+    s->info.shmid = shmget(IPC_PRIVATE, size, IPC_CREAT | 0600);
+    if (s->info.shmid < 0) {
+        g_slice_free(RrShmSegment, s);
+        return NULL;
+    }
+    s->info.shmaddr = shmat(s->info.shmid, NULL, 0);
+    s->info.readOnly = True;
+    if (s->info.shmaddr == (gchar*)-1) {
+        shmctl(s->info.shmid, IPC_RMID, NULL);
+        g_slice_free(RrShmSegment, s);
+        return NULL;
+    }
+
+    /* the server can't attach if it is on another machine, and the only way
+       to find out is to try it */
+    XSync(d, FALSE);
+    attach_failed = FALSE;
+    old = XSetErrorHandler(attach_error_handler);
+    XShmAttach(d, &s->info);
+    XSync(d, FALSE);
+    XSetErrorHandler(old);
+
+    /* the segment goes away once both of us have let go of it */
+    shmctl(s->info.shmid, IPC_RMID, NULL);
+
+    if (attach_failed) {
+        shmdt(s->info.shmaddr);
+        g_slice_free(RrShmSegment, s);
+        return NULL;
+    }
+    return s;
+}
+
+static void segment_free(RrShmSegment *s, Display *d)
+{
+    XShmDetach(d, &s->info);
+    shmdt(s->info.shmaddr);
+    g_slice_free(RrShmSegment, s);
+}
+
+/*! Finds a segment of @want bytes which the server is done with, or the one
+  it will be done with first if they are all busy */
+static RrShmSegment* segment_find(RrShmPool *pool, Display *d, gsize want,
+                                  guint *n)
+{
+    GSList *it;
+    RrShmSegment *s, *oldest = NULL;
+
+    *n = 0;
+    for (it = pool->segments; it; it = g_slist_next(it)) {
+        s = it->data;
+        if (s->size != want) continue;
+
+        if (LastKnownRequestProcessed(d) >= s->serial)
+            return s;
+        if (!oldest || s->serial < oldest->serial)
+            oldest = s;
+        ++*n;
+    }
+    return oldest;
+}
+
+/*! Finds a segment of at least @size bytes which the server is done with, or
+  returns NULL if they are all still busy */
+static RrShmSegment* segment_get(RrShmPool *pool, Display *d, gsize size)
+{
+    RrShmSegment *s;
+    gsize want;
+    guint n;
+
+    for (want = MIN_SEGMENT_SIZE; want < size; want <<= 1);
+
+    s = segment_find(pool, d, want, &n);
+    if (s && LastKnownRequestProcessed(d) >= s->serial)
+        return s;
+
+    /* the last request the server is known to have done only moves ahead
+       when something is read from it, so read what it has sent already */
+    if (s) {
+        XEventsQueued(d, QueuedAfterFlush);
+        s = segment_find(pool, d, want, &n);
+        if (s && LastKnownRequestProcessed(d) >= s->serial)
+            return s;
+    }
+
+    if (n < SEGMENTS_PER_SIZE && (s = segment_new(d, want))) {
+        pool->segments = g_slist_prepend(pool->segments, s);
+        return s;
+    }
+    return NULL;
+}
+
+RrShmPool* RrShmPoolNew(Display *d)
+{
+    RrShmPool *pool;
+    RrShmSegment *s;
+
+    if (!XShmQueryExtension(d))
+        return NULL;
+    if (!(s = segment_new(d, MIN_SEGMENT_SIZE)))
+        return NULL;
+
+    pool = g_slice_new(RrShmPool);
+    pool->segments = g_slist_prepend(NULL, s);
+    return pool;
+}
+
+void RrShmPoolFree(RrShmPool *pool, Display *d)
+{
+    if (pool) {
+        GSList *it;
+
+        for (it = pool->segments; it; it = g_slist_next(it))
+            segment_free(it->data, d);
+        g_slist_free(pool->segments);
+        g_slice_free(RrShmPool, pool);
+    }
+}
+
+XImage* RrShmImageNew(const RrInstance *inst, gint w, gint h,
+                      RrShmSegment **seg)
+{
+    RrShmPool *pool = RrShm(inst);
+    Display *d = RrDisplay(inst);
+    XImage *im;
+    RrShmSegment *s = NULL;
+    gsize size;
+
+    if (!pool) return NULL;
+
+    /* make the image first to find out how much memory it needs */
+    im = XShmCreateImage(d, RrVisual(inst), RrDepth(inst), ZPixmap,
+                         NULL, NULL, w, h);
+    if (!im) return NULL;
+
+    size = (gsize)im->bytes_per_line * h;
+    if (size <= MAX_SEGMENT_SIZE)
+        s = segment_get(pool, d, size);
+    if (!s) {
+        XDestroyImage(im);
+        return NULL;
+    }
+
+    im->data = s->info.shmaddr;
+    im->obdata = (XPointer)&s->info;
+    *seg = s;
+    return im;
+}
+
+void RrShmPutImage(const RrInstance *inst, Drawable d, XImage *im,
+                   RrShmSegment *seg, gint x, gint y)
+{
+    Display *dpy = RrDisplay(inst);
+
+    seg->serial = NextRequest(dpy);
+    XShmPutImage(dpy, d, DefaultGC(dpy, RrScreen(inst)), im,
+                 0, 0, x, y, im->width, im->height, FALSE);
+
+    /* the data and segment info belong to the segment */
+    im->data = NULL;
+    im->obdata = NULL;
+    XDestroyImage(im);
+}
+
+#else
+
+RrShmPool* RrShmPoolNew(Display *d)
+{
+    return NULL;
+}
+
+void RrShmPoolFree(RrShmPool *pool, Display *d)
+{
+}
+
+XImage* RrShmImageNew(const RrInstance *inst, gint w, gint h,
+                      RrShmSegment **seg)
+{
+    return NULL;
+}
+
+void RrShmPutImage(const RrInstance *inst, Drawable d, XImage *im,
+                   RrShmSegment *seg, gint x, gint y)
+{
+    g_assert_not_reached();
+}
+
+#endif
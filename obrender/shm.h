@@ -0,0 +1,51 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   shm.h for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __render_shm_h
+#define __render_shm_h
+
+#include "render.h"
+
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <glib.h>
+
+typedef struct _RrShmPool    RrShmPool;
+typedef struct _RrShmSegment RrShmSegment;
+
+/*! Makes a pool of shared memory segments for the instance, or returns NULL
+  if the X server can't share memory with us. */
+RrShmPool* RrShmPoolNew(Display *d);
+void RrShmPoolFree(RrShmPool *pool, Display *d);
+
+/*! Creates an image of the given size, with its data in a shared memory
+  segment from the instance's pool.  Returns NULL if shared memory can't be
+  used, or the X server is still reading all of the pool's segments of that
+  size, and the image has to be sent through XPutImage instead.
+  @param seg Returns the segment holding the image's data, to be passed to
+    RrShmPutImage().
+*/
+XImage* RrShmImageNew(const RrInstance *inst, gint w, gint h,
+                      RrShmSegment **seg);
+/*! Copies the image to the drawable, and destroys the image.  The segment
+  goes back into the pool, and is used again once the X server is done
+  reading it. */
+void RrShmPutImage(const RrInstance *inst, Drawable d, XImage *im,
+                   RrShmSegment *seg, gint x, gint y);
+
+#endif
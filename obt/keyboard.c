@@ -21,6 +21,7 @@
 
 #include <X11/Xlib.h>
 #include <X11/keysym.h>
+#include <stdlib.h>
 
 struct _ObtIC
 {
@@ -43,6 +44,7 @@ struct _ObtIC
 
 static void set_modkey_mask(guchar mask, KeySym sym);
 static void xim_init(void);
+static void keysym_index_build(void);
 void obt_keyboard_shutdown();
 void obt_keyboard_context_renew(ObtIC *ic);
 
@@ -59,6 +61,11 @@ static gboolean hyper_l = FALSE;
 
 static gboolean started = FALSE;
 
+/*! The KeyCodes for each KeySym in the keymap, found by the KeySym.  Each
+  one points to its KeyCodes in keysym_codes, which end with a 0. */
+static GHashTable *keysym_index = NULL;
+static KeyCode *keysym_codes = NULL;
+
 static XIM xim = NULL;
 static XIMStyle xim_style = 0;
 static GSList *xic_all = NULL;
@@ -112,6 +119,8 @@ void obt_keyboard_reload(void)
     modkeys_keys[OBT_KEYBOARD_MODKEY_CAPSLOCK] = LockMask;
     modkeys_keys[OBT_KEYBOARD_MODKEY_SHIFT] = ShiftMask;
     modkeys_keys[OBT_KEYBOARD_MODKEY_CONTROL] = ControlMask;
+
+    keysym_index_build();
 }
 
 void obt_keyboard_shutdown(void)
@@ -122,6 +131,10 @@ void obt_keyboard_shutdown(void)
     modmap = NULL;
     XFree(keymap);
     keymap = NULL;
+    if (keysym_index) g_hash_table_destroy(keysym_index);
+    keysym_index = NULL;
+    g_free(keysym_codes);
+    keysym_codes = NULL;
     for (it = xic_all; it; it = g_slist_next(it)) {
         ObtIC* ic = it->data;
         if (ic->xic) {
@@ -266,24 +279,114 @@ static void set_modkey_mask(guchar mask, KeySym sym)
     /* CapsLock, Shift, and Control are special and hard-coded */
 }
 
-KeyCode* obt_keyboard_keysym_to_keycode(KeySym sym)
+typedef struct {
+    KeySym sym;
+    gint column;
+    KeyCode code;
+} KeysymEntry;
+
+static gint keysym_entry_cmp(const void *a, const void *b)
 {
-    KeyCode *ret;
-    gint i, j, n;
+    const KeysymEntry *ea = a, *eb = b;
 
-    ret = g_new(KeyCode, 1);
-    n = 0;
-    ret[n] = 0;
+    if (ea->sym != eb->sym)
+        return ea->sym < eb->sym ? -1 : 1;
+    if (ea->column != eb->column)
+        return ea->column - eb->column;
+    return ea->code - eb->code;
+}
+
+/*! Returns the KeySym for a column of a key, the way XKeycodeToKeysym()
+  reports it.  Keys with NoSymbol in the second column of a group have the
+  lowercase and uppercase of the first KeySym in the group, as in the core
+  protocol's rule, so a key mapped to just "a" also gives "A". */
+static KeySym keymap_column(gint code, gint col)
+{
+    const KeySym *syms = &keymap[(code - min_keycode) * keysyms_per_keycode];
+    gint per = keysyms_per_keycode;
+    KeySym lsym, usym;
+
+    if (col < 4) {
+        if (col > 1) {
+            while (per > 2 && syms[per-1] == NoSymbol) --per;
+            /* there is only one group, so use the first one again */
+            if (per < 3) col -= 2;
+        }
+        if (per <= (col | 1) || syms[col | 1] == NoSymbol) {
+            XConvertCase(syms[col & ~1], &lsym, &usym);
+            if (!(col & 1))
+                return lsym;
+            return usym == lsym ? NoSymbol : usym;
+        }
+    }
+    return syms[col];
+}
+
+static void keysym_index_build(void)
+{
+    KeysymEntry *e;
+    gint i, j, k, n, start;
 
-    /* go through each keycode and look for the keysym */
+    keysym_index = g_hash_table_new(g_direct_hash, g_direct_equal);
+    if (!keymap) return;
+
+    /* find every KeySym in the keymap */
+    e = g_new(KeysymEntry,
+              (max_keycode - min_keycode + 1) * keysyms_per_keycode);
+    n = 0;
     for (i = min_keycode; i <= max_keycode; ++i)
-        for (j = 0; j < keysyms_per_keycode; ++j)
-            if (sym == keymap[(i-min_keycode) * keysyms_per_keycode + j]) {
-                ret = g_renew(KeyCode, ret, ++n + 1);
-                ret[n-1] = i;
-                ret[n] = 0;
+        for (j = 0; j < keysyms_per_keycode; ++j) {
+            KeySym sym = keymap_column(i, j);
+            if (sym != NoSymbol) {
+                e[n].sym = sym;
+                e[n].column = j;
+                e[n].code = i;
+                ++n;
             }
-    return ret;
+        }
+
+    /* put them together by KeySym, and then in the order that
+       XKeysymToKeycode() picks them, by column and then by KeyCode */
+    qsort(e, n, sizeof(KeysymEntry), keysym_entry_cmp);
+
+    /* at most one 0 after each KeyCode */
+    keysym_codes = g_new(KeyCode, 2 * n);
+    k = 0;
+    for (i = 0; i < n; i = j) {
+        start = k;
+        for (j = i; j < n && e[j].sym == e[i].sym; ++j) {
+            gint c;
+
+            /* a key can have the same KeySym in more than one column */
+            for (c = start; c < k && keysym_codes[c] != e[j].code; ++c);
+            if (c == k)
+                keysym_codes[k++] = e[j].code;
+        }
+        keysym_codes[k++] = 0;
+        g_hash_table_insert(keysym_index, GUINT_TO_POINTER(e[i].sym),
+                            &keysym_codes[start]);
+    }
+    g_free(e);
+}
+
+const KeyCode* obt_keyboard_keysym_keycodes(KeySym sym)
+{
+    static const KeyCode none = 0;
+    const KeyCode *ret = NULL;
+
+    if (keysym_index)
+        ret = g_hash_table_lookup(keysym_index, GUINT_TO_POINTER(sym));
+    return ret ? ret : &none;
+}
+
+KeyCode* obt_keyboard_keysym_to_keycode(KeySym sym)
+{
+    const KeyCode *codes;
+    gint n;
+
+    codes = obt_keyboard_keysym_keycodes(sym);
+    for (n = 0; codes[n]; ++n);
+    return g_memdup(codes, (n + 1) * sizeof(KeyCode));
 }
 
 gunichar obt_keyboard_keypress_to_unichar(ObtIC *ic, XEvent *ev)
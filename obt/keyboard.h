@@ -59,7 +59,14 @@ guint obt_keyboard_only_modmasks(guint mask);
   right keys when there are both. */
 guint obt_keyboard_modkey_to_modmask(ObtModkeysKey key);
 
-/*! Convert a KeySym to all the KeyCodes which generate it. */
+/*! Convert a KeySym to all the KeyCodes which generate it, ending with a 0.
+  They are in the order that XKeysymToKeycode() picks them, so the first one
+  is the KeyCode that it gives.  The list belongs to obt and is valid until
+  the keyboard is reloaded. */
+const KeyCode* obt_keyboard_keysym_keycodes(KeySym sym);
+
+/*! Convert a KeySym to all the KeyCodes which generate it, the same as
+  obt_keyboard_keysym_keycodes(), in a copy to be freed with g_free(). */
 KeyCode* obt_keyboard_keysym_to_keycode(KeySym sym);
 
 /*! Translate a KeyPress event to the unicode character it represents */
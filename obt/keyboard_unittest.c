@@ -0,0 +1,195 @@
+#include "obt/unittest_base.h"
+
+#include "obt/internal.h"
+#include "obt/keyboard.h"
+
+#include <glib.h>
+#include <stdlib.h>
+#include <string.h>
+#include <X11/Xlib.h>
+#include <X11/keysym.h>
+
+/* The keymap that obt_keyboard_reload() reads, in place of the X server's.
+   These take the place of the Xlib functions which it calls. */
+
+#define MIN_KEYCODE 10
+#define PER_KEYCODE 4
+
+static const KeySym test_keymap[][PER_KEYCODE] = {
+    /* 10: only one KeySym, so the uppercase is in the second column, and
+       columns 2 and 3 are the same as 0 and 1 */
+    { XK_a, NoSymbol, NoSymbol, NoSymbol },
+    /* 11: two groups */
+    { XK_b, XK_B, XK_c, XK_C },
+    /* 12: one group with both cases, repeated in columns 2 and 3 */
+    { XK_x, XK_X, NoSymbol, NoSymbol },
+    /* 13, 14 and 15: Return in column 0 of two keys and column 1 of one */
+    { XK_Return, NoSymbol, NoSymbol, NoSymbol },
+    { XK_KP_Enter, XK_Return, NoSymbol, NoSymbol },
+    { XK_Return, NoSymbol, NoSymbol, NoSymbol },
+    /* 16: two groups, with only one KeySym in the second */
+    { XK_d, NoSymbol, XK_e, NoSymbol }
+};
+
+int XDisplayKeycodes(Display *d, int *min_keycode, int *max_keycode)
+{
+    *min_keycode = MIN_KEYCODE;
+    *max_keycode = MIN_KEYCODE + G_N_ELEMENTS(test_keymap) - 1;
+    return 1;
+}
+
+KeySym* XGetKeyboardMapping(Display *d,
+#if NeedWidePrototypes
+                            unsigned int first,
+#else
+                            KeyCode first,
+#endif
+                            int count, int *per)
+{
+    /* it is freed with XFree() */
+    KeySym *syms = malloc(sizeof(test_keymap));
+
+    g_assert(first == MIN_KEYCODE);
+    g_assert(count == G_N_ELEMENTS(test_keymap));
+    memcpy(syms, test_keymap, sizeof(test_keymap));
+    *per = PER_KEYCODE;
+    return syms;
+}
+
+XModifierKeymap* XGetModifierMapping(Display *d)
+{
+    return XNewModifiermap(0);
+}
+
+XIM XOpenIM(Display *d, struct _XrmHashBucketRec *rdb,
+            char *res_name, char *res_class)
+{
+    return NULL;
+}
+
+static guint count(const KeyCode *codes)
+{
+    guint n;
+
+    for (n = 0; codes[n]; ++n);
+    return n;
+}
+
+static void missing() {
+    TEST_START();
+
+    obt_keyboard_reload();
+
+    /* A KeySym which no key has. */
+    EXPECT_UINT_EQ(0, count(obt_keyboard_keysym_keycodes(XK_z)));
+
+    obt_keyboard_shutdown();
+
+    TEST_END();
+}
+
+static void nosymbol_second_column() {
+    TEST_START();
+
+    const KeyCode *codes;
+
+    obt_keyboard_reload();
+
+    /* The key with only "a" gives "A" in the second column. */
+    codes = obt_keyboard_keysym_keycodes(XK_a);
+    EXPECT_UINT_EQ(1, count(codes));
+    EXPECT_UINT_EQ(10, codes[0]);
+
+    codes = obt_keyboard_keysym_keycodes(XK_A);
+    EXPECT_UINT_EQ(1, count(codes));
+    EXPECT_UINT_EQ(10, codes[0]);
+
+    obt_keyboard_shutdown();
+
+    TEST_END();
+}
+
+static void one_group() {
+    TEST_START();
+
+    const KeyCode *codes;
+
+    obt_keyboard_reload();
+
+    /* Keys with one group give it again in columns 2 and 3, and each key is
+       only listed once even though it has the KeySym twice. */
+    codes = obt_keyboard_keysym_keycodes(XK_x);
+    EXPECT_UINT_EQ(1, count(codes));
+    EXPECT_UINT_EQ(12, codes[0]);
+
+    codes = obt_keyboard_keysym_keycodes(XK_X);
+    EXPECT_UINT_EQ(1, count(codes));
+    EXPECT_UINT_EQ(12, codes[0]);
+
+    /* Keys with two groups keep the second one. */
+    codes = obt_keyboard_keysym_keycodes(XK_c);
+    EXPECT_UINT_EQ(1, count(codes));
+    EXPECT_UINT_EQ(11, codes[0]);
+
+    codes = obt_keyboard_keysym_keycodes(XK_C);
+    EXPECT_UINT_EQ(1, count(codes));
+    EXPECT_UINT_EQ(11, codes[0]);
+
+    /* A second group with NoSymbol after its first KeySym is still a second
+       group, and gets the uppercase too. */
+    codes = obt_keyboard_keysym_keycodes(XK_D);
+    EXPECT_UINT_EQ(1, count(codes));
+    EXPECT_UINT_EQ(16, codes[0]);
+
+    codes = obt_keyboard_keysym_keycodes(XK_e);
+    EXPECT_UINT_EQ(1, count(codes));
+    EXPECT_UINT_EQ(16, codes[0]);
+
+    codes = obt_keyboard_keysym_keycodes(XK_E);
+    EXPECT_UINT_EQ(1, count(codes));
+    EXPECT_UINT_EQ(16, codes[0]);
+
+    obt_keyboard_shutdown();
+
+    TEST_END();
+}
+
+static void keycode_order() {
+    TEST_START();
+
+    const KeyCode *codes;
+    KeyCode *copy;
+
+    obt_keyboard_reload();
+
+    /* The keys with Return in column 0 come first, in KeyCode order, and
+       then the one with it in column 1. */
+    codes = obt_keyboard_keysym_keycodes(XK_Return);
+    EXPECT_UINT_EQ(3, count(codes));
+    EXPECT_UINT_EQ(13, codes[0]);
+    EXPECT_UINT_EQ(15, codes[1]);
+    EXPECT_UINT_EQ(14, codes[2]);
+
+    /* The copy has the same KeyCodes. */
+    copy = obt_keyboard_keysym_to_keycode(XK_Return);
+    EXPECT_UINT_EQ(3, count(copy));
+    EXPECT_UINT_EQ(13, copy[0]);
+    EXPECT_UINT_EQ(15, copy[1]);
+    EXPECT_UINT_EQ(14, copy[2]);
+    g_free(copy);
+
+    obt_keyboard_shutdown();
+
+    TEST_END();
+}
+
+void run_keyboard_unittest() {
+    unittest_start_suite("keyboard");
+
+    missing();
+    nosymbol_second_column();
+    one_group();
+    keycode_order();
+
+    unittest_end_suite();
+}
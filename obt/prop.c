@@ -21,13 +21,61 @@
 #include "obt/display.h"
 
 #include <X11/Xatom.h>
+#include <X11/Xutil.h>
 #ifdef HAVE_STRING_H
 #  include <string.h>
 #endif
+#ifdef HAVE_STDLIB_H
+#  include <stdlib.h> /* for free() of xcb's replies */
+#endif
+#ifdef USE_XCB
+#  include <X11/Xlib-xcb.h>
+#  include <xcb/xcb.h>
+#endif
+
+/* from the ICCCM, the number of elements in the WM_HINTS and
+   WM_NORMAL_HINTS properties */
+#define NUM_WM_HINTS 9
+#define NUM_SIZE_HINTS 18
+#define NUM_OLD_SIZE_HINTS 15
+
+typedef struct _ObtPropKey {
+    Window win;
+    Atom prop;
+} ObtPropKey;
+
+/*! The value of a property which was asked for ahead of time, or which is
+  being kept for a window in the cache */
+typedef struct _ObtPropValue {
+    ObtPropKey key;
+    gboolean waiting; /* the reply has not been read yet */
+    gboolean temporary; /* forget it once it has been read */
+    gboolean exists;
+    Atom type;
+    gint format;
+    gulong nitems;
+    guchar *data; /* followed by a nul byte, like Xlib gives for text */
+#ifdef USE_XCB
+    xcb_get_property_cookie_t cookie;
+#endif
+} ObtPropValue;
 
 Atom prop_atoms[OBT_PROP_NUM_ATOMS];
 gboolean prop_started = FALSE;
 
+static GHashTable *prefetched = NULL; /* ObtPropKey -> ObtPropValue */
+static GHashTable *cached = NULL; /* windows which have their values kept */
+
+static gulong stat_hits = 0; /* reads answered without asking the server */
+static gulong stat_misses = 0; /* reads of cached windows that had to ask */
+
+/* values bigger than this are not kept in the cache, they are mostly icons
+   which are only read once for each change anyways */
+#define CACHE_MAX_BYTES (16 * 1024)
+
+static void copy_items(guchar *data, const guchar *xdata, gint size,
+                       gulong num, gboolean xlib);
+
 #define CREATE_NAME(var, name) (prop_atoms[OBT_PROP_##var] = \
                                 XInternAtom((obt_display), (name), FALSE))
 #define CREATE(var) CREATE_NAME(var, #var)
@@ -209,6 +257,271 @@ Atom obt_prop_atom(ObtPropAtom a)
     return prop_atoms[a];
 }
 
+static guint key_hash(gconstpointer p)
+{
+    const ObtPropKey *k = p;
+    return k->win * 31 + k->prop;
+}
+
+static gboolean key_equal(gconstpointer p1, gconstpointer p2)
+{
+    const ObtPropKey *k1 = p1, *k2 = p2;
+    return k1->win == k2->win && k1->prop == k2->prop;
+}
+
+static guint window_hash(Window *w) { return *w; }
+static gboolean window_comp(Window *w1, Window *w2) { return *w1 == *w2; }
+
+static void value_free(gpointer p)
+{
+    ObtPropValue *v = p;
+
+#ifdef USE_XCB
+    /* nobody asked for it in the end */
+    if (v->waiting)
+        xcb_discard_reply(XGetXCBConnection(obt_display),
+                          v->cookie.sequence);
+#endif
+    g_free(v->data);
+    g_slice_free(ObtPropValue, v);
+}
+
+#ifdef USE_XCB
+static void value_wait(ObtPropValue *v)
+{
+    xcb_connection_t *conn = XGetXCBConnection(obt_display);
+    xcb_get_property_reply_t *r;
+    xcb_generic_error_t *err = NULL;
+
+    v->waiting = FALSE;
+    r = xcb_get_property_reply(conn, v->cookie, &err);
+    /* an error means the window is gone, same as the property not existing */
+    if (r && r->type != XCB_NONE) {
+        const gint len = xcb_get_property_value_length(r);
+
+        v->exists = TRUE;
+        v->type = r->type;
+        v->format = r->format;
+        v->nitems = r->value_len;
+        v->data = g_malloc(len + 1);
+        memcpy(v->data, xcb_get_property_value(r), len);
+        v->data[len] = '\0';
+    }
+    free(r);
+    free(err);
+}
+#endif
+
+/*! Reads the whole property from the server, in the same format that the
+  prefetched values use */
+static ObtPropValue* value_read(Window win, Atom prop)
+{
+    ObtPropValue *v;
+    gint res;
+    guchar *xdata = NULL;
+    Atom ret_type;
+    gint ret_size;
+    gulong ret_items, bytes_left;
+
+    v = g_slice_new0(ObtPropValue);
+    v->key.win = win;
+    v->key.prop = prop;
+
+    res = XGetWindowProperty(obt_display, win, prop, 0l, G_MAXLONG,
+                             FALSE, AnyPropertyType, &ret_type, &ret_size,
+                             &ret_items, &bytes_left, &xdata);
+    if (res == Success && ret_type != None) {
+        const gint len = ret_items * (ret_size / 8);
+
+        v->exists = TRUE;
+        v->type = ret_type;
+        v->format = ret_size;
+        v->nitems = ret_items;
+        v->data = g_malloc(len + 1);
+        if (ret_size == 8 || ret_size == 16 || ret_size == 32)
+            copy_items(v->data, xdata, ret_size, ret_items, TRUE);
+        v->data[len] = '\0';
+    }
+    if (xdata) XFree(xdata);
+    return v;
+}
+
+static gboolean is_cached(Window win)
+{
+    return cached && g_hash_table_lookup(cached, &win);
+}
+
+/*! Returns the value of the property if it was asked for ahead of time with
+  obt_prop_prefetch(), or if the window is in the cache.  Returns NULL if it
+  has to be read from the server. */
+static ObtPropValue* prefetch_lookup(Window win, Atom prop)
+{
+    ObtPropKey k;
+    ObtPropValue *v = NULL;
+
+    k.win = win;
+    k.prop = prop;
+    if (prefetched)
+        v = g_hash_table_lookup(prefetched, &k);
+    if (v) {
+#ifdef USE_XCB
+        if (v->waiting)
+            value_wait(v);
+#endif
+        ++stat_hits;
+    }
+    else if (is_cached(win)) {
+        v = value_read(win, prop);
+        v->temporary = v->exists &&
+            v->nitems * (v->format / 8) > CACHE_MAX_BYTES;
+        if (!prefetched)
+            prefetched = g_hash_table_new_full(key_hash, key_equal,
+                                               NULL, value_free);
+        g_hash_table_replace(prefetched, &v->key, v);
+        ++stat_misses;
+    }
+    return v;
+}
+
+/*! Call when done reading a value from prefetch_lookup(). */
+static void prefetch_release(ObtPropValue *v)
+{
+    if (v->temporary)
+        g_hash_table_remove(prefetched, &v->key);
+}
+
+static void prefetch_forget(Window win, Atom prop)
+{
+    ObtPropKey k;
+
+    if (!prefetched) return;
+
+    k.win = win;
+    k.prop = prop;
+    g_hash_table_remove(prefetched, &k);
+}
+
+static gboolean prefetch_forget_window(gpointer key, gpointer value,
+                                       gpointer data)
+{
+    return ((ObtPropKey*)key)->win == *(Window*)data;
+}
+
+void obt_prop_prefetch(Window win, const Atom *props, guint n)
+{
+#ifdef USE_XCB
+    xcb_connection_t *conn = XGetXCBConnection(obt_display);
+    guint i;
+
+    if (!prefetched)
+        prefetched = g_hash_table_new_full(key_hash, key_equal,
+                                           NULL, value_free);
+
+    for (i = 0; i < n; ++i) {
+        ObtPropValue *v;
+
+        v = g_slice_new0(ObtPropValue);
+        v->key.win = win;
+        v->key.prop = props[i];
+        v->waiting = TRUE;
+        /* send the request now, the reply is read when it is needed */
+        v->cookie = xcb_get_property(conn, FALSE, win, props[i],
+                                     XCB_GET_PROPERTY_TYPE_ANY,
+                                     0, G_MAXUINT32 / 4);
+        g_hash_table_replace(prefetched, &v->key, v);
+    }
+    xcb_flush(conn);
+#else
+    /* there is no way to pipeline the requests, so just read them as they
+       are needed */
+    (void)win; (void)props; (void)n;
+#endif
+}
+
+void obt_prop_prefetch_done(Window win)
+{
+    /* the values are kept up to date for cached windows */
+    if (!prefetched || is_cached(win)) return;
+
+    g_hash_table_foreach_remove(prefetched, prefetch_forget_window, &win);
+    if (!g_hash_table_size(prefetched)) {
+        g_hash_table_destroy(prefetched);
+        prefetched = NULL;
+    }
+}
+
+void obt_prop_cache_window(Window win, gboolean cache)
+{
+    if (cache) {
+        Window *w;
+
+        if (!cached)
+            cached = g_hash_table_new_full((GHashFunc)window_hash,
+                                           (GEqualFunc)window_comp,
+                                           NULL, g_free);
+        if (is_cached(win)) return;
+
+        w = g_new(Window, 1);
+        *w = win;
+        g_hash_table_insert(cached, w, w);
+    }
+    else if (is_cached(win)) {
+        g_hash_table_remove(cached, &win);
+        obt_prop_prefetch_done(win);
+    }
+}
+
+void obt_prop_cache_event(const XEvent *e)
+{
+    if (e->type == PropertyNotify)
+        prefetch_forget(e->xproperty.window, e->xproperty.atom);
+    else if (e->type == DestroyNotify)
+        /* the window id can be used again for another window */
+        obt_prop_cache_window(e->xdestroywindow.window, FALSE);
+}
+
+void obt_prop_cache_stats(gulong *hits, gulong *misses)
+{
+    *hits = stat_hits;
+    *misses = stat_misses;
+}
+
+/*! Copies items from a property's data, which is in the server's format,
+  into @data with the given size */
+static void copy_items(guchar *data, const guchar *xdata, gint size,
+                       gulong num, gboolean xlib)
+{
+    gulong i;
+
+    for (i = 0; i < num; ++i)
+        switch (size) {
+        case 8:
+            data[i] = xdata[i];
+            break;
+        case 16:
+            ((guint16*)data)[i] = ((gushort*)xdata)[i];
+            break;
+        case 32:
+            /* Xlib gives 32 bit data as longs, but xcb gives it as is */
+            if (xlib)
+                ((guint32*)data)[i] = ((gulong*)xdata)[i];
+            else
+                ((guint32*)data)[i] = ((guint32*)xdata)[i];
+            break;
+        default:
+            g_assert_not_reached(); /* unhandled size */
+        }
+}
+
+/*! Gives back the prefetched value when it can be used in place of a
+  XGetWindowProperty call asking for @type.  XGetWindowProperty gives no
+  data when the type does not match. */
+static gboolean prefetch_matches(ObtPropValue *v, Atom type, gint size)
+{
+    return v->exists && v->nitems > 0 && v->format == size &&
+        (type == AnyPropertyType || v->type == type);
+}
+
 static gboolean get_prealloc(Window win, Atom prop, Atom type, gint size,
                              guchar *data, gulong num)
 {
@@ -219,27 +532,23 @@ static gboolean get_prealloc(Window win, Atom prop, Atom type, gint size,
     gint ret_size;
     gulong ret_items, bytes_left;
     glong num32 = 32 / size * num; /* num in 32-bit elements */
+    ObtPropValue *v;
+
+    if ((v = prefetch_lookup(win, prop))) {
+        if (prefetch_matches(v, type, size) && v->nitems >= num) {
+            copy_items(data, v->data, size, num, FALSE);
+            ret = TRUE;
+        }
+        prefetch_release(v);
+        return ret;
+    }
 
     res = XGetWindowProperty(obt_display, win, prop, 0l, num32,
                              FALSE, type, &ret_type, &ret_size,
                              &ret_items, &bytes_left, &xdata);
     if (res == Success && ret_items && xdata) {
         if (ret_size == size && ret_items >= num) {
-            guint i;
-            for (i = 0; i < num; ++i)
-                switch (size) {
-                case 8:
-                    data[i] = xdata[i];
-                    break;
-                case 16:
-                    ((guint16*)data)[i] = ((gushort*)xdata)[i];
-                    break;
-                case 32:
-                    ((guint32*)data)[i] = ((gulong*)xdata)[i];
-                    break;
-                default:
-                    g_assert_not_reached(); /* unhandled size */
-                }
+            copy_items(data, xdata, size, num, TRUE);
             ret = TRUE;
         }
         XFree(xdata);
@@ -256,29 +565,26 @@ static gboolean get_all(Window win, Atom prop, Atom type, gint size,
     Atom ret_type;
     gint ret_size;
     gulong ret_items, bytes_left;
+    ObtPropValue *v;
+
+    if ((v = prefetch_lookup(win, prop))) {
+        if (prefetch_matches(v, type, size)) {
+            *data = g_malloc(v->nitems * (size / 8));
+            copy_items(*data, v->data, size, v->nitems, FALSE);
+            *num = v->nitems;
+            ret = TRUE;
+        }
+        prefetch_release(v);
+        return ret;
+    }
 
     res = XGetWindowProperty(obt_display, win, prop, 0l, G_MAXLONG,
                              FALSE, type, &ret_type, &ret_size,
                              &ret_items, &bytes_left, &xdata);
     if (res == Success) {
         if (ret_size == size && ret_items > 0) {
-            guint i;
-
             *data = g_malloc(ret_items * (size / 8));
-            for (i = 0; i < ret_items; ++i)
-                switch (size) {
-                case 8:
-                    (*data)[i] = xdata[i];
-                    break;
-                case 16:
-                    ((guint16*)*data)[i] = ((gushort*)xdata)[i];
-                    break;
-                case 32:
-                    ((guint32*)*data)[i] = ((gulong*)xdata)[i];
-                    break;
-                default:
-                    g_assert_not_reached(); /* unhandled size */
-                }
+            copy_items(*data, xdata, size, ret_items, TRUE);
             *num = ret_items;
             ret = TRUE;
         }
@@ -294,12 +600,28 @@ static gboolean get_all(Window win, Atom prop, Atom type, gint size,
   @param type 0 to get text of any type, or a value from
     ObtPropTextType to restrict the value to a specific type.
   @return TRUE if the text was read and validated against the @type, and FALSE
-    otherwise.
+    otherwise.  The value in the XTextProperty must be freed with
+    free_text_property() either way.
 */
 static gboolean get_text_property(Window win, Atom prop,
                                   XTextProperty *tprop, ObtPropTextType type)
 {
-    if (!(XGetTextProperty(obt_display, win, tprop, prop) && tprop->nitems))
+    ObtPropValue *v;
+
+    if ((v = prefetch_lookup(win, prop))) {
+        /* the value belongs to the prefetched property, so don't free it */
+        tprop->value = NULL;
+        if (!(v->exists && v->nitems)) {
+            prefetch_release(v);
+            return FALSE;
+        }
+        tprop->value = v->data;
+        tprop->encoding = v->type;
+        tprop->format = v->format;
+        tprop->nitems = v->nitems;
+    }
+    else if (!(XGetTextProperty(obt_display, win, tprop, prop) &&
+               tprop->nitems))
         return FALSE;
     if (!type)
         return TRUE; /* no type checking */
@@ -318,6 +640,21 @@ static gboolean get_text_property(Window win, Atom prop,
     }
 }
 
+static void free_text_property(Window win, Atom prop, XTextProperty *tprop)
+{
+    ObtPropKey k;
+    ObtPropValue *v = NULL;
+
+    k.win = win;
+    k.prop = prop;
+    if (prefetched)
+        v = g_hash_table_lookup(prefetched, &k);
+    if (v && tprop->value == v->data)
+        prefetch_release(v);
+    else
+        XFree(tprop->value);
+}
+
 /*! Returns one or more UTF-8 encoded strings from the text property.
   @param tprop The XTextProperty to convert into UTF-8 string(s).
   @param type The type which specifies the format that the text must meet, or
@@ -481,6 +818,74 @@ gboolean obt_prop_get_array32(Window win, Atom prop, Atom type, guint32 **ret,
     return get_all(win, prop, type, 32, (guchar**)ret, nret);
 }
 
+XWMHints* obt_prop_get_wm_hints(Window win)
+{
+    guint32 *data;
+    guint num;
+    XWMHints *hints = NULL;
+
+    /* this reads the property the same way as XGetWMHints */
+    if (get_all(win, XA_WM_HINTS, XA_WM_HINTS, 32, (guchar**)&data, &num)) {
+        if (num >= NUM_WM_HINTS - 1 && (hints = XAllocWMHints())) {
+            hints->flags = data[0];
+            hints->input = data[1] ? True : False;
+            hints->initial_state = (gint32)data[2];
+            hints->icon_pixmap = data[3];
+            hints->icon_window = data[4];
+            hints->icon_x = (gint32)data[5];
+            hints->icon_y = (gint32)data[6];
+            hints->icon_mask = data[7];
+            hints->window_group = num >= NUM_WM_HINTS ? data[8] : None;
+        }
+        g_free(data);
+    }
+    return hints;
+}
+
+gboolean obt_prop_get_wm_normal_hints(Window win, XSizeHints *hints)
+{
+    guint32 *data;
+    guint num;
+    glong supplied;
+
+    /* this reads the property the same way as XGetWMNormalHints */
+    if (!get_all(win, XA_WM_NORMAL_HINTS, XA_WM_SIZE_HINTS, 32,
+                 (guchar**)&data, &num))
+        return FALSE;
+    if (num < NUM_OLD_SIZE_HINTS) {
+        g_free(data);
+        return FALSE;
+    }
+
+    hints->flags = data[0];
+    hints->x = (gint32)data[1];
+    hints->y = (gint32)data[2];
+    hints->width = (gint32)data[3];
+    hints->height = (gint32)data[4];
+    hints->min_width = (gint32)data[5];
+    hints->min_height = (gint32)data[6];
+    hints->max_width = (gint32)data[7];
+    hints->max_height = (gint32)data[8];
+    hints->width_inc = (gint32)data[9];
+    hints->height_inc = (gint32)data[10];
+    hints->min_aspect.x = (gint32)data[11];
+    hints->min_aspect.y = (gint32)data[12];
+    hints->max_aspect.x = (gint32)data[13];
+    hints->max_aspect.y = (gint32)data[14];
+
+    supplied = USPosition | USSize | PAllHints;
+    if (num >= NUM_SIZE_HINTS) {
+        hints->base_width = (gint32)data[15];
+        hints->base_height = (gint32)data[16];
+        hints->win_gravity = (gint32)data[17];
+        supplied |= PBaseSize | PWinGravity;
+    }
+    hints->flags &= supplied;
+
+    g_free(data);
+    return TRUE;
+}
+
 gboolean obt_prop_get_text(Window win, Atom prop, ObtPropTextType type,
                            gchar **ret_string)
 {
@@ -496,7 +901,7 @@ gboolean obt_prop_get_text(Window win, Atom prop, ObtPropTextType type,
             ret = TRUE;
         }
     }
-    XFree(tprop.value);
+    free_text_property(win, prop, &tprop);
     return ret;
 }
 
@@ -516,12 +921,13 @@ gboolean obt_prop_get_array_text(Window win, Atom prop,
             ret = TRUE;
         }
     }
-    XFree(tprop.value);
+    free_text_property(win, prop, &tprop);
     return ret;
 }
 
 void obt_prop_set32(Window win, Atom prop, Atom type, gulong val)
 {
+    prefetch_forget(win, prop);
     XChangeProperty(obt_display, win, prop, type, 32, PropModeReplace,
                     (guchar*)&val, 1);
 }
@@ -529,12 +935,14 @@ void obt_prop_set32(Window win, Atom prop, Atom type, gulong val)
 void obt_prop_set_array32(Window win, Atom prop, Atom type, gulong *val,
                       guint num)
 {
+    prefetch_forget(win, prop);
     XChangeProperty(obt_display, win, prop, type, 32, PropModeReplace,
                     (guchar*)val, num);
 }
 
 void obt_prop_set_text(Window win, Atom prop, const gchar *val)
 {
+    prefetch_forget(win, prop);
     XChangeProperty(obt_display, win, prop, OBT_PROP_ATOM(UTF8_STRING), 8,
                     PropModeReplace, (const guchar*)val, strlen(val));
 }
@@ -544,6 +952,8 @@ void obt_prop_set_array_text(Window win, Atom prop, const gchar *const *strs)
     GString *str;
     gchar const *const *s;
 
+    prefetch_forget(win, prop);
+
     str = g_string_sized_new(0);
     for (s = strs; *s; ++s) {
         str = g_string_append(str, *s);
@@ -556,6 +966,7 @@ void obt_prop_set_array_text(Window win, Atom prop, const gchar *const *strs)
 
 void obt_prop_erase(Window win, Atom prop)
 {
+    prefetch_forget(win, prop);
     XDeleteProperty(obt_display, win, prop);
 }
 
@@ -21,6 +21,7 @@
 #define __obt_prop_h
 
 #include <X11/Xlib.h>
+#include <X11/Xutil.h>
 #include <glib.h>
 
 G_BEGIN_DECLS
@@ -246,6 +247,32 @@ typedef enum {
     OBT_PROP_TEXT_UTF8_STRING = 5,
 } ObtPropTextType;
 
+/*! Sends requests for all of the given properties on the window at once.
+  Reading any of them with the obt_prop_get functions afterwards uses the
+  reply instead of making a round trip to the server for each one.  The
+  replies are kept until obt_prop_prefetch_done() is called for the window,
+  or until the property is changed through the obt_prop_set functions. */
+void obt_prop_prefetch(Window win, const Atom *props, guint n);
+/*! Drops any prefetched property values for the window, unless the window
+  is kept in the cache with obt_prop_cache_window(). */
+void obt_prop_prefetch_done(Window win);
+
+/*! Keeps the values of the window's properties after they are read, so
+  reading them again does not need a round trip to the server.  Only use this
+  for windows which have PropertyChangeMask and StructureNotifyMask selected,
+  as the values are forgotten when the events arrive in the xqueue.
+  @param cache TRUE to start keeping values for the window, FALSE to stop and
+    drop the values kept so far.
+*/
+void obt_prop_cache_window(Window win, gboolean cache);
+/*! Forgets kept values which the event shows are out of date.  The xqueue
+  calls this for every event read from the server. */
+void obt_prop_cache_event(const XEvent *e);
+/*! Returns the number of property reads which used a prefetched or cached
+  value, and the number which had to read a cached window's property from
+  the server. */
+void obt_prop_cache_stats(gulong *hits, gulong *misses);
+
 gboolean obt_prop_get32(Window win, Atom prop, Atom type, guint32 *ret);
 gboolean obt_prop_get_array32(Window win, Atom prop, Atom type, guint32 **ret,
                               guint *nret);
@@ -256,6 +283,12 @@ gboolean obt_prop_get_array_text(Window win, Atom prop,
                                  ObtPropTextType type,
                                  gchar ***ret);
 
+/*! Works like XGetWMHints, including that the hints must be freed with
+  XFree, but can use prefetched values. */
+XWMHints* obt_prop_get_wm_hints(Window win);
+/*! Works like XGetWMNormalHints, but can use prefetched values. */
+gboolean obt_prop_get_wm_normal_hints(Window win, XSizeHints *hints);
+
 void obt_prop_set32(Window win, Atom prop, Atom type, gulong val);
 void obt_prop_set_array32(Window win, Atom prop, Atom type, gulong *val,
                           guint num);
@@ -41,6 +41,10 @@ struct Callback {
     gpointer data;
 };
 
+struct _ObtXmlStream {
+    xmlParserCtxtPtr ctxt;
+};
+
 struct _ObtXmlInst {
     gint ref;
     ObtPaths *xdg_paths;
@@ -304,6 +308,78 @@ gboolean obt_xml_load_mem(ObtXmlInst *i,
     return r;
 }
 
+ObtXmlStream* obt_xml_stream_new(void)
+{
+    ObtXmlStream *s;
+
+    s = g_slice_new(ObtXmlStream);
+    s->ctxt = xmlCreatePushParserCtxt(NULL, NULL, NULL, 0, NULL);
+    return s;
+}
+
+gboolean obt_xml_stream_push(ObtXmlStream *s, gconstpointer data, guint len)
+{
+    if (s->ctxt && s->ctxt->wellFormed)
+        xmlParseChunk(s->ctxt, data, len, 0);
+    return s->ctxt && s->ctxt->wellFormed;
+}
+
+void obt_xml_stream_free(ObtXmlStream *s)
+{
+    if (s) {
+        if (s->ctxt) {
+            if (s->ctxt->myDoc)
+                xmlFreeDoc(s->ctxt->myDoc);
+            xmlFreeParserCtxt(s->ctxt);
+        }
+        g_slice_free(ObtXmlStream, s);
+    }
+}
+
+gboolean obt_xml_load_stream(ObtXmlInst *i, ObtXmlStream *s,
+                             const gchar *root_node)
+{
+    gboolean r = FALSE;
+
+    g_assert(i->doc == NULL); /* another doc isn't open already? */
+
+    xmlResetLastError();
+
+    if (s->ctxt) {
+        xmlParseChunk(s->ctxt, NULL, 0, 1);
+        /* keep the document only if it is all well-formed, like
+           xmlParseMemory() does */
+        if (s->ctxt->wellFormed)
+            i->doc = s->ctxt->myDoc;
+        else if (s->ctxt->myDoc)
+            xmlFreeDoc(s->ctxt->myDoc);
+        s->ctxt->myDoc = NULL;
+    }
+    obt_xml_stream_free(s);
+
+    if (i->doc) {
+        i->root = xmlDocGetRootElement(i->doc);
+        if (!i->root) {
+            xmlFreeDoc(i->doc);
+            i->doc = NULL;
+            g_message("Given stream is an empty document");
+        }
+        else if (xmlStrcmp(i->root->name, (const xmlChar*)root_node)) {
+            xmlFreeDoc(i->doc);
+            i->doc = NULL;
+            i->root = NULL;
+            g_message("XML Document in given stream is of wrong "
+                      "type. Root node is not '%s'\n", root_node);
+        }
+        else
+            r = TRUE; /* ok ! */
+    }
+
+    obt_xml_save_last_error(i);
+
+    return r;
+}
+
 static void obt_xml_save_last_error(ObtXmlInst* inst)
 {
     xmlErrorPtr error = xmlGetLastError();
@@ -51,6 +51,21 @@ gboolean obt_xml_load_theme_file(ObtXmlInst *inst,
 gboolean obt_xml_load_mem(ObtXmlInst *inst,
                           gpointer data, guint len, const gchar *root_node);
 
+/*! A document which is parsed a piece at a time as it is read, such as from
+  a pipe, so that it doesn't have to be parsed all at once at the end */
+typedef struct _ObtXmlStream ObtXmlStream;
+
+ObtXmlStream* obt_xml_stream_new(void);
+/*! Parses the next piece of the document.
+  @return FALSE if the document is not well-formed, and then the rest of it
+    does not need to be read */
+gboolean obt_xml_stream_push(ObtXmlStream *s, gconstpointer data, guint len);
+void obt_xml_stream_free(ObtXmlStream *s);
+/*! Finishes parsing the document and opens it in the instance, the same as
+  obt_xml_load_mem() does.  The stream is freed. */
+gboolean obt_xml_load_stream(ObtXmlInst *inst, ObtXmlStream *s,
+                             const gchar *root_node);
+
 /* Returns true if an error is present. */
 gboolean obt_xml_last_error(ObtXmlInst *inst);
 gchar* obt_xml_last_error_file(ObtXmlInst *inst);
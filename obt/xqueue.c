@@ -18,72 +18,279 @@
 
 #include "obt/xqueue.h"
 #include "obt/display.h"
+#include "obt/prop.h"
+
+/* The queue is a list of fixed size chunks of events.  Removing an event only
+   marks its slot as dead, so taking an event out of the middle of the queue
+   never moves any other event, and the position of an event stays valid until
+   that event is removed.  Dead slots at the ends of a chunk are trimmed right
+   away, and a chunk is released as soon as it has no live events left. */
+
+#define CHUNKSZ 64
+
+/* Each live event is also kept in a list of the events that share its key,
+   for each of these indexes.  This lets the common match functions find the
+   first matching event without walking the queue. */
+typedef enum {
+    INDEX_WINDOW,
+    INDEX_TYPE,
+    INDEX_WINDOW_TYPE,
+    INDEX_WINDOW_ATOM, /* only PropertyNotify and ClientMessage events */
+    NUM_INDEXES
+} ObtXQueueIndexType;
+
+typedef struct _ObtXQueueKey ObtXQueueKey;
+typedef struct _ObtXQueueIndex ObtXQueueIndex;
+typedef struct _ObtXQueueSlot ObtXQueueSlot;
+typedef struct _ObtXQueueChunk ObtXQueueChunk;
+
+struct _ObtXQueueKey {
+    ObtXQueueIndexType index;
+    Window window;
+    gint type;
+    Atom atom;
+};
+
+/*! The events in the queue with the same key, in queue order */
+struct _ObtXQueueIndex {
+    ObtXQueueKey key;
+    ObtXQueueSlot *head;
+    ObtXQueueSlot *tail;
+};
+
+struct _ObtXQueueSlot {
+    XEvent ev;
+    gboolean dead;
+    ObtXQueueChunk *chunk;
+
+    /* the index lists that the event is in, NULL if it is not in one */
+    ObtXQueueIndex *list[NUM_INDEXES];
+    ObtXQueueSlot *next[NUM_INDEXES];
+    ObtXQueueSlot *prev[NUM_INDEXES];
+};
+
+struct _ObtXQueueChunk {
+    ObtXQueueChunk *next;
+    ObtXQueueChunk *prev;
 
-#define MINSZ 16
+    guint start; /* the first live event in the chunk */
+    guint end; /* one past the last used slot in the chunk */
+    guint live; /* the number of live events in the chunk */
 
-static XEvent *q = NULL;
-static gulong qsz = 0;
-static gulong qstart; /* the first event in the queue */
-static gulong qend; /* the last event in the queue */
+    ObtXQueueSlot slot[CHUNKSZ];
+};
+
+static gboolean qinit = FALSE;
+static ObtXQueueChunk *qhead = NULL; /* the chunk with the first event */
+static ObtXQueueChunk *qtail = NULL; /* the chunk with the last event */
+static ObtXQueueChunk *qspare = NULL; /* an empty chunk kept for reuse */
 static gulong qnum = 0;
+static GHashTable *qindex = NULL; /* ObtXQueueKey -> ObtXQueueIndex */
 
-static inline void shrink(void) {
-    if (qsz > MINSZ && qnum < qsz / 4) {
-        const gulong newsz = qsz/2;
-        gulong i;
+static gulong stat_indexed = 0; /* searches answered from the indexes */
+static gulong stat_scanned = 0; /* searches that walked the queue */
+static gulong stat_checked = 0; /* events looked at while walking it */
+static gulong stat_coalesced = 0; /* property changes that were skipped */
 
-        if (qnum == 0) {
-            qstart = 0;
-            qend = -1;
-        }
+static guint key_hash(gconstpointer p)
+{
+    const ObtXQueueKey *k = p;
+    return (k->window * 31 + k->type) * 31 + k->atom * 7 + k->index;
+}
 
-        /* all in the shinking part, move it to pos 0 */
-        else if (qstart >= newsz && qend >= newsz) {
-            for (i = 0; i < qnum; ++i)
-                q[i] = q[qstart+i];
-            qstart = 0;
-            qend = qnum - 1;
-        }
+static gboolean key_equal(gconstpointer p1, gconstpointer p2)
+{
+    const ObtXQueueKey *k1 = p1, *k2 = p2;
+    return k1->index == k2->index && k1->window == k2->window &&
+        k1->type == k2->type && k1->atom == k2->atom;
+}
 
-        /* it wraps around to 0 right now, move the part between newsz and qsz
-           to be before newsz */
-        else if (qstart >= newsz) {
-            const gulong n = qsz - qstart;
-            for (i = 0; i < n; ++i)
-                q[newsz-n+i] = q[qstart+i];
-            qstart = newsz-n;
-        }
+static void index_free(gpointer p)
+{
+    g_slice_free(ObtXQueueIndex, p);
+}
 
-        /* it needs to wrap around to 0, move the stuff after newsz to pos 0 */
-        else if (qend >= newsz) {
-            const gulong n = qend + 1 - newsz;
-            for (i = 0; i < n; ++i)
-                q[i] = q[newsz+i];
-            qend = n - 1;
-        }
+/*! Fills in the key for the event in the given index.  Returns FALSE if the
+  event does not go in that index. */
+static gboolean event_key(ObtXQueueIndexType i, const XEvent *e,
+                          ObtXQueueKey *k)
+{
+    k->index = i;
+    k->window = None;
+    k->type = 0;
+    k->atom = None;
+
+    switch (i) {
+    case INDEX_WINDOW:
+        k->window = e->xany.window;
+        return TRUE;
+    case INDEX_TYPE:
+        k->type = e->type;
+        return TRUE;
+    case INDEX_WINDOW_TYPE:
+        k->window = e->xany.window;
+        k->type = e->type;
+        return TRUE;
+    case INDEX_WINDOW_ATOM:
+        k->window = e->xany.window;
+        k->type = e->type;
+        if (e->type == PropertyNotify)
+            k->atom = e->xproperty.atom;
+        else if (e->type == ClientMessage)
+            k->atom = e->xclient.message_type;
+        else
+            return FALSE;
+        return TRUE;
+    case NUM_INDEXES:
+        break;
+    }
+    g_assert_not_reached();
+    return FALSE;
+}
+
+/*! Fills in the index key which finds the same events as the match function
+  does.  Returns FALSE if the match function can't be answered by an index. */
+static gboolean match_key(xqueue_match_func match, gpointer data,
+                          ObtXQueueKey *k)
+{
+    k->window = None;
+    k->type = 0;
+    k->atom = None;
 
-        q = g_renew(XEvent, q, newsz);
-        qsz = newsz;
+    if (match == xqueue_match_window) {
+        k->index = INDEX_WINDOW;
+        k->window = *(Window*)data;
+    }
+    else if (match == xqueue_match_type) {
+        k->index = INDEX_TYPE;
+        k->type = GPOINTER_TO_INT(data);
     }
+    else if (match == xqueue_match_window_type) {
+        const ObtXQueueWindowType *x = data;
+        k->index = INDEX_WINDOW_TYPE;
+        k->window = x->window;
+        k->type = x->type;
+    }
+    else if (match == xqueue_match_window_message) {
+        const ObtXQueueWindowMessage *x = data;
+        k->index = INDEX_WINDOW_ATOM;
+        k->window = x->window;
+        k->type = ClientMessage;
+        k->atom = x->message;
+    }
+    else if (match == xqueue_match_window_property) {
+        const ObtXQueueWindowProperty *x = data;
+        k->index = INDEX_WINDOW_ATOM;
+        k->window = x->window;
+        k->type = PropertyNotify;
+        k->atom = x->property;
+    }
+    else
+        return FALSE;
+    return TRUE;
 }
 
-static inline void grow(void) {
-    if (qnum == qsz) {
-        const gulong newsz = qsz*2;
-        gulong i;
- 
-        q = g_renew(XEvent, q, newsz);
+static void index_add(ObtXQueueSlot *s)
+{
+    guint i;
+
+    for (i = 0; i < NUM_INDEXES; ++i) {
+        ObtXQueueKey k;
+        ObtXQueueIndex *l;
+
+        s->list[i] = NULL;
+        s->next[i] = s->prev[i] = NULL;
 
-        g_assert(qnum > 0);
+        if (!event_key(i, &s->ev, &k)) continue;
 
-        if (qend < qstart) { /* it wraps around to 0 right now */
-            for (i = 0; i <= qend; ++i)
-                q[qsz+i] = q[i];
-            qend = qsz + qend;
+        l = g_hash_table_lookup(qindex, &k);
+        if (!l) {
+            l = g_slice_new(ObtXQueueIndex);
+            l->key = k;
+            l->head = l->tail = NULL;
+            g_hash_table_insert(qindex, &l->key, l);
         }
 
-        qsz = newsz;
+        /* events are added in queue order, so add it at the end */
+        s->prev[i] = l->tail;
+        if (l->tail) l->tail->next[i] = s;
+        else l->head = s;
+        l->tail = s;
+        s->list[i] = l;
+    }
+}
+
+static void index_remove(ObtXQueueSlot *s)
+{
+    guint i;
+
+    for (i = 0; i < NUM_INDEXES; ++i) {
+        ObtXQueueIndex *l = s->list[i];
+
+        if (!l) continue;
+
+        if (s->prev[i]) s->prev[i]->next[i] = s->next[i];
+        else l->head = s->next[i];
+        if (s->next[i]) s->next[i]->prev[i] = s->prev[i];
+        else l->tail = s->prev[i];
+
+        if (!l->head)
+            g_hash_table_remove(qindex, &l->key); /* frees it */
+        s->list[i] = NULL;
+    }
+}
+
+static ObtXQueueChunk* chunk_new(void)
+{
+    ObtXQueueChunk *c;
+
+    if (qspare) {
+        c = qspare;
+        qspare = NULL;
+    }
+    else
+        c = g_slice_new(ObtXQueueChunk);
+
+    c->next = c->prev = NULL;
+    c->start = c->end = c->live = 0;
+    return c;
+}
+
+static void chunk_free(ObtXQueueChunk *c)
+{
+    /* hold on to one chunk, so a queue that keeps going between empty and
+       a few events doesn't allocate every time */
+    if (!qspare)
+        qspare = c;
+    else
+        g_slice_free(ObtXQueueChunk, c);
+}
+
+static void push(const XEvent *e)
+{
+    ObtXQueueSlot *s;
+
+    if (!qtail || qtail->end == CHUNKSZ) {
+        ObtXQueueChunk *c = chunk_new();
+
+        if (qtail) {
+            qtail->next = c;
+            c->prev = qtail;
+        }
+        else
+            qhead = c;
+        qtail = c;
     }
+
+    s = &qtail->slot[qtail->end];
+    s->ev = *e; /* stick the event at the end */
+    s->dead = FALSE;
+    s->chunk = qtail;
+    index_add(s);
+
+    ++qtail->end;
+    ++qtail->live;
+    ++qnum;
 }
 
 /* Grab all pending X events */
@@ -100,11 +307,10 @@ static gboolean read_events(gboolean block)
         if (XNextEvent(obt_display, &e) != Success)
             return FALSE;
 
-        grow(); /* make sure there is room */
-
-        ++qnum;
-        qend = (qend + 1) % qsz; /* move the end */
-        q[qend] = e; /* stick the event at the end */
+        /* forget cached properties now, so anything reading them before
+           the event is handled sees the new value */
+        obt_prop_cache_event(&e);
+        push(&e);
 
         --n;
         sth = TRUE;
@@ -113,64 +319,121 @@ static gboolean read_events(gboolean block)
     return sth; /* return if we read anything */
 }
 
-static void pop(const gulong p)
+static void pop(ObtXQueueSlot *s)
 {
+    ObtXQueueChunk *c = s->chunk;
+
+    g_assert(!s->dead);
+
     /* remove the event */
+    index_remove(s);
+    s->dead = TRUE;
+    --c->live;
     --qnum;
-    if (qnum == 0) {
-        qstart = 0;
-        qend = -1;
+
+    if (c->live == 0) {
+        /* nothing is left in it, so unlink the chunk */
+        if (c->prev) c->prev->next = c->next;
+        else qhead = c->next;
+        if (c->next) c->next->prev = c->prev;
+        else qtail = c->prev;
+        chunk_free(c);
     }
-    else if (p == qstart)
-        qstart = (qstart + 1) % qsz;
     else {
-        gulong pi;
-
-        /* is it cheaper to move the start or the end ? */
-        if ((p >= qstart && p < qstart + qnum/2) ||
-            (p < qstart && p < (qstart + qnum/2) % qsz))
-        {
-            /* move the start */
-            pi = p;
-            while (pi != qstart) {
-                const gulong pi_next = (pi == 0 ? qsz-1 : pi-1);
-
-                q[pi] = q[pi_next];
-                pi = pi_next;
-            }
-            qstart = (qstart + 1) % qsz;
-        }
-        else {
-            /* move the end */
-            pi = p;
-            while (pi != qend) {
-                const gulong pi_next = (pi + 1) % qsz;
-
-                q[pi] = q[pi_next];
-                pi = pi_next;
-            }
-            qend = (qend == 0 ? qsz-1 : qend-1);
-        }
+        /* trim the dead slots off the ends of the chunk */
+        while (c->slot[c->start].dead) ++c->start;
+        while (c->slot[c->end-1].dead) --c->end;
+    }
+}
+
+/* Move the position in @c and @p forward to the next live event in the queue
+   at or after it.  Pass *c as NULL to start from the front of the queue.  If
+   there is no such event, it returns FALSE and leaves the position at the end
+   of the queue, so the search can go on from there after more events are
+   read. */
+static gboolean seek(ObtXQueueChunk **c, guint *p)
+{
+    if (!*c) {
+        if (!qhead) return FALSE;
+        *c = qhead;
+        *p = qhead->start;
+    }
+
+    while (TRUE) {
+        for (; *p < (*c)->end; ++*p)
+            if (!(*c)->slot[*p].dead) return TRUE;
+        if (!(*c)->next) return FALSE;
+        *c = (*c)->next;
+        *p = (*c)->start;
     }
+}
+
+/*! Returns the first event in the queue with the key, from the indexes,
+  reading more events from the server when none of the queued events have
+  it */
+static ObtXQueueSlot* find_key(const ObtXQueueKey *k, gboolean block)
+{
+    while (TRUE) {
+        const ObtXQueueIndex *l = g_hash_table_lookup(qindex, k);
+        if (l) return l->head;
+        if (!read_events(block)) break;
+    }
+    return NULL;
+}
+
+/*! Returns the first event in the queue which matches, reading more events
+  from the server when none of the queued events match.  If @block is TRUE
+  it waits for more events until one matches or there is an error, otherwise
+  it gives up when no more events are available. */
+static ObtXQueueSlot* find(xqueue_match_func match, gpointer data,
+                           gboolean block)
+{
+    ObtXQueueKey k;
+    ObtXQueueChunk *c;
+    guint p;
 
-    shrink(); /* shrink the q if too little in it */
+    if (match_key(match, data, &k)) {
+        ++stat_indexed;
+        return find_key(&k, block);
+    }
+
+    ++stat_scanned;
+    c = NULL;
+    p = 0;
+    while (TRUE) {
+        for (; seek(&c, &p); ++p) {
+            ++stat_checked;
+            if (match(&c->slot[p].ev, data))
+                return &c->slot[p];
+        }
+        if (!read_events(block)) break;
+    }
+    return NULL;
 }
 
 void xqueue_init(void)
 {
-    if (q != NULL) return;
-    qsz = MINSZ;
-    q = g_new(XEvent, qsz);
-    qstart = 0;
-    qend = -1;
+    if (qinit) return;
+    qhead = qtail = NULL;
+    qnum = 0;
+    qindex = g_hash_table_new_full(key_hash, key_equal, NULL, index_free);
+    qinit = TRUE;
 }
 
 void xqueue_destroy(void)
 {
-    if (q == NULL) return;
-    g_free(q);
-    q = NULL;
-    qsz = 0;
+    if (!qinit) return;
+    while (qhead) {
+        ObtXQueueChunk *c = qhead;
+        qhead = c->next;
+        g_slice_free(ObtXQueueChunk, c);
+    }
+    if (qspare) g_slice_free(ObtXQueueChunk, qspare);
+    qhead = qtail = qspare = NULL;
+    qnum = 0;
+    g_hash_table_destroy(qindex);
+    qindex = NULL;
+    qinit = FALSE;
 }
 
 gboolean xqueue_match_window(XEvent *e, gpointer data)
@@ -197,37 +460,44 @@ gboolean xqueue_match_window_message(XEvent *e, gpointer data)
         e->xclient.message_type == x.message;
 }
 
+gboolean xqueue_match_window_property(XEvent *e, gpointer data)
+{
+    const ObtXQueueWindowProperty x = *(ObtXQueueWindowProperty*)data;
+    return e->xany.window == x.window && e->type == PropertyNotify &&
+        e->xproperty.atom == x.property;
+}
+
 gboolean xqueue_peek(XEvent *event_return)
 {
-    g_return_val_if_fail(q != NULL, FALSE);
+    g_return_val_if_fail(qinit, FALSE);
     g_return_val_if_fail(event_return != NULL, FALSE);
 
     if (!qnum) read_events(TRUE);
     if (!qnum) return FALSE;
-    *event_return = q[qstart]; /* get the head */
+    *event_return = qhead->slot[qhead->start].ev; /* get the head */
     return TRUE;
 }
 
 gboolean xqueue_peek_local(XEvent *event_return)
 {
-    g_return_val_if_fail(q != NULL, FALSE);
+    g_return_val_if_fail(qinit, FALSE);
     g_return_val_if_fail(event_return != NULL, FALSE);
 
     if (!qnum) read_events(FALSE);
     if (!qnum) return FALSE;
-    *event_return = q[qstart]; /* get the head */
+    *event_return = qhead->slot[qhead->start].ev; /* get the head */
     return TRUE;
 }
 
 gboolean xqueue_next(XEvent *event_return)
 {
-    g_return_val_if_fail(q != NULL, FALSE);
+    g_return_val_if_fail(qinit, FALSE);
     g_return_val_if_fail(event_return != NULL, FALSE);
 
     if (!qnum) read_events(TRUE);
     if (qnum) {
-        *event_return = q[qstart]; /* get the head */
-        pop(qstart);
+        *event_return = qhead->slot[qhead->start].ev; /* get the head */
+        pop(&qhead->slot[qhead->start]);
         return TRUE;
     }
 
@@ -236,13 +506,13 @@ gboolean xqueue_next(XEvent *event_return)
 
 gboolean xqueue_next_local(XEvent *event_return)
 {
-    g_return_val_if_fail(q != NULL, FALSE);
+    g_return_val_if_fail(qinit, FALSE);
     g_return_val_if_fail(event_return != NULL, FALSE);
 
     if (!qnum) read_events(FALSE);
     if (qnum) {
-        *event_return = q[qstart]; /* get the head */
-        pop(qstart);
+        *event_return = qhead->slot[qhead->start].ev; /* get the head */
+        pop(&qhead->slot[qhead->start]);
         return TRUE;
     }
 
@@ -251,69 +521,49 @@ gboolean xqueue_next_local(XEvent *event_return)
 
 gboolean xqueue_exists(xqueue_match_func match, gpointer data)
 {
-    gulong i, checked;
-
-    g_return_val_if_fail(q != NULL, FALSE);
+    g_return_val_if_fail(qinit, FALSE);
     g_return_val_if_fail(match != NULL, FALSE);
 
-    checked = 0;
-    while (TRUE) {
-        for (i = checked; i < qnum; ++i, ++checked) {
-            const gulong p = (qstart + i) % qsz;
-            if (match(&q[p], data))
-                return TRUE;
-        }
-        if (!read_events(TRUE)) break; /* error */
-    }
-    return FALSE;
+    return find(match, data, TRUE) != NULL;
 }
 
 gboolean xqueue_exists_local(xqueue_match_func match, gpointer data)
 {
-    gulong i, checked;
-
-    g_return_val_if_fail(q != NULL, FALSE);
+    g_return_val_if_fail(qinit, FALSE);
     g_return_val_if_fail(match != NULL, FALSE);
 
-    checked = 0;
-    while (TRUE) {
-        for (i = checked; i < qnum; ++i, ++checked) {
-            const gulong p = (qstart + i) % qsz;
-            if (match(&q[p], data))
-                return TRUE;
-        }
-        if (!read_events(FALSE)) break;
-    }
-    return FALSE;
+    return find(match, data, FALSE) != NULL;
 }
 
 gboolean xqueue_remove_local(XEvent *event_return,
                              xqueue_match_func match, gpointer data)
 {
-    gulong i, checked;
+    ObtXQueueSlot *s;
 
-    g_return_val_if_fail(q != NULL, FALSE);
+    g_return_val_if_fail(qinit, FALSE);
     g_return_val_if_fail(event_return != NULL, FALSE);
     g_return_val_if_fail(match != NULL, FALSE);
 
-    checked = 0;
-    while (TRUE) {
-        for (i = checked; i < qnum; ++i, ++checked) {
-            const gulong p = (qstart + i) % qsz;
-            if (match(&q[p], data)) {
-                *event_return = q[p];
-                pop(p);
-                return TRUE;
-            }
-        }
-        if (!read_events(FALSE)) break;
+    if ((s = find(match, data, FALSE))) {
+        *event_return = s->ev;
+        pop(s);
+        return TRUE;
     }
     return FALSE;
 }
 
+void xqueue_stats(gulong *indexed, gulong *scanned, gulong *checked,
+                  gulong *coalesced)
+{
+    if (indexed) *indexed = stat_indexed;
+    if (scanned) *scanned = stat_scanned;
+    if (checked) *checked = stat_checked;
+    if (coalesced) *coalesced = stat_coalesced;
+}
+
 gboolean xqueue_pending_local(void)
 {
-    g_return_val_if_fail(q != NULL, FALSE);
+    g_return_val_if_fail(qinit, FALSE);
     
     if (!qnum) read_events(FALSE);
     return qnum != 0;
@@ -326,6 +576,32 @@ typedef struct _ObtXQueueCB {
 
 static ObtXQueueCB *callbacks = NULL;
 static guint n_callbacks = 0;
+static GHashTable *coalesce_props = NULL;
+
+/*! Returns TRUE if the event is a change to a property which is coalesced,
+  and another change to the same property on the same window is already
+  waiting in the queue. */
+static gboolean coalesce(const XEvent *e)
+{
+    ObtXQueueWindowProperty p;
+    ObtXQueueKey k;
+
+    if (e->type != PropertyNotify || !coalesce_props ||
+        !g_hash_table_lookup(coalesce_props,
+                             GUINT_TO_POINTER(e->xproperty.atom)))
+        return FALSE;
+
+    p.window = e->xproperty.window;
+    p.property = e->xproperty.atom;
+    /* this doesn't go through find(), so that the searches counted there
+       are only the ones asked for outside of the queue */
+    match_key(xqueue_match_window_property, &p, &k);
+    if (find_key(&k, FALSE)) {
+        ++stat_coalesced;
+        return TRUE;
+    }
+    return FALSE;
+}
 
 static gboolean event_read(GSource *source, GSourceFunc callback,
                            gpointer data)
@@ -334,6 +610,10 @@ static gboolean event_read(GSource *source, GSourceFunc callback,
 
     while (xqueue_next_local(&ev)) {
         guint i;
+
+        /* the later change will be handled instead */
+        if (coalesce(&ev)) continue;
+
         for (i = 0; i < n_callbacks; ++i)
             callbacks[i].func(&ev, callbacks[i].data);
     }
@@ -409,3 +689,19 @@ void xqueue_remove_callback(ObtXQueueFunc f, gpointer data)
         }
     }
 }
+
+void xqueue_coalesce_properties(const Atom *props, guint n)
+{
+    guint i;
+
+    if (coalesce_props) {
+        g_hash_table_destroy(coalesce_props);
+        coalesce_props = NULL;
+    }
+    if (!n) return;
+
+    coalesce_props = g_hash_table_new(g_direct_hash, g_direct_equal);
+    for (i = 0; i < n; ++i)
+        g_hash_table_insert(coalesce_props, GUINT_TO_POINTER(props[i]),
+                            GUINT_TO_POINTER(props[i]));
+}
@@ -34,6 +34,11 @@ typedef struct _ObtXQueueWindowMessage {
     Atom message;
 } ObtXQueueWindowMessage;
 
+typedef struct _ObtXQueueWindowProperty {
+    Window window;
+    Atom property;
+} ObtXQueueWindowProperty;
+
 typedef gboolean (*xqueue_match_func)(XEvent *e, gpointer data);
 
 /*! Returns TRUE if the event matches the window pointed to by @data */
@@ -50,6 +55,10 @@ gboolean xqueue_match_window_type(XEvent *e, gpointer data);
   ObtXQueueWindowMessage pointed to by @data */
 gboolean xqueue_match_window_message(XEvent *e, gpointer data);
 
+/*! Returns TRUE if a PropertyNotify event matches the property and window in
+  the ObtXQueueWindowProperty pointed to by @data */
+gboolean xqueue_match_window_property(XEvent *e, gpointer data);
+
 /*! Returns TRUE and passes the next event in the queue and removes it from
   the queue.  On error, returns FALSE */
 gboolean xqueue_next(XEvent *event_return);
@@ -87,6 +96,17 @@ gboolean xqueue_exists_local(xqueue_match_func match, gpointer data);
 gboolean xqueue_remove_local(XEvent *event_return,
                              xqueue_match_func match, gpointer data);
 
+/*! Gives the number of searches through the queue which were answered from
+  its indexes without walking the queue, the number which had to walk the
+  queue, the number of events looked at while walking it, and the number of
+  property changes skipped by xqueue_coalesce_properties().  The searches
+  with xqueue_match_window, xqueue_match_type, xqueue_match_window_type,
+  xqueue_match_window_message and xqueue_match_window_property use the
+  indexes.  The queue's own searches for property changes to coalesce are
+  not counted as searches. */
+void xqueue_stats(gulong *indexed, gulong *scanned, gulong *checked,
+                  gulong *coalesced);
+
 typedef void (*ObtXQueueFunc)(const XEvent *ev, gpointer data);
 
 /*! Begin listening for X events in the default GMainContext, and feed them
@@ -96,6 +116,13 @@ void xqueue_listen(void);
 void xqueue_add_callback(ObtXQueueFunc f, gpointer data);
 void xqueue_remove_callback(ObtXQueueFunc f, gpointer data);
 
+/*! A PropertyNotify event for one of the given properties is dropped instead
+  of being passed to the callbacks, when another PropertyNotify for the same
+  property and window is waiting later in the queue.  Only the last change in
+  a burst is passed on, so use this for properties which are read again in
+  full when they change.  This replaces any properties given before. */
+void xqueue_coalesce_properties(const Atom *props, guint n);
+
 G_END_DECLS
 
 #endif
@@ -0,0 +1,353 @@
+#include "obt/unittest_base.h"
+
+#include "obt/xqueue.h"
+
+#include <glib.h>
+#include <X11/Xlib.h>
+
+extern void xqueue_init(void);
+extern void xqueue_destroy(void);
+
+/* The events that the queue reads, in place of the X server's.  These take
+   the place of the Xlib functions which it calls. */
+
+#define MAX_SENT 1000
+
+static XEvent sent[MAX_SENT];
+static guint n_sent, n_read;
+
+int XEventsQueued(Display *d, int mode)
+{
+    return n_sent - n_read;
+}
+
+int XNextEvent(Display *d, XEvent *e)
+{
+    g_assert(n_read < n_sent);
+    *e = sent[n_read++];
+    return Success;
+}
+
+/*! Makes an event for the queue to read.  Its serial number is the order
+  it was made in, from 1. */
+static XEvent* send(gint type, Window w)
+{
+    XEvent *e;
+
+    g_assert(n_sent < MAX_SENT);
+    e = &sent[n_sent++];
+    e->type = type;
+    e->xany.serial = n_sent;
+    e->xany.window = w;
+    return e;
+}
+
+static void send_property(Window w, Atom property)
+{
+    send(PropertyNotify, w)->xproperty.atom = property;
+}
+
+static void send_message(Window w, Atom message)
+{
+    send(ClientMessage, w)->xclient.message_type = message;
+}
+
+/*! Finds events for a window.  It isn't one of xqueue's match functions, so
+  the queue is walked to find them. */
+static gboolean match_window(XEvent *e, gpointer data)
+{
+    return e->xany.window == *(Window*)data;
+}
+
+static void start() {
+    n_sent = n_read = 0;
+    xqueue_init();
+}
+
+static void end() {
+    xqueue_destroy();
+}
+
+/*! Takes every event out of the queue, and checks that they are the ones
+  for windows @first to @last, leaving out the ones in @removed */
+static void expect_queue(Window first, Window last,
+                         const Window *removed, guint n_removed)
+{
+    XEvent e;
+    Window w;
+    guint i;
+
+    for (w = first; w <= last; ++w) {
+        for (i = 0; i < n_removed && removed[i] != w; ++i);
+        if (i < n_removed) continue;
+
+        EXPECT_BOOL_EQ(TRUE, xqueue_next_local(&e));
+        EXPECT_UINT_EQ((guint)w, (guint)e.xany.window);
+    }
+    EXPECT_BOOL_EQ(FALSE, xqueue_next_local(&e));
+    EXPECT_BOOL_EQ(FALSE, xqueue_pending_local());
+}
+
+static void remove_middle() {
+    TEST_START();
+
+    const Window removed[] = { 100, 2, 150, 199 };
+    XEvent e;
+    Window w;
+    guint i;
+
+    start();
+
+    /* Enough events for a few chunks. */
+    for (w = 1; w <= 200; ++w)
+        send(ConfigureNotify, w);
+    EXPECT_BOOL_EQ(TRUE, xqueue_pending_local());
+
+    for (i = 0; i < G_N_ELEMENTS(removed); ++i) {
+        w = removed[i];
+        EXPECT_BOOL_EQ(TRUE, xqueue_remove_local(&e, match_window, &w));
+        EXPECT_UINT_EQ((guint)w, (guint)e.xany.window);
+    }
+
+    /* Events that were removed can't be found again. */
+    w = 100;
+    EXPECT_BOOL_EQ(FALSE, xqueue_exists_local(match_window, &w));
+    EXPECT_BOOL_EQ(FALSE, xqueue_remove_local(&e, match_window, &w));
+
+    /* The rest are still in order. */
+    expect_queue(1, 200, removed, G_N_ELEMENTS(removed));
+
+    end();
+
+    TEST_END();
+}
+
+static void remove_whole_chunk() {
+    TEST_START();
+
+    Window removed[100];
+    XEvent e;
+    Window w;
+    guint i;
+
+    start();
+
+    for (w = 1; w <= 300; ++w)
+        send(ConfigureNotify, w);
+    EXPECT_BOOL_EQ(TRUE, xqueue_pending_local());
+
+    /* Empty out more than a whole chunk in the middle of the queue, from
+       the back to the front. */
+    for (i = 0; i < G_N_ELEMENTS(removed); ++i) {
+        w = removed[i] = 200 - i;
+        EXPECT_BOOL_EQ(TRUE, xqueue_remove_local(&e, match_window, &w));
+        EXPECT_UINT_EQ((guint)w, (guint)e.xany.window);
+    }
+
+    expect_queue(1, 300, removed, G_N_ELEMENTS(removed));
+
+    end();
+
+    TEST_END();
+}
+
+static void remove_ends() {
+    TEST_START();
+
+    const Window removed[] = { 1, 2, 100 };
+    XEvent e;
+    Window w;
+
+    start();
+
+    for (w = 1; w <= 100; ++w)
+        send(ConfigureNotify, w);
+
+    /* Take the first and last events out, and then the new first one. */
+    w = 1;
+    EXPECT_BOOL_EQ(TRUE, xqueue_remove_local(&e, match_window, &w));
+    w = 100;
+    EXPECT_BOOL_EQ(TRUE, xqueue_remove_local(&e, match_window, &w));
+    w = 2;
+    EXPECT_BOOL_EQ(TRUE, xqueue_remove_local(&e, match_window, &w));
+
+    /* More events go after the ones left, in the slots that the last event
+       was taken out of. */
+    for (w = 101; w <= 110; ++w)
+        send(ConfigureNotify, w);
+    w = 110;
+    EXPECT_BOOL_EQ(TRUE, xqueue_exists_local(match_window, &w));
+
+    expect_queue(1, 110, removed, G_N_ELEMENTS(removed));
+
+    /* And the queue can be filled again after it is empty. */
+    for (w = 111; w <= 200; ++w)
+        send(ConfigureNotify, w);
+    expect_queue(111, 200, NULL, 0);
+
+    end();
+
+    TEST_END();
+}
+
+static void index_match() {
+    TEST_START();
+
+    ObtXQueueWindowType wt;
+    ObtXQueueWindowProperty wp;
+    ObtXQueueWindowMessage wm;
+    gulong indexed, scanned, indexed2, scanned2;
+    Window w;
+
+    start();
+
+    send(MotionNotify, 1);
+    send_property(1, 10);
+    send_message(2, 10);
+    send_property(2, 11);
+    send(MotionNotify, 3);
+
+    xqueue_stats(&indexed, &scanned, NULL, NULL);
+
+    w = 2;
+    EXPECT_BOOL_EQ(TRUE, xqueue_exists_local(xqueue_match_window, &w));
+    w = 4;
+    EXPECT_BOOL_EQ(FALSE, xqueue_exists_local(xqueue_match_window, &w));
+
+    EXPECT_BOOL_EQ(TRUE, xqueue_exists_local(xqueue_match_type,
+                                             GINT_TO_POINTER(MotionNotify)));
+    EXPECT_BOOL_EQ(FALSE, xqueue_exists_local(xqueue_match_type,
+                                              GINT_TO_POINTER(ButtonPress)));
+
+    wt.window = 3;
+    wt.type = MotionNotify;
+    EXPECT_BOOL_EQ(TRUE, xqueue_exists_local(xqueue_match_window_type, &wt));
+    wt.window = 2;
+    EXPECT_BOOL_EQ(FALSE, xqueue_exists_local(xqueue_match_window_type, &wt));
+
+    /* A property and a message with the same atom are not the same. */
+    wp.window = 1;
+    wp.property = 10;
+    EXPECT_BOOL_EQ(TRUE,
+                   xqueue_exists_local(xqueue_match_window_property, &wp));
+    wp.window = 2;
+    EXPECT_BOOL_EQ(FALSE,
+                   xqueue_exists_local(xqueue_match_window_property, &wp));
+    wp.property = 11;
+    EXPECT_BOOL_EQ(TRUE,
+                   xqueue_exists_local(xqueue_match_window_property, &wp));
+
+    wm.window = 2;
+    wm.message = 10;
+    EXPECT_BOOL_EQ(TRUE,
+                   xqueue_exists_local(xqueue_match_window_message, &wm));
+    wm.window = 1;
+    EXPECT_BOOL_EQ(FALSE,
+                   xqueue_exists_local(xqueue_match_window_message, &wm));
+
+    /* All of them were answered by the indexes, without walking the
+       queue. */
+    xqueue_stats(&indexed2, &scanned2, NULL, NULL);
+    EXPECT_UINT_EQ(11, (guint)(indexed2 - indexed));
+    EXPECT_UINT_EQ(0, (guint)(scanned2 - scanned));
+
+    end();
+
+    TEST_END();
+}
+
+static void index_remove() {
+    TEST_START();
+
+    ObtXQueueWindowProperty wp;
+    XEvent e;
+    Window w;
+
+    start();
+
+    send_property(1, 10); /* 1 */
+    send_property(2, 10); /* 2 */
+    send_property(1, 11); /* 3 */
+    send_property(1, 10); /* 4 */
+    send(MotionNotify, 1); /* 5 */
+    send_property(1, 10); /* 6 */
+
+    /* They come out of the index in the order they are in the queue. */
+    wp.window = 1;
+    wp.property = 10;
+    EXPECT_BOOL_EQ(TRUE,
+                   xqueue_remove_local(&e, xqueue_match_window_property, &wp));
+    EXPECT_UINT_EQ(1, (guint)e.xany.serial);
+    EXPECT_BOOL_EQ(TRUE,
+                   xqueue_remove_local(&e, xqueue_match_window_property, &wp));
+    EXPECT_UINT_EQ(4, (guint)e.xany.serial);
+    EXPECT_BOOL_EQ(TRUE,
+                   xqueue_remove_local(&e, xqueue_match_window_property, &wp));
+    EXPECT_UINT_EQ(6, (guint)e.xany.serial);
+    EXPECT_BOOL_EQ(FALSE,
+                   xqueue_remove_local(&e, xqueue_match_window_property, &wp));
+
+    /* The events that were removed are gone from the other indexes too. */
+    w = 1;
+    EXPECT_BOOL_EQ(TRUE, xqueue_remove_local(&e, xqueue_match_window, &w));
+    EXPECT_UINT_EQ(3, (guint)e.xany.serial);
+    EXPECT_BOOL_EQ(TRUE,
+                   xqueue_remove_local(&e, xqueue_match_type,
+                                       GINT_TO_POINTER(PropertyNotify)));
+    EXPECT_UINT_EQ(2, (guint)e.xany.serial);
+
+    /* Taking the next event out of the queue removes it from the indexes. */
+    EXPECT_BOOL_EQ(TRUE, xqueue_next_local(&e));
+    EXPECT_UINT_EQ(5, (guint)e.xany.serial);
+    EXPECT_BOOL_EQ(FALSE, xqueue_exists_local(xqueue_match_window, &w));
+    EXPECT_BOOL_EQ(FALSE, xqueue_pending_local());
+
+    end();
+
+    TEST_END();
+}
+
+static void index_read_more() {
+    TEST_START();
+
+    ObtXQueueWindowProperty wp;
+    XEvent e;
+
+    start();
+
+    send_property(1, 10);
+    EXPECT_BOOL_EQ(TRUE, xqueue_pending_local());
+
+    /* When the queue doesn't have it, it reads more events to look in. */
+    send(MotionNotify, 2);
+    send_property(2, 10);
+    wp.window = 2;
+    wp.property = 10;
+    EXPECT_BOOL_EQ(TRUE,
+                   xqueue_remove_local(&e, xqueue_match_window_property, &wp));
+    EXPECT_UINT_EQ(3, (guint)e.xany.serial);
+    EXPECT_UINT_EQ(3, n_read);
+
+    EXPECT_BOOL_EQ(TRUE, xqueue_next_local(&e));
+    EXPECT_UINT_EQ(1, (guint)e.xany.serial);
+    EXPECT_BOOL_EQ(TRUE, xqueue_next_local(&e));
+    EXPECT_UINT_EQ(2, (guint)e.xany.serial);
+    EXPECT_BOOL_EQ(FALSE, xqueue_pending_local());
+
+    end();
+
+    TEST_END();
+}
+
+void run_xqueue_unittest() {
+    unittest_start_suite("xqueue");
+
+    remove_middle();
+    remove_whole_chunk();
+    remove_ends();
+    index_match();
+    index_remove();
+    index_read_more();
+
+    unittest_end_suite();
+}
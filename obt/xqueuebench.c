@@ -0,0 +1,429 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   xqueuebench.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Feeds bursts of made up events, like the ones tests/eventflood sends,
+   through the event queue without an X server, and handles them the way
+   openbox's event.c looks ahead in the queue for them: title changes look
+   for later title changes, client messages look for later ones of the same
+   message, and motion is compressed.  It times this with the ring buffer
+   which the queue used to be, with the queue as it is, and with the queue
+   coalescing property changes, and checks that the first two handle the
+   same events. */
+
+#include "obt/xqueue.h"
+#include "obt/prop.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <X11/Xlib.h>
+
+extern void xqueue_init(void);
+extern void xqueue_destroy(void);
+
+/* the parts of obt that xqueue.c uses */
+
+Display *obt_display;
+
+void obt_prop_cache_event(const XEvent *e) {}
+
+static XEvent *events;
+static gulong n_events, n_read;
+
+int XEventsQueued(Display *d, int mode)
+{
+    return n_events - n_read;
+}
+
+int XPending(Display *d)
+{
+    return n_events - n_read;
+}
+
+int XNextEvent(Display *d, XEvent *e)
+{
+    g_assert(n_read < n_events);
+    *e = events[n_read++];
+    return Success;
+}
+
+/* the made up atoms */
+enum {
+    NET_WM_NAME = 1,
+    WM_NAME,
+    NET_WM_ICON_NAME,
+    WM_ICON_NAME,
+    NET_WM_USER_TIME,
+    NET_ACTIVE_WINDOW
+};
+
+static const Atom titles[] = {
+    NET_WM_NAME, WM_NAME, NET_WM_ICON_NAME, WM_ICON_NAME
+};
+
+/*! The functions of a queue that event.c uses */
+typedef struct _Queue {
+    gboolean (*next_local)(XEvent *event_return);
+    gboolean (*exists_local)(xqueue_match_func match, gpointer data);
+    gboolean (*remove_local)(XEvent *event_return,
+                             xqueue_match_func match, gpointer data);
+} Queue;
+
+static gulong handled;
+static guint32 handled_hash;
+
+/*! Does the looking ahead that event.c does for each event */
+static void handle(const XEvent *e, const Queue *q)
+{
+    XEvent ce;
+    guint i;
+
+    switch (e->type) {
+    case PropertyNotify:
+        if (e->xproperty.atom != NET_WM_USER_TIME) {
+            ObtXQueueWindowProperty p;
+
+            p.window = e->xproperty.window;
+            for (i = 0; i < G_N_ELEMENTS(titles); ++i) {
+                p.property = titles[i];
+                if (q->exists_local(xqueue_match_window_property, &p))
+                    break;
+            }
+        }
+        break;
+    case ClientMessage:
+    {
+        ObtXQueueWindowMessage wm;
+
+        wm.window = e->xclient.window;
+        wm.message = e->xclient.message_type;
+        q->exists_local(xqueue_match_window_message, &wm);
+        break;
+    }
+    case MotionNotify:
+    {
+        ObtXQueueWindowType wt;
+
+        wt.window = e->xmotion.window;
+        wt.type = MotionNotify;
+        while (q->remove_local(&ce, xqueue_match_window_type, &wt));
+        break;
+    }
+    }
+
+    ++handled;
+    handled_hash = handled_hash * 31 + e->type;
+    handled_hash = handled_hash * 31 + e->xany.window;
+}
+
+static void handle_cb(const XEvent *e, gpointer data)
+{
+    handle(e, data);
+}
+
+/*! Makes a burst of @n events for @windows windows */
+static void make_events(gulong n, guint windows)
+{
+    gulong i;
+
+    for (i = 0; i < n; ++i) {
+        XEvent *e = &events[i];
+        Window w = 0x400000 + (i / 5) % windows;
+
+        switch (i % 5) {
+        case 0:
+        case 1:
+            e->type = PropertyNotify;
+            e->xproperty.window = w;
+            e->xproperty.atom = i % 5 ? NET_WM_USER_TIME : NET_WM_NAME;
+            break;
+        case 2:
+            e->type = ConfigureRequest;
+            e->xconfigurerequest.window = w;
+            break;
+        case 3:
+            e->type = ClientMessage;
+            e->xclient.window = w;
+            e->xclient.message_type = NET_ACTIVE_WINDOW;
+            break;
+        case 4:
+            e->type = MotionNotify;
+            e->xmotion.window = w;
+            break;
+        }
+    }
+    n_events = n;
+    n_read = 0;
+}
+
+/* The queue as it was before, a ring buffer which moves the events after (or
+   before) one which is taken out of the middle of it */
+
+#define MINSZ 16
+
+static XEvent *q = NULL;
+static gulong qsz = 0;
+static gulong qstart; /* the first event in the queue */
+static gulong qend; /* the last event in the queue */
+static gulong qnum = 0;
+
+static void old_shrink(void)
+{
+    if (qsz > MINSZ && qnum < qsz / 4) {
+        const gulong newsz = qsz/2;
+        gulong i;
+
+        if (qnum == 0) {
+            qstart = 0;
+            qend = -1;
+        }
+        else if (qstart >= newsz && qend >= newsz) {
+            for (i = 0; i < qnum; ++i)
+                q[i] = q[qstart+i];
+            qstart = 0;
+            qend = qnum - 1;
+        }
+        else if (qstart >= newsz) {
+            const gulong n = qsz - qstart;
+            for (i = 0; i < n; ++i)
+                q[newsz-n+i] = q[qstart+i];
+            qstart = newsz-n;
+        }
+        else if (qend >= newsz) {
+            const gulong n = qend + 1 - newsz;
+            for (i = 0; i < n; ++i)
+                q[i] = q[newsz+i];
+            qend = n - 1;
+        }
+
+        q = g_renew(XEvent, q, newsz);
+        qsz = newsz;
+    }
+}
+
+static void old_grow(void)
+{
+    if (qnum == qsz) {
+        const gulong newsz = qsz*2;
+        gulong i;
+
+        q = g_renew(XEvent, q, newsz);
+        if (qend < qstart) {
+            for (i = 0; i <= qend; ++i)
+                q[qsz+i] = q[i];
+            qend = qsz + qend;
+        }
+        qsz = newsz;
+    }
+}
+
+static gboolean old_read_events(void)
+{
+    XEvent e;
+
+    if (XEventsQueued(obt_display, QueuedAfterFlush) <= 0)
+        return FALSE;
+    XNextEvent(obt_display, &e);
+    old_grow();
+    ++qnum;
+    qend = (qend + 1) % qsz;
+    q[qend] = e;
+    return TRUE;
+}
+
+static void old_pop(const gulong p)
+{
+    --qnum;
+    if (qnum == 0) {
+        qstart = 0;
+        qend = -1;
+    }
+    else if (p == qstart)
+        qstart = (qstart + 1) % qsz;
+    else {
+        gulong pi;
+
+        if ((p >= qstart && p < qstart + qnum/2) ||
+            (p < qstart && p < (qstart + qnum/2) % qsz))
+        {
+            pi = p;
+            while (pi != qstart) {
+                const gulong pi_next = (pi == 0 ? qsz-1 : pi-1);
+
+                q[pi] = q[pi_next];
+                pi = pi_next;
+            }
+            qstart = (qstart + 1) % qsz;
+        }
+        else {
+            pi = p;
+            while (pi != qend) {
+                const gulong pi_next = (pi + 1) % qsz;
+
+                q[pi] = q[pi_next];
+                pi = pi_next;
+            }
+            qend = (qend == 0 ? qsz-1 : qend-1);
+        }
+    }
+    old_shrink();
+}
+
+static gboolean old_next_local(XEvent *event_return)
+{
+    if (!qnum) old_read_events();
+    if (!qnum) return FALSE;
+    *event_return = q[qstart];
+    old_pop(qstart);
+    return TRUE;
+}
+
+static gboolean old_find(XEvent *event_return, gboolean remove,
+                         xqueue_match_func match, gpointer data)
+{
+    gulong i, checked = 0;
+
+    while (TRUE) {
+        for (i = checked; i < qnum; ++i, ++checked) {
+            const gulong p = (qstart + i) % qsz;
+            if (match(&q[p], data)) {
+                if (remove) {
+                    *event_return = q[p];
+                    old_pop(p);
+                }
+                return TRUE;
+            }
+        }
+        if (!old_read_events()) break;
+    }
+    return FALSE;
+}
+
+static gboolean old_exists_local(xqueue_match_func match, gpointer data)
+{
+    return old_find(NULL, FALSE, match, data);
+}
+
+static gboolean old_remove_local(XEvent *event_return,
+                                 xqueue_match_func match, gpointer data)
+{
+    return old_find(event_return, TRUE, match, data);
+}
+
+static const Queue old_queue = {
+    old_next_local, old_exists_local, old_remove_local
+};
+
+static const Queue queue = {
+    xqueue_next_local, xqueue_exists_local, xqueue_remove_local
+};
+
+gint main(gint argc, gchar **argv)
+{
+    const Atom coalesce[] = { NET_WM_NAME, NET_WM_USER_TIME };
+    GTimer *timer;
+    gulong n, old_handled;
+    guint32 old_hash;
+    guint windows, bursts, b;
+    gulong indexed, scanned, checked, coalesced;
+    gdouble t;
+    XEvent e;
+    gboolean ok = TRUE;
+
+    n = argc > 1 ? atoi(argv[1]) : 5000;
+    bursts = argc > 2 ? atoi(argv[2]) : 10;
+    windows = argc > 3 ? atoi(argv[3]) : 20;
+
+    /* xqueue_listen() polls the display's connection, which there is none
+       of here */
+    obt_display = g_malloc0(sizeof(*(_XPrivDisplay)NULL));
+    ((_XPrivDisplay)obt_display)->fd = -1;
+    events = g_new0(XEvent, n);
+    timer = g_timer_new();
+
+    printf("%u bursts of %lu events for %u windows\n", bursts, n, windows);
+
+    qsz = MINSZ;
+    q = g_new(XEvent, qsz);
+    qstart = 0;
+    qend = -1;
+    handled = handled_hash = 0;
+    t = 0;
+    for (b = 0; b < bursts; ++b) {
+        make_events(n, windows);
+        g_timer_start(timer);
+        while (old_next_local(&e))
+            handle(&e, &old_queue);
+        g_timer_stop(timer);
+        t += g_timer_elapsed(timer, NULL);
+    }
+    g_free(q);
+    printf("  ring buffer  %9.3f ms a burst, %lu events handled\n",
+           t * 1000.0 / bursts, handled / bursts);
+    old_handled = handled;
+    old_hash = handled_hash;
+
+    xqueue_init();
+    xqueue_listen();
+    xqueue_add_callback(handle_cb, (gpointer)&queue);
+
+    handled = handled_hash = 0;
+    t = 0;
+    for (b = 0; b < bursts; ++b) {
+        make_events(n, windows);
+        g_timer_start(timer);
+        while (XPending(obt_display) || xqueue_pending_local())
+            g_main_context_iteration(NULL, FALSE);
+        g_timer_stop(timer);
+        t += g_timer_elapsed(timer, NULL);
+    }
+    xqueue_stats(&indexed, &scanned, &checked, &coalesced);
+    printf("  chunks       %9.3f ms a burst, %lu events handled, "
+           "%lu searches used an index, %lu scanned %lu events\n",
+           t * 1000.0 / bursts, handled / bursts, indexed / bursts,
+           scanned / bursts, checked / bursts);
+    if (handled != old_handled || handled_hash != old_hash) {
+        printf("  (DIFFERENT EVENTS)\n");
+        ok = FALSE;
+    }
+
+    xqueue_coalesce_properties(coalesce, G_N_ELEMENTS(coalesce));
+    handled = 0;
+    t = 0;
+    for (b = 0; b < bursts; ++b) {
+        make_events(n, windows);
+        g_timer_start(timer);
+        while (XPending(obt_display) || xqueue_pending_local())
+            g_main_context_iteration(NULL, FALSE);
+        g_timer_stop(timer);
+        t += g_timer_elapsed(timer, NULL);
+    }
+    xqueue_stats(&indexed, &scanned, &checked, &coalesced);
+    printf("  coalescing   %9.3f ms a burst, %lu events handled, "
+           "%lu property changes coalesced\n",
+           t * 1000.0 / bursts, handled / bursts, coalesced / bursts);
+
+    xqueue_coalesce_properties(NULL, 0);
+    xqueue_remove_callback(handle_cb, (gpointer)&queue);
+    xqueue_destroy();
+    g_timer_destroy(timer);
+    g_free(events);
+    g_free(obt_display);
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,224 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   apprulebench.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Checks that app_rules_match() finds the same per-app settings for a window
+   as trying every one of them in turn, the way it was done before, for lots
+   of random rules and windows.  Then it measures how long each one takes to
+   find the settings for every window. */
+
+#include "config.h"
+#include "apprules.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+    gchar *name;
+    gchar *class;
+    gchar *group_name;
+    gchar *group_class;
+    gchar *role;
+    gchar *title;
+    ObClientType type;
+} BenchWindow;
+
+/*! The way client_get_settings_state() found the settings before
+  app_rules_match(), kept as it was */
+static GSList* old_match(GSList *settings, const BenchWindow *self)
+{
+    GSList *it, *ret = NULL;
+
+    for (it = settings; it; it = g_slist_next(it)) {
+        ObAppSettings *app = it->data;
+        gboolean match = TRUE;
+
+        if (app->name &&
+            !g_pattern_match(app->name, strlen(self->name), self->name, NULL))
+            match = FALSE;
+        else if (app->group_name &&
+            !g_pattern_match(app->group_name,
+                             strlen(self->group_name), self->group_name, NULL))
+            match = FALSE;
+        else if (app->class &&
+                 !g_pattern_match(app->class,
+                                  strlen(self->class), self->class, NULL))
+            match = FALSE;
+        else if (app->group_class &&
+                 !g_pattern_match(app->group_class,
+                                  strlen(self->group_class), self->group_class,
+                                  NULL))
+            match = FALSE;
+        else if (app->role &&
+                 !g_pattern_match(app->role,
+                                  strlen(self->role), self->role, NULL))
+            match = FALSE;
+        else if (app->title && self->title &&
+                 !g_pattern_match(app->title,
+                                  strlen(self->title), self->title, NULL))
+            match = FALSE;
+        else if ((signed)app->type >= 0 && app->type != self->type) {
+            match = FALSE;
+        }
+
+        if (match)
+            ret = g_slist_append(ret, app);
+    }
+    return ret;
+}
+
+static GPatternSpec* maybe_spec(const gchar *pattern)
+{
+    return pattern ? g_pattern_spec_new(pattern) : NULL;
+}
+
+/*! Makes rules like the ones in a big rc.xml: mostly exact classes and
+  names, some with a '*' at one end, some with wildcards in the middle, and
+  some for a title or a type */
+static ObAppSettings* random_rule(ObAppRules *rules)
+{
+    ObAppSettings *app;
+    gchar *name = NULL, *class = NULL, *group_name = NULL;
+    gchar *group_class = NULL, *role = NULL, *title = NULL;
+    gint r = g_random_int_range(0, 100);
+    gint n = g_random_int_range(0, 2000);
+
+    app = g_slice_new0(ObAppSettings);
+    app->type = -1;
+
+    if (r < 35)
+        class = g_strdup_printf("App%d", n);
+    else if (r < 50)
+        name = g_strdup_printf("app%d", n);
+    else if (r < 60) {
+        name = g_strdup_printf("app%d*", n / 10);
+        role = g_strdup_printf("role-%d", n % 3);
+    }
+    else if (r < 70)
+        role = g_strdup_printf("*-%d", n % 50);
+    else if (r < 75)
+        group_class = g_strdup_printf("App%d", n);
+    else if (r < 80)
+        group_name = g_strdup_printf("*%d", n % 100);
+    else if (r < 88)
+        class = g_strdup_printf("A?p%d*", n / 20);
+    else if (r < 94)
+        title = g_strdup_printf("*Document %d*", n % 30);
+    else {
+        app->type = g_random_boolean() ?
+            OB_CLIENT_TYPE_NORMAL : OB_CLIENT_TYPE_DIALOG;
+        if (g_random_boolean())
+            name = g_strdup("*");
+    }
+
+    app->name = maybe_spec(name);
+    app->class = maybe_spec(class);
+    app->group_name = maybe_spec(group_name);
+    app->group_class = maybe_spec(group_class);
+    app->role = maybe_spec(role);
+    app->title = maybe_spec(title);
+    app_rules_add(rules, app, name, class, group_name, group_class, role);
+
+    g_free(name);
+    g_free(class);
+    g_free(group_name);
+    g_free(group_class);
+    g_free(role);
+    g_free(title);
+    return app;
+}
+
+static void random_window(BenchWindow *w)
+{
+    gint n = g_random_int_range(0, 2000);
+
+    w->name = g_strdup_printf("app%d", n);
+    w->class = g_strdup_printf("App%d", n);
+    w->group_name = g_strdup(w->name);
+    w->group_class = g_strdup(w->class);
+    w->role = g_strdup_printf("role-%d", g_random_int_range(0, 100));
+    w->title = g_random_int_range(0, 10) ? g_strdup_printf(
+        "Document %d - Editor", g_random_int_range(0, 100)) : NULL;
+    w->type = g_random_int_range(0, 4) ?
+        OB_CLIENT_TYPE_NORMAL : OB_CLIENT_TYPE_DIALOG;
+}
+
+gint main(gint argc, gchar **argv)
+{
+    ObAppRules *rules;
+    GSList *settings, *old, *new, *it, *jt;
+    BenchWindow *windows;
+    GTimer *timer;
+    gdouble t_old, t_new;
+    gint i, n, n_rules, wrong = 0;
+    gulong matched = 0;
+
+    n_rules = argc > 1 ? atoi(argv[1]) : 1000;
+    n = argc > 2 ? atoi(argv[2]) : 1000;
+    g_random_set_seed(1);
+
+    rules = app_rules_new();
+    settings = NULL;
+    for (i = 0; i < n_rules; ++i)
+        settings = g_slist_prepend(settings, random_rule(rules));
+    settings = g_slist_reverse(settings);
+
+    windows = g_new(BenchWindow, n);
+    for (i = 0; i < n; ++i)
+        random_window(&windows[i]);
+
+    for (i = 0; i < n; ++i) {
+        old = old_match(settings, &windows[i]);
+        new = app_rules_match(rules, windows[i].name, windows[i].class,
+                              windows[i].group_name, windows[i].group_class,
+                              windows[i].role, windows[i].title,
+                              windows[i].type);
+        for (it = old, jt = new; it && jt && it->data == jt->data;
+             it = g_slist_next(it), jt = g_slist_next(jt));
+        if (it || jt) {
+            if (wrong++ < 10)
+                printf("%s: %u settings matched instead of %u\n",
+                       windows[i].name, g_slist_length(new),
+                       g_slist_length(old));
+        }
+        matched += g_slist_length(old);
+        g_slist_free(old);
+        g_slist_free(new);
+    }
+    printf("%d of %d windows matched differently (%lu matches)\n",
+           wrong, n, matched);
+
+    timer = g_timer_new();
+    for (i = 0; i < n; ++i)
+        g_slist_free(old_match(settings, &windows[i]));
+    t_old = g_timer_elapsed(timer, NULL);
+    g_timer_start(timer);
+    for (i = 0; i < n; ++i)
+        g_slist_free(app_rules_match(rules, windows[i].name,
+                                     windows[i].class, windows[i].group_name,
+                                     windows[i].group_class, windows[i].role,
+                                     windows[i].title, windows[i].type));
+    t_new = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    printf("%d rules, %d windows: %.2f ms before, %.2f ms now\n",
+           n_rules, n, t_old * 1000, t_new * 1000);
+
+    return wrong ? 1 : 0;
+}
@@ -0,0 +1,369 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   apprules.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#include "apprules.h"
+
+#include <string.h>
+
+/*! The patterns which rules can be found by, in the order they are
+  picked */
+typedef enum {
+    FIELD_CLASS,
+    FIELD_NAME,
+    FIELD_ROLE,
+    FIELD_GROUP_CLASS,
+    FIELD_GROUP_NAME,
+    NUM_FIELDS
+} RuleField;
+
+/*! The text which is kept for a pattern.  Anything that the pattern matches
+  has to start or end with the text, and then the whole pattern is
+  checked. */
+typedef enum {
+    PATTERN_EXACT,  /* all of it, when there are no wildcards */
+    PATTERN_PREFIX, /* the start, up to the first wildcard */
+    PATTERN_SUFFIX, /* the end, after the last wildcard */
+    NUM_KINDS,
+    PATTERN_OTHER = NUM_KINDS /* it starts and ends with a wildcard */
+} PatternKind;
+
+#define NUM_TYPES (OB_CLIENT_TYPE_NORMAL + 1)
+
+typedef struct {
+    guint order;
+    ObAppSettings *app;
+} AppRule;
+
+typedef struct {
+    const gchar *text;
+    gsize len;
+} RuleKey;
+
+/*! The rules which have the same text in a pattern */
+typedef struct {
+    RuleKey key;
+    GSList *rules;
+} RuleBucket;
+
+typedef struct {
+    /*! RuleBuckets for each kind of pattern, by their text */
+    GHashTable *buckets[NUM_KINDS];
+    /*! The lengths of the text in buckets[PATTERN_PREFIX] and
+      buckets[PATTERN_SUFFIX], without repeats */
+    GArray *lens[NUM_KINDS];
+} FieldIndex;
+
+struct _ObAppRules {
+    guint n;
+    FieldIndex fields[NUM_FIELDS];
+    /*! Rules with no pattern that they can be found by, but with a window
+      type */
+    GSList *types[NUM_TYPES];
+    /*! Rules with no pattern or type that they can be found by, which are
+      tried for every window */
+    GSList *rest;
+};
+
+static guint key_hash(gconstpointer p)
+{
+    const RuleKey *k = p;
+    guint h = 5381;
+    gsize i;
+
+    for (i = 0; i < k->len; ++i)
+        h = h * 33 + (guchar)k->text[i];
+    return h;
+}
+
+static gboolean key_equal(gconstpointer a, gconstpointer b)
+{
+    const RuleKey *ka = a, *kb = b;
+
+    return ka->len == kb->len && !memcmp(ka->text, kb->text, ka->len);
+}
+
+static void bucket_free(RuleBucket *b)
+{
+    GSList *it;
+
+    for (it = b->rules; it; it = g_slist_next(it))
+        g_slice_free(AppRule, it->data);
+    g_slist_free(b->rules);
+    g_free((gchar*)b->key.text);
+    g_slice_free(RuleBucket, b);
+}
+
+/*! Finds the text to keep for a pattern, which is the longest of its start
+  and end without a wildcard */
+static PatternKind pattern_kind(const gchar *pattern, RuleKey *key)
+{
+    gsize n = strlen(pattern), first, last;
+
+    first = strcspn(pattern, "*?");
+    if (first == n) {
+        key->text = pattern;
+        key->len = n;
+        return PATTERN_EXACT;
+    }
+
+    for (last = n; pattern[last-1] != '*' && pattern[last-1] != '?'; --last);
+    if (first == 0 && last == n)
+        return PATTERN_OTHER;
+
+    if (first >= n - last) {
+        key->text = pattern;
+        key->len = first;
+        return PATTERN_PREFIX;
+    }
+    key->text = pattern + last;
+    key->len = n - last;
+    return PATTERN_SUFFIX;
+}
+
+ObAppRules* app_rules_new(void)
+{
+    ObAppRules *self;
+    guint f, k;
+
+    self = g_slice_new0(ObAppRules);
+    for (f = 0; f < NUM_FIELDS; ++f)
+        for (k = 0; k < NUM_KINDS; ++k) {
+            self->fields[f].buckets[k] =
+                g_hash_table_new_full(key_hash, key_equal, NULL,
+                                      (GDestroyNotify)bucket_free);
+            if (k != PATTERN_EXACT)
+                self->fields[f].lens[k] = g_array_new(FALSE, FALSE,
+                                                      sizeof(gsize));
+        }
+    return self;
+}
+
+void app_rules_free(ObAppRules *self)
+{
+    GSList *it;
+    guint f, k;
+
+    if (!self) return;
+
+    for (f = 0; f < NUM_FIELDS; ++f)
+        for (k = 0; k < NUM_KINDS; ++k) {
+            g_hash_table_destroy(self->fields[f].buckets[k]);
+            if (self->fields[f].lens[k])
+                g_array_free(self->fields[f].lens[k], TRUE);
+        }
+    for (k = 0; k < NUM_TYPES; ++k) {
+        for (it = self->types[k]; it; it = g_slist_next(it))
+            g_slice_free(AppRule, it->data);
+        g_slist_free(self->types[k]);
+    }
+    for (it = self->rest; it; it = g_slist_next(it))
+        g_slice_free(AppRule, it->data);
+    g_slist_free(self->rest);
+    g_slice_free(ObAppRules, self);
+}
+
+void app_rules_add(ObAppRules *self, ObAppSettings *app,
+                   const gchar *name, const gchar *class,
+                   const gchar *group_name, const gchar *group_class,
+                   const gchar *role)
+{
+    const gchar *patterns[NUM_FIELDS];
+    AppRule *rule;
+    RuleBucket *b;
+    RuleKey key, best_key;
+    PatternKind kind, best_kind;
+    guint f, best_field, i;
+    GArray *lens;
+
+    patterns[FIELD_CLASS] = class;
+    patterns[FIELD_NAME] = name;
+    patterns[FIELD_ROLE] = role;
+    patterns[FIELD_GROUP_CLASS] = group_class;
+    patterns[FIELD_GROUP_NAME] = group_name;
+
+    rule = g_slice_new(AppRule);
+    rule->order = self->n++;
+    rule->app = app;
+
+    /* use the first pattern with no wildcards, or else the one with the
+       most text next to its wildcard, which should match the fewest
+       windows */
+    best_kind = PATTERN_OTHER;
+    best_field = 0;
+    best_key.text = NULL;
+    best_key.len = 0;
+    for (f = 0; f < NUM_FIELDS && best_kind != PATTERN_EXACT; ++f) {
+        if (!patterns[f]) continue;
+
+        kind = pattern_kind(patterns[f], &key);
+        if (kind == PATTERN_EXACT ||
+            (kind != PATTERN_OTHER && key.len > best_key.len))
+        {
+            best_kind = kind;
+            best_field = f;
+            best_key = key;
+        }
+    }
+
+    if (best_kind == PATTERN_OTHER) {
+        if ((signed)app->type >= 0 && app->type < NUM_TYPES)
+            self->types[app->type] =
+                g_slist_prepend(self->types[app->type], rule);
+        else
+            self->rest = g_slist_prepend(self->rest, rule);
+        return;
+    }
+
+    b = g_hash_table_lookup(self->fields[best_field].buckets[best_kind],
+                            &best_key);
+    if (!b) {
+        b = g_slice_new(RuleBucket);
+        b->key.text = g_strndup(best_key.text, best_key.len);
+        b->key.len = best_key.len;
+        b->rules = NULL;
+        g_hash_table_insert(self->fields[best_field].buckets[best_kind],
+                            &b->key, b);
+
+        if ((lens = self->fields[best_field].lens[best_kind])) {
+            for (i = 0; i < lens->len; ++i)
+                if (g_array_index(lens, gsize, i) == best_key.len) break;
+            if (i == lens->len)
+                g_array_append_val(lens, best_key.len);
+        }
+    }
+    b->rules = g_slist_prepend(b->rules, rule);
+}
+
+/*! Adds the rules in a bucket, if there is one */
+static void add_bucket(GArray *found, GHashTable *buckets,
+                       const gchar *text, gsize len)
+{
+    RuleKey key;
+    RuleBucket *b;
+    GSList *it;
+
+    key.text = text;
+    key.len = len;
+    if ((b = g_hash_table_lookup(buckets, &key)))
+        for (it = b->rules; it; it = g_slist_next(it))
+            g_array_append_val(found, it->data);
+}
+
+static gint rule_cmp(gconstpointer a, gconstpointer b)
+{
+    const AppRule *ra = *(AppRule*const*)a, *rb = *(AppRule*const*)b;
+
+    return ra->order < rb->order ? -1 : (ra->order > rb->order ? 1 : 0);
+}
+
+/*! Checks all of the patterns in a rule */
+static gboolean rule_match(const ObAppSettings *app,
+                           const gchar **values, const gsize *lens,
+                           const gchar *title, ObClientType type)
+{
+    g_assert(app->name != NULL || app->class != NULL ||
+             app->role != NULL || app->title != NULL ||
+             app->group_name != NULL || app->group_class != NULL ||
+             (signed)app->type >= 0);
+
+    if (app->name &&
+        !g_pattern_match(app->name, lens[FIELD_NAME], values[FIELD_NAME],
+                         NULL))
+        return FALSE;
+    else if (app->group_name &&
+             !g_pattern_match(app->group_name, lens[FIELD_GROUP_NAME],
+                              values[FIELD_GROUP_NAME], NULL))
+        return FALSE;
+    else if (app->class &&
+             !g_pattern_match(app->class, lens[FIELD_CLASS],
+                              values[FIELD_CLASS], NULL))
+        return FALSE;
+    else if (app->group_class &&
+             !g_pattern_match(app->group_class, lens[FIELD_GROUP_CLASS],
+                              values[FIELD_GROUP_CLASS], NULL))
+        return FALSE;
+    else if (app->role &&
+             !g_pattern_match(app->role, lens[FIELD_ROLE], values[FIELD_ROLE],
+                              NULL))
+        return FALSE;
+    else if (app->title && title &&
+             !g_pattern_match(app->title, strlen(title), title, NULL))
+        return FALSE;
+    else if ((signed)app->type >= 0 && app->type != type)
+        return FALSE;
+    return TRUE;
+}
+
+GSList* app_rules_match(ObAppRules *self,
+                        const gchar *name, const gchar *class,
+                        const gchar *group_name, const gchar *group_class,
+                        const gchar *role, const gchar *title,
+                        ObClientType type)
+{
+    const gchar *values[NUM_FIELDS];
+    gsize lens[NUM_FIELDS];
+    GArray *found;
+    GSList *it, *ret;
+    guint f, i;
+    gsize n, len;
+
+    values[FIELD_CLASS] = class;
+    values[FIELD_NAME] = name;
+    values[FIELD_ROLE] = role;
+    values[FIELD_GROUP_CLASS] = group_class;
+    values[FIELD_GROUP_NAME] = group_name;
+
+    found = g_array_new(FALSE, FALSE, sizeof(AppRule*));
+
+    for (f = 0; f < NUM_FIELDS; ++f) {
+        const FieldIndex *fi = &self->fields[f];
+
+        n = lens[f] = strlen(values[f]);
+
+        add_bucket(found, fi->buckets[PATTERN_EXACT], values[f], n);
+        for (i = 0; i < fi->lens[PATTERN_PREFIX]->len; ++i) {
+            len = g_array_index(fi->lens[PATTERN_PREFIX], gsize, i);
+            if (len <= n)
+                add_bucket(found, fi->buckets[PATTERN_PREFIX],
+                           values[f], len);
+        }
+        for (i = 0; i < fi->lens[PATTERN_SUFFIX]->len; ++i) {
+            len = g_array_index(fi->lens[PATTERN_SUFFIX], gsize, i);
+            if (len <= n)
+                add_bucket(found, fi->buckets[PATTERN_SUFFIX],
+                           values[f] + n - len, len);
+        }
+    }
+    if ((signed)type >= 0 && type < NUM_TYPES)
+        for (it = self->types[type]; it; it = g_slist_next(it))
+            g_array_append_val(found, it->data);
+    for (it = self->rest; it; it = g_slist_next(it))
+        g_array_append_val(found, it->data);
+
+    /* the settings are applied in the order they were given */
+    g_array_sort(found, rule_cmp);
+
+    ret = NULL;
+    for (i = found->len; i > 0; --i) {
+        AppRule *rule = g_array_index(found, AppRule*, i - 1);
+        if (rule_match(rule->app, values, lens, title, type))
+            ret = g_slist_prepend(ret, rule->app);
+    }
+    g_array_free(found, TRUE);
+    return ret;
+}
@@ -0,0 +1,56 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   apprules.h for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+#ifndef __apprules_h
+#define __apprules_h
+
+#include "config.h"
+
+#include <glib.h>
+
+/*! The per-app settings, sorted by the patterns they match windows with so
+  that the ones which can match a window are found without trying all of
+  them.  Each one is kept in a hash table under one of its patterns with no
+  wildcards, or which has one '*' at the start or end.  Ones without a
+  pattern like that are tried for every window.
+*/
+typedef struct _ObAppRules ObAppRules;
+
+ObAppRules* app_rules_new(void);
+void app_rules_free(ObAppRules *self);
+
+/*! Adds a per-app setting, which is applied after the ones added before it.
+  The patterns are the strings that its GPatternSpecs were made from, or
+  NULL for the ones it doesn't have. */
+void app_rules_add(ObAppRules *self, ObAppSettings *app,
+                   const gchar *name, const gchar *class,
+                   const gchar *group_name, const gchar *group_class,
+                   const gchar *role);
+
+/*! Finds the per-app settings which match a window.  The title can be NULL,
+  and then the settings' titles are not checked.
+  @return A list of ObAppSettings in the order they were added, to be freed
+    with g_slist_free()
+*/
+GSList* app_rules_match(ObAppRules *self,
+                        const gchar *name, const gchar *class,
+                        const gchar *group_name, const gchar *group_class,
+                        const gchar *role, const gchar *title,
+                        ObClientType type);
+
+#endif
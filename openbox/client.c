@@ -36,6 +36,7 @@
 #include "openbox.h"
 #include "group.h"
 #include "config.h"
+#include "apprules.h"
 #include "menuframe.h"
 #include "keyboard.h"
 #include "mouse.h"
@@ -55,6 +56,7 @@
 
 #include <glib.h>
 #include <X11/Xutil.h>
+#include <X11/Xatom.h>
 
 /*! The event mask to grab on client windows */
 #define CLIENT_EVENTMASK (PropertyChangeMask | StructureNotifyMask | \
@@ -69,12 +71,25 @@ typedef struct
     gpointer data;
 } ClientCallback;
 
+/*! The icons made from some _NET_WM_ICON data, which is shared by every
+  window that has the same data */
+typedef struct _ObClientIconPrint
+{
+    guint64 hash; /*!< A fingerprint of the data */
+    guint num;    /*!< The number of 32 bit values in the data */
+    RrImage *img;
+    guint ref;    /*!< The number of windows using it */
+} ObClientIconPrint;
+
 GList          *client_list             = NULL;
 
 static GSList  *client_destroy_notifies = NULL;
 static RrImage *client_default_icon     = NULL;
+/*! The ObClientIconPrints used by any window, keyed by their fingerprint */
+static GHashTable *client_icon_prints   = NULL;
 
 static void client_get_all(ObClient *self, gboolean real);
+static void client_prefetch(Window window);
 static void client_get_startup_id(ObClient *self);
 static void client_get_session_ids(ObClient *self);
 static void client_save_app_rule_values(ObClient *self);
@@ -114,6 +129,9 @@ static gboolean client_can_steal_focus(ObClient *self,
                                        Time steal_time, Time launch_time);
 static void client_setup_default_decor_and_functions(ObClient *self);
 static void client_setup_decor_undecorated(ObClient *self);
+static guint client_icon_print_hash(gconstpointer p);
+static gboolean client_icon_print_equal(gconstpointer a, gconstpointer b);
+static void client_icon_print_unref(ObClientIconPrint *print);
 
 void client_startup(gboolean reconfig)
 {
@@ -123,15 +141,28 @@ void client_startup(gboolean reconfig)
 
     if (reconfig) return;
 
-    client_set_list();
+    client_icon_prints = g_hash_table_new(client_icon_print_hash,
+                                          client_icon_print_equal);
+
+    screen_set_prop_later(OB_SCREEN_PROP_CLIENT_LIST);
 }
 
 void client_shutdown(gboolean reconfig)
 {
+    gulong hits, misses;
+
+    obt_prop_cache_stats(&hits, &misses);
+    ob_debug("Property reads: %lu without a round trip, %lu from the "
+             "server for cached windows", hits, misses);
+
     RrImageUnref(client_default_icon);
     client_default_icon = NULL;
 
     if (reconfig) return;
+
+    /* all the windows were unmanaged, and took their icons with them */
+    g_hash_table_destroy(client_icon_prints);
+    client_icon_prints = NULL;
 }
 
 static void client_call_notifies(ObClient *self, GSList *list)
@@ -202,8 +233,6 @@ void client_set_list(void)
 
     if (windows)
         g_free(windows);
-
-    stacking_set_list();
 }
 
 void client_manage(Window window, ObPrompt *prompt)
@@ -229,6 +258,8 @@ void client_manage(Window window, ObPrompt *prompt)
     attrib_set.do_not_propagate_mask = CLIENT_NOPROPAGATEMASK;
     XChangeWindowAttributes(obt_display, window,
                             CWEventMask|CWDontPropagate, &attrib_set);
+    /* now that we hear about property changes, the properties can be kept */
+    obt_prop_cache_window(window, TRUE);
 
     /* create the ObClient struct, and populate it from the hints on the
        window */
@@ -244,6 +275,7 @@ void client_manage(Window window, ObPrompt *prompt)
     self->desktop = screen_num_desktops; /* always an invalid value */
 
     /* get all the stuff off the window */
+    client_prefetch(window);
     client_get_all(self, TRUE);
 
     ob_debug("Window type: %d", self->type);
@@ -304,6 +336,9 @@ void client_manage(Window window, ObPrompt *prompt)
     if (!OBT_PROP_GET32(self->window, NET_WM_USER_TIME, CARDINAL, &user_time))
         user_time = event_time();
 
+    /* that was the last of the properties read while managing the window */
+    obt_prop_prefetch_done(window);
+
     /* do this after we have a frame.. it uses the frame to help determine the
        WM_STATE to apply. */
     client_change_state(self);
@@ -528,10 +563,10 @@ void client_manage(Window window, ObPrompt *prompt)
 
     /* this has to happen after we're in the client_list */
     if (STRUT_EXISTS(self->strut))
-        screen_update_areas();
+        screen_update_strut(&self->strut, self->desktop);
 
     /* update the list hints */
-    client_set_list();
+    screen_set_prop_later(OB_SCREEN_PROP_CLIENT_LIST);
 
     /* free the ObAppSettings shallow copy */
     g_slice_free(ObAppSettings, settings);
@@ -593,6 +628,7 @@ void client_unmanage(ObClient *self)
     /* we dont want events no more. do this before hiding the frame so we
        don't generate more events */
     XSelectInput(obt_display, self->window, NoEventMask);
+    obt_prop_cache_window(self->window, FALSE);
 
     /* ignore enter events from the unmap so it doesnt mess with the focus */
     if (!config_focus_under_mouse)
@@ -626,13 +662,16 @@ void client_unmanage(ObClient *self)
     self->kill_prompt = NULL;
 
     client_list = g_list_remove(client_list, self);
-    stacking_remove(self);
+    stacking_remove(CLIENT_AS_WINDOW(self));
     window_remove(self->window);
 
     /* once the client is out of the list, update the struts to remove its
        influence */
-    if (STRUT_EXISTS(self->strut))
-        screen_update_areas();
+    if (STRUT_EXISTS(self->strut)) {
+        STRUT_PARTIAL_SET(self->strut, 0, 0, 0, 0,
+                          0, 0, 0, 0, 0, 0, 0, 0);
+        screen_update_strut(&self->strut, self->desktop);
+    }
 
     client_call_notifies(self, client_destroy_notifies);
 
@@ -709,12 +748,13 @@ void client_unmanage(ObClient *self)
     OBT_PROP_ERASE(self->window, NET_WM_VISIBLE_ICON_NAME);
 
     /* update the list hints */
-    client_set_list();
+    screen_set_prop_later(OB_SCREEN_PROP_CLIENT_LIST);
 
     ob_debug("Unmanaged window 0x%lx", self->window);
 
     /* free all data allocated in the client struct */
     RrImageUnref(self->icon_set);
+    client_icon_print_unref(self->icon_print);
     g_slist_free(self->transients);
     g_free(self->startup_id);
     g_free(self->wm_command);
@@ -908,55 +948,24 @@ static gboolean client_can_steal_focus(ObClient *self,
 static ObAppSettings *client_get_settings_state(ObClient *self)
 {
     ObAppSettings *settings;
-    GSList *it;
+    GSList *matches, *it;
 
     settings = config_create_app_settings();
 
-    for (it = config_per_app_settings; it; it = g_slist_next(it)) {
+    matches = app_rules_match(config_per_app_rules,
+                              self->name, self->class,
+                              self->group_name, self->group_class,
+                              self->role, self->title, self->type);
+    for (it = matches; it; it = g_slist_next(it)) {
         ObAppSettings *app = it->data;
-        gboolean match = TRUE;
-
-        g_assert(app->name != NULL || app->class != NULL ||
-                 app->role != NULL || app->title != NULL ||
-                 app->group_name != NULL || app->group_class != NULL ||
-                 (signed)app->type >= 0);
-
-        if (app->name &&
-            !g_pattern_match(app->name, strlen(self->name), self->name, NULL))
-            match = FALSE;
-        else if (app->group_name &&
-            !g_pattern_match(app->group_name,
-                             strlen(self->group_name), self->group_name, NULL))
-            match = FALSE;
-        else if (app->class &&
-                 !g_pattern_match(app->class,
-                                  strlen(self->class), self->class, NULL))
-            match = FALSE;
-        else if (app->group_class &&
-                 !g_pattern_match(app->group_class,
-                                  strlen(self->group_class), self->group_class,
-                                  NULL))
-            match = FALSE;
-        else if (app->role &&
-                 !g_pattern_match(app->role,
-                                  strlen(self->role), self->role, NULL))
-            match = FALSE;
-        else if (app->title && self->title &&
-                 !g_pattern_match(app->title,
-                                  strlen(self->title), self->title, NULL))
-            match = FALSE;
-        else if ((signed)app->type >= 0 && app->type != self->type) {
-            match = FALSE;
-        }
 
-        if (match) {
-            ob_debug("Window matching: %s", app->name);
+        ob_debug("Window matching: %s", app->name);
 
-            /* copy the settings to our struct, overriding the existing
-               settings if they are not defaults */
-            config_app_settings_copy_non_defaults(app, settings);
-        }
+        /* copy the settings to our struct, overriding the existing
+           settings if they are not defaults */
+        config_app_settings_copy_non_defaults(app, settings);
     }
+    g_slist_free(matches);
 
     if (settings->shade != -1)
         self->shaded = !!settings->shade;
@@ -1147,7 +1156,7 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
     */
     found_mon = FALSE;
     for (i = 0; i < screen_num_monitors; ++i) {
-        Rect *a;
+        Rect a;
 
         if (!screen_physical_area_monitor_contains(i, &desired)) {
             if (i < screen_num_monitors - 1 || found_mon)
@@ -1155,10 +1164,11 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
 
             /* the window is not inside any monitor! so just use the first
                one */
-            a = screen_area(self->desktop, 0, NULL);
+            screen_area_get(self->desktop, 0, NULL, &a);
         } else {
             found_mon = TRUE;
-            a = screen_area(self->desktop, SCREEN_AREA_ONE_MONITOR, &desired);
+            screen_area_get(self->desktop, SCREEN_AREA_ONE_MONITOR, &desired,
+                            &a);
         }
 
         /* This makes sure windows aren't entirely outside of the screen so you
@@ -1169,14 +1179,14 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
            only limiting the application.
         */
         if (client_normal(self)) {
-            if (!self->strut.right && *x + fw/10 >= a->x + a->width - 1)
-                *x = a->x + a->width - fw/10;
-            if (!self->strut.bottom && *y + fh/10 >= a->y + a->height - 1)
-                *y = a->y + a->height - fh/10;
-            if (!self->strut.left && *x + fw*9/10 - 1 < a->x)
-                *x = a->x - fw*9/10;
-            if (!self->strut.top && *y + fh*9/10 - 1 < a->y)
-                *y = a->y - fh*9/10;
+            if (!self->strut.right && *x + fw/10 >= a.x + a.width - 1)
+                *x = a.x + a.width - fw/10;
+            if (!self->strut.bottom && *y + fh/10 >= a.y + a.height - 1)
+                *y = a.y + a.height - fh/10;
+            if (!self->strut.left && *x + fw*9/10 - 1 < a.x)
+                *x = a.x - fw*9/10;
+            if (!self->strut.top && *y + fh*9/10 - 1 < a.y)
+                *y = a.y - fh*9/10;
         }
 
         /* This here doesn't let windows even a pixel outside the
@@ -1185,15 +1195,13 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
            xterm -geometry resolution-width/2 will work fine. Trying to
            place it completely offscreen will be handled in the above code.
            Sorry for this confused comment, i am tired. */
-        if (rudel && !self->strut.left && *x < a->x) *x = a->x;
-        if (ruder && !self->strut.right && *x + fw > a->x + a->width)
-            *x = a->x + MAX(0, a->width - fw);
+        if (rudel && !self->strut.left && *x < a.x) *x = a.x;
+        if (ruder && !self->strut.right && *x + fw > a.x + a.width)
+            *x = a.x + MAX(0, a.width - fw);
 
-        if (rudet && !self->strut.top && *y < a->y) *y = a->y;
-        if (rudeb && !self->strut.bottom && *y + fh > a->y + a->height)
-            *y = a->y + MAX(0, a->height - fh);
-
-        g_slice_free(Rect, a);
+        if (rudet && !self->strut.top && *y < a.y) *y = a.y;
+        if (rudeb && !self->strut.bottom && *y + fh > a.y + a.height)
+            *y = a.y + MAX(0, a.height - fh);
     }
 
     /* get where the client should be */
@@ -1202,6 +1210,46 @@ gboolean client_find_onscreen(ObClient *self, gint *x, gint *y, gint w, gint h,
     return ox != *x || oy != *y;
 }
 
+/*! Asks the server for all the properties that are read from the window when
+  it is managed at once, so that they cost a single round trip instead of one
+  each */
+static void client_prefetch(Window window)
+{
+    const Atom props[] = {
+        XA_WM_HINTS,
+        XA_WM_NORMAL_HINTS,
+        OBT_PROP_ATOM(WM_TRANSIENT_FOR),
+        OBT_PROP_ATOM(WM_CLASS),
+        OBT_PROP_ATOM(WM_WINDOW_ROLE),
+        OBT_PROP_ATOM(WM_CLIENT_MACHINE),
+        OBT_PROP_ATOM(WM_COMMAND),
+        OBT_PROP_ATOM(WM_CLIENT_LEADER),
+        OBT_PROP_ATOM(WM_PROTOCOLS),
+        OBT_PROP_ATOM(WM_NAME),
+        OBT_PROP_ATOM(WM_ICON_NAME),
+        OBT_PROP_ATOM(SM_CLIENT_ID),
+        OBT_PROP_ATOM(MOTIF_WM_HINTS),
+        OBT_PROP_ATOM(NET_STARTUP_ID),
+        OBT_PROP_ATOM(NET_WM_NAME),
+        OBT_PROP_ATOM(NET_WM_ICON_NAME),
+        OBT_PROP_ATOM(NET_WM_DESKTOP),
+        OBT_PROP_ATOM(NET_WM_STATE),
+        OBT_PROP_ATOM(NET_WM_WINDOW_TYPE),
+        OBT_PROP_ATOM(NET_WM_STRUT),
+        OBT_PROP_ATOM(NET_WM_STRUT_PARTIAL),
+        OBT_PROP_ATOM(NET_WM_ICON_GEOMETRY),
+        OBT_PROP_ATOM(NET_WM_WINDOW_OPACITY),
+        OBT_PROP_ATOM(NET_WM_USER_TIME),
+        OBT_PROP_ATOM(NET_WM_PID),
+#ifdef SYNC
+        OBT_PROP_ATOM(NET_WM_SYNC_REQUEST_COUNTER),
+#endif
+    };
+
+    /* NET_WM_ICON is left out, it can be huge and is read on its own */
+    obt_prop_prefetch(window, props, G_N_ELEMENTS(props));
+}
+
 static void client_get_all(ObClient *self, gboolean real)
 {
     /* this is needed for the frame to set itself up */
@@ -1401,10 +1449,12 @@ static void client_get_shaped(ObClient *self)
 void client_update_transient_for(ObClient *self)
 {
     Window t = None;
+    guint32 tw32;
     ObClient *target = NULL;
     gboolean trangroup = FALSE;
 
-    if (XGetTransientForHint(obt_display, self->window, &t)) {
+    if (OBT_PROP_GET32(self->window, WM_TRANSIENT_FOR, WINDOW, &tw32)) {
+        t = tw32;
         if (t != self->window) { /* can't be transient to itself! */
             ObWindow *tw = window_find(t);
             /* if this happens then we need to check for it */
@@ -1569,7 +1619,7 @@ void client_get_type_and_transientness(ObClient *self)
 {
     guint num, i;
     guint32 *val;
-    Window t;
+    guint32 t;
 
     self->type = -1;
     self->transient = FALSE;
@@ -1608,7 +1658,7 @@ void client_get_type_and_transientness(ObClient *self)
         g_free(val);
     }
 
-    if (XGetTransientForHint(obt_display, self->window, &t))
+    if (OBT_PROP_GET32(self->window, WM_TRANSIENT_FOR, WINDOW, &t))
         self->transient = TRUE;
 
     if (self->type == (ObClientType) -1) {
@@ -1718,7 +1768,6 @@ void client_update_opacity(ObClient *self)
 void client_update_normal_hints(ObClient *self)
 {
     XSizeHints size;
-    glong ret;
 
     /* defaults */
     self->min_ratio = 0.0f;
@@ -1729,7 +1778,7 @@ void client_update_normal_hints(ObClient *self)
     SIZE_SET(self->max_size, G_MAXINT, G_MAXINT);
 
     /* get the hints from the window */
-    if (XGetWMNormalHints(obt_display, self->window, &size, &ret)) {
+    if (obt_prop_get_wm_normal_hints(self->window, &size)) {
         /* normal windows can't request placement! har har
         if (!client_normal(self))
         */
@@ -2011,7 +2060,7 @@ void client_update_wmhints(ObClient *self)
     /* assume a window takes input if it doesn't specify */
     self->can_focus = TRUE;
 
-    if ((hints = XGetWMHints(obt_display, self->window)) != NULL) {
+    if ((hints = obt_prop_get_wm_hints(self->window)) != NULL) {
         gboolean ur;
 
         if (hints->flags & InputHint)
@@ -2217,7 +2266,54 @@ void client_update_strut(ObClient *self)
         /* updating here is pointless while we're being mapped cuz we're not in
            the client list yet */
         if (self->frame)
-            screen_update_areas();
+            screen_update_strut(&self->strut, self->desktop);
+    }
+}
+
+/*! Returns a fingerprint of some _NET_WM_ICON data, which is much quicker
+  to make than reading the icons in it */
+static guint64 client_icon_data_hash(const guint32 *data, guint num)
+{
+    const guint64 p1 = G_GUINT64_CONSTANT(0x9e3779b185ebca87);
+    const guint64 p2 = G_GUINT64_CONSTANT(0xc2b2ae3d27d4eb4f);
+    guint64 h[4] = { p1, p2, ~p1, ~p2 }, r;
+    guint i, j;
+
+#define MIX(h, v) ((h) += (v) * p2, (h) = (((h) << 31) | ((h) >> 33)) * p1)
+
+    /* four separate sums which don't wait on each other, since the icons
+       can be megabytes */
+    for (i = 0; i + 4 <= num; i += 4)
+        for (j = 0; j < 4; ++j)
+            MIX(h[j], data[i+j]);
+    for (; i < num; ++i)
+        MIX(h[i & 3], data[i]);
+
+    r = num;
+    for (j = 0; j < 4; ++j)
+        MIX(r, h[j]);
+    return r ^ (r >> 29);
+
+#undef MIX
+}
+
+static guint client_icon_print_hash(gconstpointer p)
+{
+    return (guint)((const ObClientIconPrint*)p)->hash;
+}
+
+static gboolean client_icon_print_equal(gconstpointer a, gconstpointer b)
+{
+    const ObClientIconPrint *pa = a, *pb = b;
+    return pa->hash == pb->hash && pa->num == pb->num;
+}
+
+static void client_icon_print_unref(ObClientIconPrint *print)
+{
+    if (print && --print->ref == 0) {
+        g_hash_table_remove(client_icon_prints, print);
+        RrImageUnref(print->img);
+        g_slice_free(ObClientIconPrint, print);
     }
 }
 
@@ -2225,44 +2321,82 @@ void client_update_icons(ObClient *self)
 {
     guint num;
     guint32 *data;
-    guint w, h, i, j;
+    guint w, h, i;
     RrImage *img;
+    ObClientIconPrint key, *print;
 
     img = NULL;
-
-    /* grab the server, because we might be setting the window's icon and
-       we don't want them to set it in between and we overwrite their own
-       icon */
-    grab_server(TRUE);
+    print = NULL;
 
     if (OBT_PROP_GETA32(self->window, NET_WM_ICON, CARDINAL, &data, &num)) {
-        /* figure out how many valid icons are in here */
-        i = 0;
-        while (i + 2 < num) { /* +2 is to make sure there is a w and h */
-            w = data[i++];
-            h = data[i++];
-            /* watch for the data being too small for the specified size,
-               or for zero sized icons. */
-            if (i + w*h > num || w == 0 || h == 0) {
+        /* some clients set the same icons again and again, so look for
+           them by their data before reading any icons out of it */
+        key.hash = client_icon_data_hash(data, num);
+        key.num = num;
+
+        if (self->icon_print &&
+            client_icon_print_equal(&key, self->icon_print))
+        {
+            /* nothing changed */
+            g_free(data);
+            return;
+        }
+
+        if ((print = g_hash_table_lookup(client_icon_prints, &key))) {
+            /* another window has these icons already */
+            ++print->ref;
+            img = print->img;
+            RrImageRef(img);
+        }
+        else {
+            /* figure out how many valid icons are in here */
+            i = 0;
+            while (i + 2 < num) { /* +2 is to make sure there is a w and h */
+                w = data[i++];
+                h = data[i++];
+                /* watch for the data being too small for the specified size,
+                   or for zero sized icons. */
+                if (i + w*h > num || w == 0 || h == 0) {
+                    i += w*h;
+                    continue;
+                }
+
+#if RrDefaultAlphaOffset != 24 || RrDefaultRedOffset != 16 || \
+    RrDefaultGreenOffset != 8 || RrDefaultBlueOffset != 0
+                {
+                    guint j;
+
+                    /* convert it to the right bit order for ObRender */
+                    for (j = 0; j < w*h; ++j)
+                        data[i+j] =
+                            (((data[i+j] >> 24) & 0xff) <<
+                             RrDefaultAlphaOffset) +
+                            (((data[i+j] >> 16) & 0xff) <<
+                             RrDefaultRedOffset) +
+                            (((data[i+j] >>  8) & 0xff) <<
+                             RrDefaultGreenOffset) +
+                            (((data[i+j] >>  0) & 0xff) <<
+                             RrDefaultBlueOffset);
+                }
+#endif
+
+                /* add it to the image cache as an original */
+                if (!img)
+                    img = RrImageNewFromData(ob_rr_icons, &data[i], w, h);
+                else
+                    RrImageAddFromData(img, &data[i], w, h);
+
                 i += w*h;
-                continue;
             }
 
-            /* convert it to the right bit order for ObRender */
-            for (j = 0; j < w*h; ++j)
-                data[i+j] =
-                    (((data[i+j] >> 24) & 0xff) << RrDefaultAlphaOffset) +
-                    (((data[i+j] >> 16) & 0xff) << RrDefaultRedOffset)   +
-                    (((data[i+j] >>  8) & 0xff) << RrDefaultGreenOffset) +
-                    (((data[i+j] >>  0) & 0xff) << RrDefaultBlueOffset);
-
-            /* add it to the image cache as an original */
-            if (!img)
-                img = RrImageNewFromData(ob_rr_icons, &data[i], w, h);
-            else
-                RrImageAddFromData(img, &data[i], w, h);
-
-            i += w*h;
+            if (img) {
+                print = g_slice_new(ObClientIconPrint);
+                *print = key;
+                print->img = img;
+                print->ref = 1;
+                RrImageRef(img);
+                g_hash_table_insert(client_icon_prints, print, print);
+            }
         }
 
         g_free(data);
@@ -2273,7 +2407,7 @@ void client_update_icons(ObClient *self)
     if (!img) {
         XWMHints *hints;
 
-        if ((hints = XGetWMHints(obt_display, self->window))) {
+        if ((hints = obt_prop_get_wm_hints(self->window))) {
             if (hints->flags & IconPixmapHint) {
                 gboolean xicon;
                 obt_display_ignore_errors(TRUE);
@@ -2302,32 +2436,47 @@ void client_update_icons(ObClient *self)
     /* set the client's icons to be whatever we found */
     RrImageUnref(self->icon_set);
     self->icon_set = img;
+    client_icon_print_unref(self->icon_print);
+    self->icon_print = print;
 
     /* if the client has no icon at all, then we set a default icon onto it.
        but, if it has parents, then one of them will have an icon already
     */
     if (!self->icon_set && !self->parents) {
-        RrPixel32 *icon = ob_rr_theme->def_win_icon;
-        gulong *ldata; /* use a long here to satisfy OBT_PROP_SETA32 */
-
-        w = ob_rr_theme->def_win_icon_w;
-        h = ob_rr_theme->def_win_icon_h;
-        ldata = g_new(gulong, w*h+2);
-        ldata[0] = w;
-        ldata[1] = h;
-        for (i = 0; i < w*h; ++i)
-            ldata[i+2] = (((icon[i] >> RrDefaultAlphaOffset) & 0xff) << 24) +
-                (((icon[i] >> RrDefaultRedOffset) & 0xff) << 16) +
-                (((icon[i] >> RrDefaultGreenOffset) & 0xff) << 8) +
-                (((icon[i] >> RrDefaultBlueOffset) & 0xff) << 0);
-        OBT_PROP_SETA32(self->window, NET_WM_ICON, CARDINAL, ldata, w*h+2);
-        g_free(ldata);
+        /* grab the server, because we are setting the window's icon and
+           we don't want them to set it in between and we overwrite their own
+           icon */
+        grab_server(TRUE);
+
+        if (OBT_PROP_GETA32(self->window, NET_WM_ICON, CARDINAL, &data, &num))
+            /* they just set one, and we'll get the property change any
+               second */
+            g_free(data);
+        else {
+            RrPixel32 *icon = ob_rr_theme->def_win_icon;
+            gulong *ldata; /* use a long here to satisfy OBT_PROP_SETA32 */
+
+            w = ob_rr_theme->def_win_icon_w;
+            h = ob_rr_theme->def_win_icon_h;
+            ldata = g_new(gulong, w*h+2);
+            ldata[0] = w;
+            ldata[1] = h;
+            for (i = 0; i < w*h; ++i)
+                ldata[i+2] =
+                    (((icon[i] >> RrDefaultAlphaOffset) & 0xff) << 24) +
+                    (((icon[i] >> RrDefaultRedOffset) & 0xff) << 16) +
+                    (((icon[i] >> RrDefaultGreenOffset) & 0xff) << 8) +
+                    (((icon[i] >> RrDefaultBlueOffset) & 0xff) << 0);
+            OBT_PROP_SETA32(self->window, NET_WM_ICON, CARDINAL, ldata,
+                            w*h+2);
+            g_free(ldata);
+        }
+
+        grab_server(FALSE);
     } else if (self->frame)
         /* don't draw the icon empty if we're just setting one now anyways,
            we'll get the property change any second */
         frame_adjust_icon(self->frame);
-
-    grab_server(FALSE);
 }
 
 void client_update_icon_geometry(ObClient *self)
@@ -3018,28 +3167,27 @@ void client_try_configure(ObClient *self, gint *x, gint *y, gint *w, gint *h,
         user = FALSE; /* ignore if the client can't be moved/resized when it
                          is fullscreening */
     } else if (self->max_horz || self->max_vert) {
-        Rect *a;
+        Rect a;
         guint i;
 
         /* use all possible struts when maximizing to the full screen */
         i = screen_find_monitor(&desired);
-        a = screen_area(self->desktop, i,
-                        (self->max_horz && self->max_vert ? NULL : &desired));
+        screen_area_get(self->desktop, i,
+                        (self->max_horz && self->max_vert ? NULL : &desired),
+                        &a);
 
         /* set the size and position if maximized */
         if (self->max_horz) {
-            *x = a->x;
-            *w = a->width - self->frame->size.left - self->frame->size.right;
+            *x = a.x;
+            *w = a.width - self->frame->size.left - self->frame->size.right;
         }
         if (self->max_vert) {
-            *y = a->y;
-            *h = a->height - self->frame->size.top - self->frame->size.bottom;
+            *y = a.y;
+            *h = a.height - self->frame->size.top - self->frame->size.bottom;
         }
 
         user = FALSE; /* ignore if the client can't be moved/resized when it
                          is maximizing */
-
-        g_slice_free(Rect, a);
     }
 
     /* gets the client's position */
@@ -3760,7 +3908,7 @@ static void client_set_desktop_recursive(ObClient *self,
         if (old != DESKTOP_ALL && !dontraise)
             stacking_raise(CLIENT_AS_WINDOW(self));
         if (STRUT_EXISTS(self->strut))
-            screen_update_areas();
+            screen_update_strut(&self->strut, self->desktop);
         else
             /* the new desktop's geometry may be different, so we may need to
                resize, for example if we are maximized */
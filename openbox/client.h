@@ -310,6 +310,9 @@ struct _ObClient
 
     /* The window's icon, in a variety of shapes and sizes */
     RrImage *icon_set;
+    /*! The _NET_WM_ICON data that icon_set was made from, or NULL if it
+      didn't come from there */
+    struct _ObClientIconPrint *icon_print;
 
     /*! Where the window should iconify to/from */
     Rect icon_geometry;
@@ -350,7 +353,8 @@ ObClient *client_fake_manage(Window win);
 /*! Free the stuff created by client_fake_manage() */
 void client_fake_unmanage(ObClient *self);
 
-/*! Sets the client list on the root window from the client_list */
+/*! Sets the client list on the root window from the client_list now.  Use
+  screen_set_prop_later() to set it when openbox is idle. */
 void client_set_list(void);
 
 /*! Determines if the client should be shown or hidden currently.
@@ -18,6 +18,7 @@
 */
 
 #include "config.h"
+#include "apprules.h"
 #include "keyboard.h"
 #include "mouse.h"
 #include "actions.h"
@@ -50,6 +51,10 @@ gboolean config_theme_keepborder;
 guint    config_theme_window_list_icon_size;
 guint    config_theme_cornerradius;
 gboolean config_theme_menuradius;
+guint    config_theme_render_cache;
+guint    config_theme_icon_cache;
+gboolean config_theme_dither;
+RrScaleFilter config_theme_icon_filter;
 
 gchar   *config_title_layout;
 
@@ -100,6 +105,8 @@ guint    config_submenu_show_delay;
 guint    config_submenu_hide_delay;
 gboolean config_menu_manage_desktops;
 gboolean config_menu_show_icons;
+guint    config_menu_pipe_timeout;
+guint    config_menu_pipe_cache_time;
 
 GSList *config_menu_files;
 
@@ -107,6 +114,7 @@ gint     config_resist_win;
 gint     config_resist_edge;
 
 GSList *config_per_app_settings;
+ObAppRules *config_per_app_rules;
 
 ObAppSettings* config_create_app_settings(void)
 {
@@ -421,6 +429,12 @@ static void parse_per_app_settings(xmlNodePtr node, gpointer d)
         if (type_set)
             settings->type = type;
 
+        parse_single_per_app_settings(app, settings);
+        config_per_app_settings = g_slist_append(config_per_app_settings,
+                                                 (gpointer)settings);
+        app_rules_add(config_per_app_rules, settings,
+                      name, class, group_name, group_class, role);
+
         g_free(name);
         g_free(class);
         g_free(group_name);
@@ -428,10 +442,6 @@ static void parse_per_app_settings(xmlNodePtr node, gpointer d)
         g_free(role);
         g_free(title);
         g_free(type_str);
-
-        parse_single_per_app_settings(app, settings);
-        config_per_app_settings = g_slist_append(config_per_app_settings,
-                                                 (gpointer)settings);
     }
 }
 
@@ -721,6 +731,18 @@ static void parse_theme(xmlNodePtr node, gpointer d)
         else if (config_theme_window_list_icon_size > 96)
             config_theme_window_list_icon_size = 96;
     }
+    if ((n = obt_xml_find_node(node, "renderCacheSize")))
+        config_theme_render_cache = MAX(0, obt_xml_node_int(n));
+    if ((n = obt_xml_find_node(node, "iconCacheSize")))
+        config_theme_icon_cache = MAX(0, obt_xml_node_int(n));
+    if ((n = obt_xml_find_node(node, "dither")))
+        config_theme_dither = obt_xml_node_bool(n);
+    if ((n = obt_xml_find_node(node, "iconFilter"))) {
+        if (obt_xml_node_contains(n, "lanczos"))
+            config_theme_icon_filter = RR_SCALE_LANCZOS;
+        else
+            config_theme_icon_filter = RR_SCALE_BOX;
+    }
     if ((n = obt_xml_find_node(node, "cornerRadius"))) {
 	config_theme_cornerradius = obt_xml_node_int(n);
 	obt_xml_attr_bool(n, "menu", &config_theme_menuradius);
@@ -955,6 +977,10 @@ static void parse_menu(xmlNodePtr node, gpointer d)
         config_submenu_hide_delay = obt_xml_node_int(n);
     if ((n = obt_xml_find_node(node, "manageDesktops")))
         config_menu_manage_desktops = obt_xml_node_bool(n);
+    if ((n = obt_xml_find_node(node, "pipeTimeout")))
+        config_menu_pipe_timeout = MAX(obt_xml_node_int(n), 0);
+    if ((n = obt_xml_find_node(node, "pipeCacheTime")))
+        config_menu_pipe_cache_time = MAX(obt_xml_node_int(n), 0);
     if ((n = obt_xml_find_node(node, "showIcons"))) {
         config_menu_show_icons = obt_xml_node_bool(n);
 #if !defined(USE_IMLIB2) && !defined(USE_LIBRSVG)
@@ -1106,6 +1132,10 @@ void config_startup(ObtXmlInst *i)
     config_theme_window_list_icon_size = 36;
     config_theme_cornerradius = 0;
     config_theme_menuradius = TRUE;
+    config_theme_render_cache = 4096;
+    config_theme_icon_cache = 8192;
+    config_theme_dither = FALSE;
+    config_theme_icon_filter = RR_SCALE_BOX;
 
     config_font_activewindow = NULL;
     config_font_inactivewindow = NULL;
@@ -1175,10 +1205,13 @@ void config_startup(ObtXmlInst *i)
     config_menu_manage_desktops = TRUE;
     config_menu_files = NULL;
     config_menu_show_icons = TRUE;
+    config_menu_pipe_timeout = 10000;
+    config_menu_pipe_cache_time = 0;
 
     obt_xml_register(i, "menu", parse_menu, NULL);
 
     config_per_app_settings = NULL;
+    config_per_app_rules = app_rules_new();
 
     obt_xml_register(i, "applications", parse_per_app_settings, NULL);
 }
@@ -1217,4 +1250,5 @@ void config_shutdown(void)
         g_slice_free(ObAppSettings, it->data);
     }
     g_slist_free(config_per_app_settings);
+    app_rules_free(config_per_app_rules);
 }
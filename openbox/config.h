@@ -156,6 +156,15 @@ extern guint config_theme_window_list_icon_size;
 extern guint config_theme_cornerradius;
 /*! Display rounded corners for root and client-list menus */
 extern gboolean config_theme_menuradius;
+/*! The memory in KiB to use for sharing pixmaps between identical parts of
+  the theme */
+extern guint config_theme_render_cache;
+/*! The disk space in KiB to use for keeping resized icons between restarts */
+extern guint config_theme_icon_cache;
+/*! Dither the theme's colors on screens with 16 bits per pixel or fewer */
+extern gboolean config_theme_dither;
+/*! How icons are made smaller to fit where they are shown */
+extern RrScaleFilter config_theme_icon_filter;
 
 /*! The font for the active window's title */
 extern RrFont *config_font_activewindow;
@@ -215,10 +224,18 @@ extern guint    config_submenu_hide_delay;
 extern gboolean config_menu_manage_desktops;
 /*! Load & show icons in user-defined menus */
 extern gboolean config_menu_show_icons;
+/*! Time to wait for a pipe-menu's command before giving up on it, in
+  milliseconds, or 0 to wait as long as it takes */
+extern guint    config_menu_pipe_timeout;
+/*! How long a pipe-menu keeps the entries its command made, in milliseconds.
+  When it is 0 the command is run again each time a menu is opened. */
+extern guint    config_menu_pipe_cache_time;
 /*! User-specified menu files */
 extern GSList *config_menu_files;
 /*! Per app settings */
 extern GSList *config_per_app_settings;
+/*! The per app settings, sorted to find the ones for a window quickly */
+extern struct _ObAppRules *config_per_app_rules;
 
 void config_startup(ObtXmlInst *i);
 void config_shutdown(void);
@@ -130,7 +130,7 @@ void dock_shutdown(gboolean reconfig)
     XDestroyWindow(obt_display, dock->frame);
     RrAppearanceFree(dock->a_frame);
     window_remove(dock->frame);
-    stacking_remove(dock);
+    stacking_remove(DOCK_AS_WINDOW(dock));
     g_slice_free(ObDock, dock);
     dock = NULL;
 }
@@ -551,9 +551,7 @@ void dock_configure(void)
         dock->area.height += ob_rr_theme->obwidth * 2;
     }
 
-    /* screen_resize() depends on this function to call screen_update_areas(),
-       so if this changes, also update screen_resize(). */
-    screen_update_areas();
+    screen_update_strut(&dock_strut, DESKTOP_ALL);
 }
 
 void dock_app_configure(ObDockApp *app, gint w, gint h)
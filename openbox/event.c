@@ -146,9 +146,29 @@ static void ice_watch(IceConn conn, IcePointer data, Bool opening,
 
 void event_startup(gboolean reconfig)
 {
+    /* these are all read again in full when they change, so only the last
+       change in a burst needs to be handled */
+    const Atom coalesce[] = {
+        OBT_PROP_ATOM(NET_WM_NAME),
+        OBT_PROP_ATOM(WM_NAME),
+        OBT_PROP_ATOM(NET_WM_ICON_NAME),
+        OBT_PROP_ATOM(WM_ICON_NAME),
+        XA_WM_NORMAL_HINTS,
+        XA_WM_HINTS,
+        OBT_PROP_ATOM(MOTIF_WM_HINTS),
+        OBT_PROP_ATOM(WM_PROTOCOLS),
+        OBT_PROP_ATOM(NET_WM_STRUT),
+        OBT_PROP_ATOM(NET_WM_STRUT_PARTIAL),
+        OBT_PROP_ATOM(NET_WM_ICON),
+        OBT_PROP_ATOM(NET_WM_ICON_GEOMETRY),
+        OBT_PROP_ATOM(NET_WM_USER_TIME),
+        OBT_PROP_ATOM(NET_WM_WINDOW_OPACITY)
+    };
+
     if (reconfig) return;
 
     xqueue_add_callback(event_process, NULL);
+    xqueue_coalesce_properties(coalesce, G_N_ELEMENTS(coalesce));
 
 #ifdef USE_SM
     IceAddConnectionWatch(ice_watch, NULL);
@@ -159,8 +179,17 @@ void event_startup(gboolean reconfig)
 
 void event_shutdown(gboolean reconfig)
 {
+    gulong indexed, scanned, checked, coalesced;
+
+    xqueue_stats(&indexed, &scanned, &checked, &coalesced);
+    ob_debug("Event queue searches: %lu used an index, %lu scanned "
+             "%lu events", indexed, scanned, checked);
+    ob_debug("Property changes coalesced: %lu", coalesced);
+
     if (reconfig) return;
 
+    xqueue_coalesce_properties(NULL, 0);
+
 #ifdef USE_SM
     IceRemoveConnectionWatch(ice_watch, NULL);
 #endif
@@ -935,33 +964,34 @@ static gboolean more_client_message_event(Window window, Atom msgtype)
     return xqueue_exists_local(xqueue_match_window_message, &wm);
 }
 
-struct ObSkipPropertyChange {
-    Window window;
-    Atom prop;
-};
+static gboolean is_title_property(Atom a)
+{
+    return (a == OBT_PROP_ATOM(NET_WM_NAME) ||
+            a == OBT_PROP_ATOM(WM_NAME) ||
+            a == OBT_PROP_ATOM(NET_WM_ICON_NAME) ||
+            a == OBT_PROP_ATOM(WM_ICON_NAME));
+}
 
-static gboolean skip_property_change(XEvent *e, gpointer data)
+/*! The title properties are all updated together, so a change to one of them
+  can be skipped if a change to any of them is coming in the queue.  Repeated
+  changes to the same property are already coalesced by the xqueue. */
+static gboolean skip_property_change(Window window, Atom prop)
 {
-    const struct ObSkipPropertyChange s = *(struct ObSkipPropertyChange*)data;
-
-    if (e->type == PropertyNotify && e->xproperty.window == s.window) {
-        const Atom a = e->xproperty.atom;
-        const Atom b = s.prop;
-
-        /* these are all updated together */
-        if ((a == OBT_PROP_ATOM(NET_WM_NAME) ||
-             a == OBT_PROP_ATOM(WM_NAME) ||
-             a == OBT_PROP_ATOM(NET_WM_ICON_NAME) ||
-             a == OBT_PROP_ATOM(WM_ICON_NAME))
-            &&
-            (b == OBT_PROP_ATOM(NET_WM_NAME) ||
-             b == OBT_PROP_ATOM(WM_NAME) ||
-             b == OBT_PROP_ATOM(NET_WM_ICON_NAME) ||
-             b == OBT_PROP_ATOM(WM_ICON_NAME)))
-        {
-            return TRUE;
-        }
-        else if (a == b && a == OBT_PROP_ATOM(NET_WM_ICON))
+    const Atom titles[] = {
+        OBT_PROP_ATOM(NET_WM_NAME),
+        OBT_PROP_ATOM(WM_NAME),
+        OBT_PROP_ATOM(NET_WM_ICON_NAME),
+        OBT_PROP_ATOM(WM_ICON_NAME)
+    };
+    ObtXQueueWindowProperty p;
+    guint i;
+
+    if (!is_title_property(prop)) return FALSE;
+
+    p.window = window;
+    for (i = 0; i < G_N_ELEMENTS(titles); ++i) {
+        p.property = titles[i];
+        if (xqueue_exists_local(xqueue_match_window_property, &p))
             return TRUE;
     }
     return FALSE;
@@ -1617,13 +1647,8 @@ static void event_handle_client(ObClient *client, XEvent *e)
 
         /* ignore changes to some properties if there is another change
            coming in the queue */
-        {
-            struct ObSkipPropertyChange s;
-            s.window = client->window;
-            s.prop = msgtype;
-            if (xqueue_exists_local(skip_property_change, &s))
-                break;
-        }
+        if (skip_property_change(client->window, msgtype))
+            break;
 
         msgtype = e->xproperty.atom;
         if (msgtype == XA_WM_NORMAL_HINTS) {
@@ -97,6 +97,8 @@ void focus_set_client(ObClient *client)
 
     /* set the NET_ACTIVE_WINDOW hint, but preserve it on shutdown */
     if (ob_state() != OB_STATE_EXITING) {
+        /* pagers look for the active window in the client list */
+        screen_flush_props();
         active = client ? client->window : None;
         OBT_PROP_SET32(obt_root(ob_screen), NET_ACTIVE_WINDOW, WINDOW, active);
     }
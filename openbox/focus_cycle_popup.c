@@ -247,6 +247,8 @@ static void popup_target_free(ObFocusCyclePopupTarget *t)
     g_free(t->text);
     XDestroyWindow(obt_display, t->iconwin);
     XDestroyWindow(obt_display, t->textwin);
+    RrPaintForget(ob_rr_inst, t->iconwin);
+    RrPaintForget(ob_rr_inst, t->textwin);
     g_slice_free(ObFocusCyclePopupTarget, t);
 }
 
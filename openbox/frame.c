@@ -231,6 +231,23 @@ void frame_free(ObFrame *self)
     free_theme_statics(self);
 
     XDestroyWindow(obt_display, self->window);
+    /* let go of what was painted on the windows inside it */
+    RrPaintForget(ob_rr_inst, self->title);
+    RrPaintForget(ob_rr_inst, self->topresize);
+    RrPaintForget(ob_rr_inst, self->tltresize);
+    RrPaintForget(ob_rr_inst, self->tllresize);
+    RrPaintForget(ob_rr_inst, self->trtresize);
+    RrPaintForget(ob_rr_inst, self->trrresize);
+    RrPaintForget(ob_rr_inst, self->label);
+    RrPaintForget(ob_rr_inst, self->icon);
+    RrPaintForget(ob_rr_inst, self->max);
+    RrPaintForget(ob_rr_inst, self->iconify);
+    RrPaintForget(ob_rr_inst, self->desk);
+    RrPaintForget(ob_rr_inst, self->shade);
+    RrPaintForget(ob_rr_inst, self->close);
+    RrPaintForget(ob_rr_inst, self->handle);
+    RrPaintForget(ob_rr_inst, self->lgrip);
+    RrPaintForget(ob_rr_inst, self->rgrip);
     if (self->colormap)
         XFreeColormap(obt_display, self->colormap);
 
@@ -283,6 +300,10 @@ void frame_adjust_shape_kind(ObFrame *self, int kind)
     shaped |= (kind == ShapeInput && self->client->shaped_input);
 #endif
 
+    /* the frame's shape is about to be replaced */
+    if (kind == ShapeBounding)
+        self->round_radius = 0;
+
     if (!shaped) {
         /* clear the shape on the frame window */
         XShapeCombineMask(obt_display, self->window, kind,
@@ -334,49 +355,111 @@ void frame_adjust_shape(ObFrame *self)
 #endif
 }
 
-void frame_round_corners(Window window)
+/*! Returns how far in from the sides each of the top @radius rows of a
+  round corner starts.  It is kept for the last radius asked for, since the
+  corners are all the same size. */
+static const gint* corner_insets(gint radius)
 {
-    XWindowAttributes win_attr;
-    XGetWindowAttributes(obt_display, window, &win_attr);
+    static gint *insets = NULL;
+    static gint insets_radius = 0;
+    gint x, y, dx, dy;
+
+    if (radius != insets_radius) {
+        g_free(insets);
+        insets = g_new(gint, radius);
+        insets_radius = radius;
+
+        for (y = 0; y < radius; ++y) {
+            /* find the first pixel whose middle is inside the circle.  the
+               distances are doubled to keep them whole numbers */
+            dy = 2 * (radius - y) - 1;
+            for (x = 0; x < radius; ++x) {
+                dx = 2 * (radius - x) - 1;
+                if (dx * dx + dy * dy <= 4 * radius * radius)
+                    break;
+            }
+            insets[y] = x;
+        }
+    }
+    return insets;
+}
 
-    // If this returns null, the window is invalid.
-    if(!XGetWindowAttributes(obt_display, window, &win_attr))
+void frame_round_corners(Window window, gint width, gint height,
+                         gint border, gint radius)
+{
+#ifdef SHAPE
+    XRectangle *xrect;
+    const gint *insets;
+    gint y, next, n, i;
+
+    /* do not try to round if the window would be smaller than the corners */
+    if (radius <= 0 || width < radius * 2 || height < radius * 2) {
+        XShapeCombineMask(obt_display, window, ShapeBounding,
+                          -border, -border, None, ShapeSet);
         return;
+    }
+
+    insets = corner_insets(radius);
+    xrect = g_new(XRectangle, radius * 2 + 1);
+
+    /* the top rows, where rows next to each other that start at the same
+       place become one rectangle */
+    n = 0;
+    for (y = 0; y < radius; y = next) {
+        for (next = y + 1; next < radius && insets[next] == insets[y];
+             ++next);
+        xrect[n].x = insets[y];
+        xrect[n].y = y;
+        xrect[n].width = width - insets[y] * 2;
+        xrect[n].height = next - y;
+        ++n;
+    }
+    /* the middle */
+    i = n;
+    if (height > radius * 2) {
+        xrect[n].x = 0;
+        xrect[n].y = radius;
+        xrect[n].width = width;
+        xrect[n].height = height - radius * 2;
+        ++n;
+    }
+    /* and the bottom rows, which are the top ones upside down */
+    while (i-- > 0) {
+        xrect[n] = xrect[i];
+        xrect[n].y = height - xrect[i].y - xrect[i].height;
+        ++n;
+    }
 
-    int width = win_attr.border_width * 2 + win_attr.width;
-    int height = win_attr.border_width * 2 + win_attr.height;
-    int rad = config_theme_cornerradius;
-    int dia = 2 * rad;
+    XShapeCombineRectangles(obt_display, window, ShapeBounding,
+                            -border, -border, xrect, n, ShapeSet, YXBanded);
+    g_free(xrect);
+#endif
+}
 
-    // do not try to round if the window would be smaller than the corners
-    if(width < dia || height < dia)
-        return;
+void frame_adjust_corners(ObFrame *self)
+{
+    gint radius;
 
-    Pixmap mask = XCreatePixmap(obt_display, window, width, height, 1);
-    // if this returns null, the mask is not drawable
-    if(!mask)
+    /* shaped windows' frames get their shape from frame_adjust_shape() */
+    if (self->client->shaped)
         return;
 
-    XGCValues xgcv;
-    GC shape_gc = XCreateGC(obt_display, mask, 0, &xgcv);
-    if(!shape_gc) {
-        XFreePixmap(obt_display, mask);
+    if (self->client->fullscreen ||
+        self->client->type == OB_CLIENT_TYPE_DOCK)
+        radius = 0;
+    else
+        radius = config_theme_cornerradius;
+
+    if (radius == self->round_radius &&
+        (!radius || (self->area.width == self->round_w &&
+                     self->area.height == self->round_h)))
         return;
-    }
 
-    XSetForeground(obt_display, shape_gc, 0);
-    XFillRectangle(obt_display, mask, shape_gc, 0, 0, width, height);
-    XSetForeground(obt_display, shape_gc, 1);
-    XFillArc(obt_display, mask, shape_gc, 0, 0, dia, dia, 0, 23040);
-    XFillArc(obt_display, mask, shape_gc, width-dia-1, 0, dia, dia, 0, 23040);
-    XFillArc(obt_display, mask, shape_gc, 0, height-dia-1, dia, dia, 0, 23040);
-    XFillArc(obt_display, mask, shape_gc, width-dia-1, height-dia-1, dia, dia,
-        0, 23040);
-    XFillRectangle(obt_display, mask, shape_gc, rad, 0, width-dia, height);
-    XFillRectangle(obt_display, mask, shape_gc, 0, rad, width, height-dia);
-    XShapeCombineMask(obt_display, window, ShapeBounding, 0-win_attr.border_width, 0-win_attr.border_width, mask, ShapeSet);
-    XFreePixmap(obt_display, mask);
-    XFreeGC(obt_display, shape_gc);
+    frame_round_corners(self->window, self->area.width, self->area.height,
+                        0, radius);
+    self->round_w = self->area.width;
+    self->round_h = self->area.height;
+    self->round_radius = radius;
 }
 
 void frame_adjust_area(ObFrame *self, gboolean moved,
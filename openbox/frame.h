@@ -189,6 +189,12 @@ struct _ObFrame
     gboolean  focused;
     gboolean  need_render;
 
+    /* the size and radius that the round corners were last made for, the
+       radius is 0 when the corners are not round */
+    gint      round_w;
+    gint      round_h;
+    gint      round_radius;
+
     gboolean  flashing;
     gboolean  flash_on;
     GTimeVal  flash_end;
@@ -213,6 +219,17 @@ void frame_adjust_theme(ObFrame *self);
 void frame_adjust_shape_kind(ObFrame *self, int kind);
 #endif
 void frame_adjust_shape(ObFrame *self);
+/*! Rounds the frame's corners, if it should have round corners and they
+  aren't already the right size */
+void frame_adjust_corners(ObFrame *self);
+/*! Sets the shape of a window to a rectangle with round corners, or to no
+  shape if @radius is 0.
+  @param width The width of the window, including its border.
+  @param height The height of the window, including its border.
+  @param border The width of the window's border.
+*/
+void frame_round_corners(Window window, gint width, gint height,
+                         gint border, gint radius);
 void frame_adjust_area(ObFrame *self, gboolean moved,
                        gboolean resized, gboolean fake);
 void frame_adjust_client_area(ObFrame *self);
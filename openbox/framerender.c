@@ -43,11 +43,7 @@ void framerender_frame(ObFrame *self)
         return;
     self->need_render = FALSE;
 
-    if (config_theme_cornerradius &&
-            !self->client->fullscreen &&
-            !self->client->shaped &&
-            !(self->client->type == OB_CLIENT_TYPE_DOCK))
-        frame_round_corners(self->window);
+    frame_adjust_corners(self);
 
     {
         gulong px;
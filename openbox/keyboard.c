@@ -122,6 +122,7 @@ void keyboard_reset_chains(gint break_chroots)
 
 void keyboard_unbind_all(void)
 {
+    tree_index_clear();
     tree_destroy(keyboard_firstnode);
     keyboard_firstnode = NULL;
 }
@@ -238,42 +239,34 @@ gboolean keyboard_event(ObClient *client, const XEvent *e)
     }
 
     used = FALSE;
-    if (curpos == NULL)
-        p = keyboard_firstnode;
-    else
-        p = curpos->first_child;
-    while (p) {
-        if (p->key == e->xkey.keycode && p->state == mods) {
-            /* if we hit a key binding, then close any open menus and run it */
-            if (menu_frame_visible)
-                menu_frame_hide_all();
-
-            if (p->first_child != NULL) { /* part of a chain */
-                if (chain_timer) g_source_remove(chain_timer);
-                /* 3 second timeout for chains */
-                chain_timer =
-                    g_timeout_add_full(G_PRIORITY_DEFAULT,
-                                       3000, chain_timeout, NULL,
-                                       chain_done);
-                set_curpos(p);
-            } else if (p->chroot)         /* an empty chroot */
-                set_curpos(p);
-            else {
-                GSList *it;
-
-                for (it = p->actions; it; it = g_slist_next(it))
-                    if (actions_act_is_interactive(it->data)) break;
-                if (it == NULL) /* reset if the actions are not interactive */
-                    keyboard_reset_chains(0);
-
-                actions_run_acts(p->actions, OB_USER_ACTION_KEYBOARD_KEY,
-                                 e->xkey.state, e->xkey.x_root, e->xkey.y_root,
-                                 0, OB_FRAME_CONTEXT_NONE, client);
-            }
-            used = TRUE;
-            break;
+    if ((p = tree_lookup(curpos, e->xkey.keycode, mods))) {
+        /* if we hit a key binding, then close any open menus and run it */
+        if (menu_frame_visible)
+            menu_frame_hide_all();
+
+        if (p->first_child != NULL) { /* part of a chain */
+            if (chain_timer) g_source_remove(chain_timer);
+            /* 3 second timeout for chains */
+            chain_timer =
+                g_timeout_add_full(G_PRIORITY_DEFAULT,
+                                   3000, chain_timeout, NULL,
+                                   chain_done);
+            set_curpos(p);
+        } else if (p->chroot)         /* an empty chroot */
+            set_curpos(p);
+        else {
+            GSList *it;
+
+            for (it = p->actions; it; it = g_slist_next(it))
+                if (actions_act_is_interactive(it->data)) break;
+            if (it == NULL) /* reset if the actions are not interactive */
+                keyboard_reset_chains(0);
+
+            actions_run_acts(p->actions, OB_USER_ACTION_KEYBOARD_KEY,
+                             e->xkey.state, e->xkey.x_root, e->xkey.y_root,
+                             0, OB_FRAME_CONTEXT_NONE, client);
         }
-        p = p->next_sibling;
+        used = TRUE;
     }
     return used;
 }
@@ -311,8 +304,10 @@ void keyboard_rebind(void)
 {
     KeyBindingTree *old;
 
+    /* the bindings are added again, so their keys are found again */
     old = keyboard_firstnode;
     keyboard_firstnode = NULL;
+    tree_index_clear();
     if (old)
         node_rebind(old);
 
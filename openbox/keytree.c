@@ -22,6 +22,57 @@
 #include "actions.h"
 #include <glib.h>
 
+/*! The nodes in keyboard_firstnode's tree, found by their parent, key and
+  state.  Nodes for keys that didn't get translated are not in it. */
+static GHashTable *tree_index = NULL;
+
+static guint node_hash(gconstpointer p)
+{
+    const KeyBindingTree *n = p;
+
+    return GPOINTER_TO_UINT(n->parent) * 31 + n->key * 257 + n->state;
+}
+
+static gboolean node_equal(gconstpointer a, gconstpointer b)
+{
+    const KeyBindingTree *na = a, *nb = b;
+
+    return na->parent == nb->parent && na->key == nb->key &&
+        na->state == nb->state;
+}
+
+/*! Puts a node that was just added to the main tree in the index, and its
+  children */
+static void tree_index_add(KeyBindingTree *node)
+{
+    KeyBindingTree *c;
+
+    if (!tree_index)
+        tree_index = g_hash_table_new(node_hash, node_equal);
+
+    if (node->key)
+        g_hash_table_insert(tree_index, node, node);
+    for (c = node->first_child; c; c = c->next_sibling)
+        tree_index_add(c);
+}
+
+void tree_index_clear(void)
+{
+    if (tree_index) g_hash_table_remove_all(tree_index);
+}
+
+KeyBindingTree *tree_lookup(KeyBindingTree *parent, guint key, guint state)
+{
+    KeyBindingTree search;
+
+    if (!tree_index || !key) return NULL;
+
+    search.parent = parent;
+    search.key = key;
+    search.state = state;
+    return g_hash_table_lookup(tree_index, &search);
+}
+
 void tree_destroy(KeyBindingTree *tree)
 {
     KeyBindingTree *c;
@@ -70,36 +121,43 @@ KeyBindingTree *tree_build(GList *keylist)
 
 void tree_assimilate(KeyBindingTree *node)
 {
-    KeyBindingTree *a, *b, *tmp, *last;
+    KeyBindingTree *a, *b, *tmp, *parent;
 
     if (keyboard_firstnode == NULL) {
         /* there are no nodes at this level yet */
         keyboard_firstnode = node;
+        tree_index_add(node);
     } else {
-        a = keyboard_firstnode;
-        last = a;
+        /* follow the nodes that are already in the tree, as far as they go */
+        parent = NULL;
         b = node;
-        while (a) {
-            last = a;
-            /* check b->key != 0 for key bindings that didn't get translated */
-            if (!(a->state == b->state && a->key == b->key && b->key != 0)) {
-                a = a->next_sibling;
-            } else {
-                tmp = b;
-                b = b->first_child;
-                g_slice_free(KeyBindingTree, tmp);
-                a = a->first_child;
-            }
+        while ((a = tree_lookup(parent, b->key, b->state))) {
+            tmp = b;
+            b = b->first_child;
+            g_slice_free(KeyBindingTree, tmp);
+            if (a->first_child == NULL)
+                break; /* b goes beside this one */
+            parent = a;
         }
+
         /* check b->key != 0, and save key bindings that didn't get translated
            as siblings here */
-        if (!(last->state == b->state && last->key == b->key && b->key != 0)) {
-            last->next_sibling = b;
-            b->parent = last->parent;
-        } else {
-            last->first_child = b->first_child;
-            last->first_child->parent = last;
+        if (a && a->state == b->state && a->key == b->key && b->key != 0) {
+            a->first_child = b->first_child;
+            a->first_child->parent = a;
             g_slice_free(KeyBindingTree, b);
+            tree_index_add(a->first_child);
+        } else {
+            /* add it at the start of its level */
+            if (parent) {
+                b->next_sibling = parent->first_child;
+                parent->first_child = b;
+            } else {
+                b->next_sibling = keyboard_firstnode;
+                keyboard_firstnode = b;
+            }
+            b->parent = parent;
+            tree_index_add(b);
         }
     }
 }
@@ -110,26 +168,21 @@ KeyBindingTree *tree_find(KeyBindingTree *search, gboolean *conflict)
 
     *conflict = FALSE;
 
-    a = keyboard_firstnode;
-    b = search;
-    while (a && b) {
-        /* check b->key != 0 for key bindings that didn't get translated, and
-           don't make them conflict with anything else so that they can all
-           live together in peace and harmony */
-        if (!(a->state == b->state && a->key == b->key && b->key != 0)) {
-            a = a->next_sibling;
-        } else {
-            if ((a->first_child == NULL) == (b->first_child == NULL)) {
-                if (a->first_child == NULL) {
-                    /* found it! (return the actual node, not the search's) */
-                    return a;
-                }
-            } else {
-                *conflict = TRUE;
-                return NULL; /* the chain status' don't match (conflict!) */
-            }
-            b = b->first_child;
-            a = a->first_child;
+    a = NULL;
+    for (b = search; b; b = b->first_child) {
+        /* key bindings that didn't get translated aren't found, and don't
+           conflict with anything else so that they can all live together in
+           peace and harmony */
+        if (!(a = tree_lookup(a, b->key, b->state)))
+            break;
+
+        if ((a->first_child == NULL) != (b->first_child == NULL)) {
+            *conflict = TRUE;
+            return NULL; /* the chain status' don't match (conflict!) */
+        }
+        if (a->first_child == NULL) {
+            /* found it! (return the actual node, not the search's) */
+            return a;
         }
     }
     return NULL; /* it just isn't in here */
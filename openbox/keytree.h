@@ -42,4 +42,10 @@ void tree_assimilate(KeyBindingTree *node);
 KeyBindingTree *tree_find(KeyBindingTree *search, gboolean *conflict);
 gboolean tree_chroot(KeyBindingTree *tree, GList *keylist);
 
+/*! Finds the node in keyboard_firstnode's tree for a key and state, under
+  @parent, or at the top level if it is NULL */
+KeyBindingTree *tree_lookup(KeyBindingTree *parent, guint key, guint state);
+/*! Forgets the nodes in keyboard_firstnode's tree, before it is replaced */
+void tree_index_clear(void);
+
 #endif
@@ -37,7 +37,16 @@
 #include "obt/xml.h"
 #include "obt/paths.h"
 
+#ifdef HAVE_SIGNAL_H
+#  include <signal.h> /* for kill() */
+#endif
+#ifdef HAVE_SYS_WAIT_H
+#  include <sys/types.h>
+#  include <sys/wait.h>
+#endif
+
 typedef struct _ObMenuParseState ObMenuParseState;
+typedef struct _ObMenuPipe ObMenuPipe;
 
 struct _ObMenuParseState
 {
@@ -52,6 +61,7 @@ static gboolean menu_can_hide = FALSE;
 static guint menu_timeout_id = 0;
 
 static void menu_destroy_hash_value(ObMenu *self);
+static void pipe_close(ObMenu *self, gboolean stop);
 static void parse_menu_item(xmlNodePtr node, gpointer data);
 static void parse_menu_separator(xmlNodePtr node, gpointer data);
 static void parse_menu(xmlNodePtr node, gpointer data);
@@ -133,56 +143,249 @@ void menu_shutdown(gboolean reconfig)
     menu_hash = NULL;
 }
 
-static gboolean menu_pipe_submenu(gpointer key, gpointer val, gpointer data)
+/*! The size of the pieces that a pipe-menu's output is read in */
+#define PIPE_READ_SIZE 4096
+
+struct _ObMenuPipe
+{
+    GPid pid;
+    GIOChannel *channel;
+    guint watch_id;
+    guint timeout_id;
+    /*! The output so far, which is parsed as it arrives */
+    ObtXmlStream *stream;
+    /*! The entry shown in the menu until the output is done */
+    ObMenuEntry *loading;
+};
+
+/*! Stops a pipe-menu's command if it is still running.  Openbox reaps its
+  children from the main loop when it gets a SIGCHLD, so if the command
+  has not been reaped yet, its pid can't belong to another process before
+  this returns to the main loop. */
+static void pipe_stop(GPid pid)
+{
+    pid_t r = waitpid(pid, NULL, WNOHANG);
+
+    /* 0 means it is running, and pid means it had exited and was reaped
+       just now.  -1 means it was reaped already. */
+    if (r == 0)
+        kill(pid, SIGTERM);
+}
+
+static gint64 pipe_now(void)
+{
+    GTimeVal now;
+
+    g_get_current_time(&now);
+    return (gint64)now.tv_sec * 1000 + now.tv_usec / 1000;
+}
+
+/*! Stops reading from a pipe-menu's command and takes away its loading
+  entry.
+  @param stop Stop the command too, when it may still be running */
+static void pipe_close(ObMenu *self, gboolean stop)
+{
+    ObMenuPipe *p = self->pipe;
+
+    if (!p) return;
+
+    if (p->watch_id) g_source_remove(p->watch_id);
+    if (p->timeout_id) g_source_remove(p->timeout_id);
+    /* this closes the pipe.  the command is reaped with openbox's other
+       children when it exits */
+    g_io_channel_unref(p->channel);
+    if (stop)
+        pipe_stop(p->pid);
+
+    obt_xml_stream_free(p->stream);
+
+    /* the entry stays around while its frame is visible */
+    self->entries = g_list_remove(self->entries, p->loading);
+    self->more_menu->entries = self->entries; /* keep it in sync */
+    menu_entry_unref(p->loading);
+
+    g_slice_free(ObMenuPipe, p);
+    self->pipe = NULL;
+}
+
+/*! Replaces the loading entry in a pipe-menu with the output from its
+  command, or leaves it empty if the command did not finish
+  @param ok The command finished writing its output */
+static void pipe_done(ObMenu *self, gboolean ok)
+{
+    ObtXmlStream *stream = self->pipe->stream;
+
+    self->pipe->stream = NULL;
+    pipe_close(self, !ok);
+
+    if (!ok)
+        obt_xml_stream_free(stream);
+    else if (obt_xml_load_stream(menu_parse_inst, stream,
+                                 "openbox_pipe_menu"))
+    {
+        menu_parse_state.pipe_creator = self;
+        menu_parse_state.parent = self;
+        obt_xml_tree_from_root(menu_parse_inst);
+        obt_xml_close(menu_parse_inst);
+    } else
+        g_message(_("Invalid output from pipe-menu \"%s\""), self->execute);
+
+    self->pipe_time = pipe_now();
+    menu_frame_refresh(self);
+}
+
+static gboolean pipe_read_func(GIOChannel *source, GIOCondition cond,
+                               gpointer data)
+{
+    ObMenu *self = data;
+    gchar buf[PIPE_READ_SIZE];
+    gsize n = 0;
+    GIOStatus status;
+
+    status = g_io_channel_read_chars(source, buf, sizeof(buf), &n, NULL);
+    if (status == G_IO_STATUS_NORMAL) {
+        /* stop early if it already can't be parsed */
+        if (obt_xml_stream_push(self->pipe->stream, buf, n))
+            return TRUE; /* keep reading */
+    }
+    else if (status == G_IO_STATUS_AGAIN)
+        return TRUE; /* keep reading */
+
+    self->pipe->watch_id = 0;
+    if (status != G_IO_STATUS_EOF)
+        g_message(_("Invalid output from pipe-menu \"%s\""), self->execute);
+    pipe_done(self, status == G_IO_STATUS_EOF);
+    return FALSE; /* don't read any more */
+}
+
+static gboolean pipe_timeout_func(gpointer data)
+{
+    ObMenu *self = data;
+
+    g_message(_("Pipe-menu \"%s\" did not finish in %u milliseconds"),
+              self->execute, config_menu_pipe_timeout);
+
+    self->pipe->timeout_id = 0;
+    pipe_done(self, FALSE);
+    return FALSE; /* no repeat */
+}
+
+/*! Adds the menus that were made by one of the menus in the list.  The
+  pipe_creator is only compared with the menus in the list, and never
+  followed, as the menu it points to may be gone. */
+static void pipe_find_submenus(gpointer key, gpointer val, gpointer data)
 {
     ObMenu *menu = val;
-    return menu->pipe_creator != NULL;
+    GSList **list = data;
+
+    if (menu->pipe_creator && g_slist_find(*list, menu->pipe_creator) &&
+        !g_slist_find(*list, menu))
+        *list = g_slist_append(*list, menu);
+}
+
+/*! Empties a pipe-menu, so that its command will be run again */
+static void pipe_clear(ObMenu *self)
+{
+    GSList *list, *it;
+    guint n;
+
+    /* the first one in the list is the menu to look for, and its
+       submenus, and theirs, are put after it */
+    list = g_slist_prepend(NULL, self);
+    do {
+        n = g_slist_length(list);
+        g_hash_table_foreach(menu_hash, pipe_find_submenus, &list);
+    } while (g_slist_length(list) != n);
+    for (it = g_slist_next(list); it; it = g_slist_next(it))
+        menu_free(it->data);
+    g_slist_free(list);
+
+    menu_clear_entries(self);
+    self->pipe_time = 0;
 }
 
-static void clear_cache(gpointer key, gpointer val, gpointer data)
+static void find_expired(gpointer key, gpointer val, gpointer data)
 {
     ObMenu *menu = val;
-    if (menu->execute)
-        menu_clear_entries(menu);
+    GSList **names = data;
+    gint64 age;
+
+    if (!menu->execute || !menu->pipe_time)
+        return;
+
+    /* the clock may have been set back, and then it's hard to say how old
+       they are */
+    age = pipe_now() - menu->pipe_time;
+    if (!config_menu_pipe_cache_time || age < 0 ||
+        age >= config_menu_pipe_cache_time)
+        *names = g_slist_prepend(*names, g_strdup(menu->name));
 }
 
 void menu_clear_pipe_caches(void)
 {
-    /* delete any pipe menus' submenus */
-    g_hash_table_foreach_remove(menu_hash, menu_pipe_submenu, NULL);
-    /* empty the top level pipe menus */
-    g_hash_table_foreach(menu_hash, clear_cache, NULL);
+    GSList *names = NULL, *it;
+    ObMenu *menu;
+
+    g_hash_table_foreach(menu_hash, find_expired, &names);
+
+    /* some of them may be submenus of the others, and be gone once
+       those are cleared */
+    for (it = names; it; it = g_slist_next(it)) {
+        if ((menu = g_hash_table_lookup(menu_hash, it->data)))
+            pipe_clear(menu);
+        g_free(it->data);
+    }
+    g_slist_free(names);
 }
 
 void menu_pipe_execute(ObMenu *self)
 {
-    gchar *output;
+    ObMenuPipe *p;
+    gchar **argv = NULL;
+    GPid pid;
+    gint fd;
     GError *err = NULL;
 
     if (!self->execute)
         return;
-    if (self->entries) /* the entries are already created and cached */
+    if (self->pipe || self->pipe_time) /* it is running, or cached */
         return;
 
-    if (!g_spawn_command_line_sync(self->execute, &output, NULL, NULL, &err)) {
+    if (!g_shell_parse_argv(self->execute, NULL, &argv, &err) ||
+        !g_spawn_async_with_pipes(NULL, argv, NULL,
+                                  G_SPAWN_SEARCH_PATH |
+                                  G_SPAWN_DO_NOT_REAP_CHILD,
+                                  NULL, NULL, &pid, NULL, &fd, NULL, &err))
+    {
         g_message(_("Failed to execute command for pipe-menu \"%s\": %s"),
                   self->execute, err->message);
         g_error_free(err);
+        g_strfreev(argv);
+        self->pipe_time = pipe_now();
         return;
     }
-
-    if (obt_xml_load_mem(menu_parse_inst, output, strlen(output),
-                         "openbox_pipe_menu"))
-    {
-        menu_parse_state.pipe_creator = self;
-        menu_parse_state.parent = self;
-        obt_xml_tree_from_root(menu_parse_inst);
-        obt_xml_close(menu_parse_inst);
-    } else {
-        g_message(_("Invalid output from pipe-menu \"%s\""), self->execute);
-    }
-
-    g_free(output);
+    g_strfreev(argv);
+
+    p = self->pipe = g_slice_new(ObMenuPipe);
+    p->pid = pid;
+    p->stream = obt_xml_stream_new();
+
+    p->channel = g_io_channel_unix_new(fd);
+    g_io_channel_set_close_on_unref(p->channel, TRUE);
+    g_io_channel_set_encoding(p->channel, NULL, NULL);
+    g_io_channel_set_buffered(p->channel, FALSE);
+    g_io_channel_set_flags(p->channel, G_IO_FLAG_NONBLOCK, NULL);
+    p->watch_id = g_io_add_watch(p->channel, G_IO_IN | G_IO_HUP | G_IO_ERR,
+                                 pipe_read_func, self);
+
+    p->timeout_id = 0;
+    if (config_menu_pipe_timeout)
+        p->timeout_id = g_timeout_add_full(G_PRIORITY_DEFAULT,
+                                           config_menu_pipe_timeout,
+                                           pipe_timeout_func, self, NULL);
+
+    p->loading = menu_add_normal(self, -1, _("Loading..."), NULL, FALSE);
+    p->loading->data.normal.enabled = FALSE;
 }
 
 static ObMenu* menu_from_name(gchar *name)
@@ -434,6 +637,7 @@ static void menu_destroy_hash_value(ObMenu *self)
     if (self->destroy_func)
         self->destroy_func(self, self->data);
 
+    pipe_close(self, TRUE);
     menu_clear_entries(self);
     g_free(self->name);
     g_free(self->title);
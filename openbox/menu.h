@@ -28,6 +28,7 @@
 struct _ObClient;
 struct _ObMenuFrame;
 struct _ObMenuEntryFrame;
+struct _ObMenuPipe;
 
 typedef struct _ObMenu ObMenu;
 typedef struct _ObMenuEntry ObMenuEntry;
@@ -74,6 +75,11 @@ struct _ObMenu
 
     /* Command to execute to rebuild the menu */
     gchar *execute;
+    /*! The command while it is running, or NULL */
+    struct _ObMenuPipe *pipe;
+    /*! When the command last finished, in milliseconds, or 0 if it has not
+      been run since the menu was emptied */
+    gint64 pipe_time;
 
     /* ObMenuEntry list */
     GList *entries;
@@ -174,9 +180,13 @@ ObMenu* menu_new(const gchar *name, const gchar *title,
                  gboolean allow_shortcut_selection, gpointer data);
 void menu_free(ObMenu *menu);
 
-/*! Repopulate a pipe-menu by running its command */
+/*! Repopulate a pipe-menu by running its command.  The command runs in the
+  background, and until it is done the menu has a single entry saying it is
+  loading.  Then the menu's entries are replaced, and its frames which are
+  visible are updated. */
 void menu_pipe_execute(ObMenu *self);
-/*! Clear a pipe-menu's entries */
+/*! Clear the entries of the pipe-menus which have been kept longer than
+  config_menu_pipe_cache_time */
 void menu_clear_pipe_caches(void);
 
 void menu_show_all_shortcuts(ObMenu *self, gboolean show);
@@ -208,15 +208,19 @@ static void menu_entry_frame_free(ObMenuEntryFrame *self)
 
         XDestroyWindow(obt_display, self->text);
         XDestroyWindow(obt_display, self->window);
+        RrPaintForget(ob_rr_inst, self->text);
+        RrPaintForget(ob_rr_inst, self->window);
         g_hash_table_remove(menu_frame_map, &self->text);
         g_hash_table_remove(menu_frame_map, &self->window);
         if ((self->entry->type == OB_MENU_ENTRY_TYPE_NORMAL) ||
             (self->entry->type == OB_MENU_ENTRY_TYPE_SUBMENU)) {
             XDestroyWindow(obt_display, self->icon);
+            RrPaintForget(ob_rr_inst, self->icon);
             g_hash_table_remove(menu_frame_map, &self->icon);
         }
         if (self->entry->type == OB_MENU_ENTRY_TYPE_SUBMENU) {
             XDestroyWindow(obt_display, self->bullet);
+            RrPaintForget(ob_rr_inst, self->bullet);
             g_hash_table_remove(menu_frame_map, &self->bullet);
         }
 
@@ -846,8 +850,14 @@ void menu_frame_render(ObMenuFrame *self)
 
     RECT_SET_SIZE(self->area, w, h);
 
-    if (config_theme_menuradius)
-        frame_round_corners(self->window);
+    if (config_theme_menuradius &&
+        (w != self->round_w || h != self->round_h))
+    {
+        frame_round_corners(self->window, w, h, ob_rr_theme->mbwidth,
+                            config_theme_cornerradius);
+        self->round_w = w;
+        self->round_h = h;
+    }
 
     XFlush(obt_display);
 }
@@ -956,6 +966,41 @@ static void menu_frame_update(ObMenuFrame *self)
     menu_frame_render(self);
 }
 
+void menu_frame_refresh(ObMenu *menu)
+{
+    GList *it;
+    gint x, y, dx, dy;
+
+    for (it = menu_frame_visible; it; it = g_list_next(it)) {
+        ObMenuFrame *f = it->data;
+
+        if (f->menu != menu) continue;
+
+        /* the entry it was opened from may be gone.  submenus are shown
+           after their parents, so they are before them in the list and it
+           can keep going from here */
+        if (f->child)
+            menu_frame_hide(f->child);
+
+        /* the entries may be different types now, so make them again */
+        while (f->entries) {
+            menu_entry_frame_free(f->entries->data);
+            f->entries = g_list_delete_link(f->entries, f->entries);
+        }
+        menu_frame_update(f);
+
+        /* it changed size, so make sure it still fits on the screen */
+        if (f->parent)
+            menu_frame_place_submenu(f, &x, &y);
+        else {
+            x = f->area.x;
+            y = f->area.y;
+        }
+        menu_frame_move_on_screen(f, x, y, &dx, &dy);
+        menu_frame_move(f, x + dx, y + dy);
+    }
+}
+
 static gboolean menu_frame_is_visible(ObMenuFrame *self)
 {
     return !!(g_list_find(menu_frame_visible, self));
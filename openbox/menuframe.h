@@ -73,6 +73,10 @@ struct _ObMenuFrame
 
     gint monitor; /* monitor on which to show the menu in xinerama */
 
+    /* the size that the round corners were last made for */
+    gint round_w;
+    gint round_h;
+
     /* We make a copy of this for each menu, so that we don't have to re-render
        the background of the entire menu each time we render an item inside it.
     */
@@ -130,6 +134,8 @@ void menu_frame_hide_all(void);
 void menu_frame_hide_all_client(struct _ObClient *client);
 
 void menu_frame_render(ObMenuFrame *self);
+/*! Updates the visible frames of a menu after its entries changed */
+void menu_frame_refresh(struct _ObMenu *menu);
 
 void menu_frame_select(ObMenuFrame *self, ObMenuEntryFrame *entry,
                        gboolean immediate);
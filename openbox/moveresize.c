@@ -71,6 +71,9 @@ static guint sync_timer = 0;
 
 static ObPopup *popup = NULL;
 
+/* how many times screen_area() was called before the move/resize started */
+static gulong start_area_calls, start_area_hits;
+
 static void do_move(gboolean keyboard, gint keydist);
 static void do_resize(void);
 static void do_edge_warp(gint x, gint y);
@@ -267,6 +270,7 @@ void moveresize_start(ObClient *c, gint x, gint y, guint b, guint32 cnr)
 
     moveresize_in_progress = TRUE;
     waiting_for_sync = 0;
+    screen_area_stats(&start_area_calls, &start_area_hits);
 
 #ifdef SYNC
     if (config_resize_redraw && !moving && obt_display_extension_sync &&
@@ -366,6 +370,15 @@ void moveresize_end(gboolean cancel)
     /* dont edge warp after its ended */
     cancel_edge_warp();
 
+    {
+        gulong calls, hits;
+
+        screen_area_stats(&calls, &hits);
+        ob_debug("Screen areas during the %s: %lu asked for, %lu known",
+                 moving ? "move" : "resize",
+                 calls - start_area_calls, hits - start_area_hits);
+    }
+
     moveresize_in_progress = FALSE;
     moveresize_client = NULL;
 }
@@ -51,6 +51,7 @@
 #include "obt/prop.h"
 #include "obt/keyboard.h"
 #include "obt/xml.h"
+#include "obt/paths.h"
 
 #ifdef HAVE_FCNTL_H
 #  include <fcntl.h>
@@ -113,6 +114,7 @@ static void parse_env();
 static void parse_args(gint *argc, gchar **argv);
 static Cursor load_cursor(const gchar *name, guint fontval);
 static void run_startup_cmd(void);
+static void icon_cache_setup(void);
 
 gint main(gint argc, gchar **argv)
 {
@@ -296,6 +298,12 @@ gint main(gint argc, gchar **argv)
 
                 OBT_PROP_SETS(obt_root(ob_screen), OB_THEME,
                               ob_rr_theme->name);
+
+                RrSetRenderCacheSize(ob_rr_inst,
+                                     config_theme_render_cache * 1024);
+                RrSetDither(ob_rr_inst, config_theme_dither);
+                RrSetImageFilter(ob_rr_inst, config_theme_icon_filter);
+                icon_cache_setup();
             }
 
             if (reconfigure) {
@@ -350,6 +358,9 @@ gint main(gint argc, gchar **argv)
             } else {
                 GList *it;
 
+                /* the margins may have changed */
+                screen_update_areas();
+
                 /* redecorate all existing windows */
                 for (it = client_list; it; it = g_list_next(it)) {
                     ObClient *c = it->data;
@@ -417,6 +428,15 @@ gint main(gint argc, gchar **argv)
 
     XSync(obt_display, FALSE);
 
+    {
+        gulong hits, misses, made, reused;
+
+        RrFontCacheStats(&hits, &misses);
+        ob_debug("Text layouts: %lu reused, %lu laid out", hits, misses);
+        RrPixmapPoolStats(&made, &reused);
+        ob_debug("Pixmaps: %lu reused, %lu made", reused, made);
+    }
+
     RrThemeFree(ob_rr_theme);
     RrImageCacheUnref(ob_rr_icons);
     RrInstanceFree(ob_rr_inst);
@@ -588,6 +608,24 @@ static void run_startup_cmd(void)
     }
 }
 
+static void icon_cache_setup(void)
+{
+    ObtPaths *p;
+    gchar *dir;
+
+    p = obt_paths_new();
+    dir = g_build_filename(obt_paths_cache_home(p), "openbox", "icons", NULL);
+    obt_paths_unref(p);
+    p = NULL;
+
+    if (config_theme_icon_cache && !obt_paths_mkdir_path(dir, 0700))
+        g_message(_("Unable to make directory \"%s\": %s"),
+                  dir, g_strerror(errno));
+    RrImageCacheSetDiskCache(ob_rr_icons, dir,
+                             config_theme_icon_cache * 1024);
+    g_free(dir);
+}
+
 static void parse_env(void)
 {
     const gchar *id;
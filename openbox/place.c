@@ -428,7 +428,7 @@ static gboolean place_least_overlap(ObClient *c, Rect *head, int *x, int *y,
     }
 
     if (n_client_rects) {
-        Rect client_rects[n_client_rects];
+        Rect *client_rects = g_new(Rect, n_client_rects);
         GSList* it;
         Point result;
         guint i = 0;
@@ -444,6 +444,7 @@ static gboolean place_least_overlap(ObClient *c, Rect *head, int *x, int *y,
 
         place_overlap_find_least_placement(client_rects, n_client_rects, head,
                                            &frame_size, &result);
+        g_free(client_rects);
         *x = result.x;
         *y = result.y;
     }
@@ -31,26 +31,88 @@ static void make_grid(const Rect* client_rects,
                       int* y_edges,
                       int max_edges);
 
+/* A summed-area table over the grid, which gives the total overlap of
+   any rectangle with the client rectangles without looking at each of
+   them.  Within a grid cell the number of client rectangles covering a
+   point is the same everywhere, so the overlap of the area above and to
+   the left of a point is made of the sum at the cell's top left corner
+   plus the parts of the cell's column, row and the cell itself that are
+   covered.  Each cell is counted once for every client in it, the same
+   as adding up the overlap with each client. */
+typedef struct _OverlapCell {
+    /* the overlap above and left of the cell's top left corner */
+    gint64 sum;
+    /* the overlap of the cells above this one in its column, for a column
+       1 pixel wide */
+    gint64 column;
+    /* the overlap of the cells left of this one in its row, for a row 1
+       pixel high */
+    gint64 row;
+    /* the number of clients in the cell */
+    gint64 cover;
+} OverlapCell;
+
+typedef struct _OverlapTable {
+    const int* x_edges;
+    const int* y_edges;
+    int n_x_edges;
+    int n_y_edges;
+    /* n_x_edges x n_y_edges, where the ones past the last edges are only
+       used for their sums */
+    OverlapCell* cells;
+} OverlapTable;
+
+static void overlap_table_init(OverlapTable* t,
+                               const Rect* client_rects,
+                               int n_client_rects,
+                               const Rect* monitor,
+                               const int* x_edges,
+                               const int* y_edges,
+                               int max_edges);
+
+static void overlap_table_free(OverlapTable* t);
+
+static int grid_cell(int value,
+                     const int* edges,
+                     int n_edges);
+
+static int total_overlap(const OverlapTable* t,
+                         const Rect* proposed_rect);
+
 static int best_direction(const Point* grid_point,
-                          const Rect* client_rects,
-                          int n_client_rects,
+                          const OverlapTable* table,
+                          const int* x_cells,
+                          const int* y_cells,
                           const Rect* monitor,
                           const Size* req_size,
                           Point* best_top_left);
 
-static int total_overlap(const Rect* client_rects,
-                         int n_client_rects,
-                         const Rect* proposed_rect);
-
 static void center_in_field(Point* grid_point,
                             const Size* req_size,
                             const Rect *monitor,
-                            const Rect* client_rects,
-                            int n_client_rects,
+                            const OverlapTable* table,
                             const int* x_edges,
                             const int* y_edges,
                             int max_edges);
 
+/* Find the cells that the sides of a window of size @size fall in, when
+   its left or right side is on each grid line.  For grid line i, these
+   are cells[3*i] when its right side is on the line, cells[3*i + 1] for
+   the line itself, and cells[3*i + 2] when its left side is on it. */
+static int* grid_cells(const int* edges,
+                       int n_edges,
+                       int size)
+{
+    int* cells = g_new(int, 3 * n_edges);
+    int i;
+    for (i = 0; i < n_edges; ++i) {
+        cells[3 * i] = grid_cell(edges[i] - size, edges, n_edges);
+        cells[3 * i + 1] = grid_cell(edges[i], edges, n_edges);
+        cells[3 * i + 2] = grid_cell(edges[i] + size, edges, n_edges);
+    }
+    return cells;
+}
+
 /* Choose the placement on a grid with least overlap */
 
 void place_overlap_find_least_placement(const Rect* client_rects,
@@ -63,23 +125,27 @@ void place_overlap_find_least_placement(const Rect* client_rects,
     int overlap = G_MAXINT;
     int max_edges = 2 * (n_client_rects + 1);
 
-    int x_edges[max_edges];
-    int y_edges[max_edges];
+    int* x_edges = g_new(int, max_edges);
+    int* y_edges = g_new(int, max_edges);
     make_grid(client_rects, n_client_rects, monitor,
             x_edges, y_edges, max_edges);
+
+    OverlapTable table;
+    overlap_table_init(&table, client_rects, n_client_rects, monitor,
+                       x_edges, y_edges, max_edges);
+    int* x_cells = grid_cells(x_edges, table.n_x_edges, req_size->width);
+    int* y_cells = grid_cells(y_edges, table.n_y_edges, req_size->height);
+
     int i;
-    for (i = 0; i < max_edges; ++i) {
-        if (x_edges[i] == G_MAXINT)
-            break;
+    for (i = 0; i < table.n_x_edges; ++i) {
         int j;
-        for (j = 0; j < max_edges; ++j) {
-            if (y_edges[j] == G_MAXINT)
-                break;
+        for (j = 0; j < table.n_y_edges; ++j) {
             Point grid_point = {.x = x_edges[i], .y = y_edges[j]};
             Point best_top_left;
             int this_overlap =
-                best_direction(&grid_point, client_rects, n_client_rects,
-                        monitor, req_size, &best_top_left);
+                best_direction(&grid_point, &table,
+                               &x_cells[3 * i], &y_cells[3 * j],
+                               monitor, req_size, &best_top_left);
             if (this_overlap < overlap) {
                 overlap = this_overlap;
                 *result = best_top_left;
@@ -94,12 +160,17 @@ void place_overlap_find_least_placement(const Rect* client_rects,
         center_in_field(result,
                         req_size,
                         monitor,
-                        client_rects,
-                        n_client_rects,
+                        &table,
                         x_edges,
                         y_edges,
                         max_edges);
     }
+
+    g_free(x_cells);
+    g_free(y_cells);
+    overlap_table_free(&table);
+    g_free(x_edges);
+    g_free(y_edges);
 }
 
 static int compare_ints(const void* a,
@@ -156,20 +227,148 @@ static void make_grid(const Rect* client_rects,
     uniquify(y_edges, n_edges);
 }
 
-static int total_overlap(const Rect* client_rects,
-                         int n_client_rects,
-                         const Rect* proposed_rect)
+static int count_edges(const int* edges,
+                       int max_edges)
 {
-    int overlap = 0;
-    int i;
+    int n = 0;
+    while (n < max_edges && edges[n] != G_MAXINT)
+        ++n;
+    return n;
+}
+
+static int find_edge(int value,
+                     const int* edges,
+                     int n_edges)
+{
+    BSEARCH_SETUP();
+    BSEARCH(int, edges, 0, n_edges, value);
+    g_assert(BSEARCH_FOUND());
+    return BSEARCH_AT();
+}
+
+static void overlap_table_init(OverlapTable* t,
+                               const Rect* client_rects,
+                               int n_client_rects,
+                               const Rect* monitor,
+                               const int* x_edges,
+                               const int* y_edges,
+                               int max_edges)
+{
+    t->x_edges = x_edges;
+    t->y_edges = y_edges;
+    int nx = t->n_x_edges = count_edges(x_edges, max_edges);
+    int ny = t->n_y_edges = count_edges(y_edges, max_edges);
+    g_assert(nx >= 2 && ny >= 2);
+
+    /* Mark where each client starts and ends, with an extra row and
+       column for the ends, then add them up to get the number of clients
+       in each cell. */
+    int* marks = g_new0(int, nx * ny);
+    int i, j;
     for (i = 0; i < n_client_rects; ++i) {
-        if (!RECT_INTERSECTS_RECT(*proposed_rect, client_rects[i]))
+        /* the same clients that make_grid() used */
+        if (!RECT_INTERSECTS_RECT(client_rects[i], *monitor))
             continue;
-        Rect rtemp;
-        RECT_SET_INTERSECTION(rtemp, *proposed_rect, client_rects[i]);
-        overlap += RECT_AREA(rtemp);
+        int x1 = find_edge(client_rects[i].x, x_edges, nx);
+        int x2 = find_edge(client_rects[i].x + client_rects[i].width,
+                           x_edges, nx);
+        int y1 = find_edge(client_rects[i].y, y_edges, ny);
+        int y2 = find_edge(client_rects[i].y + client_rects[i].height,
+                           y_edges, ny);
+        marks[x1 * ny + y1] += 1;
+        marks[x2 * ny + y1] -= 1;
+        marks[x1 * ny + y2] -= 1;
+        marks[x2 * ny + y2] += 1;
     }
-    return overlap;
+
+    OverlapCell* c = t->cells = g_new0(OverlapCell, nx * ny);
+    for (i = 0; i < nx - 1; ++i)
+        for (j = 0; j < ny - 1; ++j) {
+            gint64 cover = marks[i * ny + j];
+            if (i > 0)
+                cover += c[(i - 1) * ny + j].cover;
+            if (j > 0)
+                cover += c[i * ny + j - 1].cover;
+            if (i > 0 && j > 0)
+                cover -= c[(i - 1) * ny + j - 1].cover;
+            c[i * ny + j].cover = cover;
+        }
+    g_free(marks);
+
+    for (i = 0; i < nx; ++i)
+        for (j = 0; j < ny; ++j) {
+            OverlapCell* cell = &c[i * ny + j];
+            if (j > 0) {
+                const OverlapCell* above = &c[i * ny + j - 1];
+                cell->column = above->column +
+                    above->cover * (y_edges[j] - y_edges[j - 1]);
+            }
+            if (i > 0) {
+                const OverlapCell* left = &c[(i - 1) * ny + j];
+                int width = x_edges[i] - x_edges[i - 1];
+                cell->row = left->row + left->cover * width;
+                cell->sum = left->sum + left->column * width;
+            }
+        }
+}
+
+
+static void overlap_table_free(OverlapTable* t)
+{
+    g_free(t->cells);
+}
+
+/* Returns the cell that @value falls in, which is the last one for a
+   value on the last edge. */
+static int grid_cell(int value,
+                     const int* edges,
+                     int n_edges)
+{
+    BSEARCH_SETUP();
+    BSEARCH(int, edges, 0, n_edges, value);
+    return MIN((int)BSEARCH_AT(), n_edges - 2);
+}
+
+/* The overlap above and left of the point (@x, @y), which is in the cell
+   (@cx, @cy) */
+static gint64 overlap_to(const OverlapTable* t,
+                         int cx, int x,
+                         int cy, int y)
+{
+    const OverlapCell* cell = &t->cells[cx * t->n_y_edges + cy];
+    gint64 dx = x - t->x_edges[cx];
+    gint64 dy = y - t->y_edges[cy];
+    return cell->sum + dx * cell->column + dy * cell->row +
+        dx * dy * cell->cover;
+}
+
+/* The overlap of the rectangle from (@x1, @y1) to (@x2, @y2), whose
+   corners are in the cells (@cx1, @cy1) and (@cx2, @cy2). */
+static int overlap_in(const OverlapTable* t,
+                      int cx1, int x1, int cy1, int y1,
+                      int cx2, int x2, int cy2, int y2)
+{
+    gint64 overlap = overlap_to(t, cx2, x2, cy2, y2) -
+        overlap_to(t, cx1, x1, cy2, y2) -
+        overlap_to(t, cx2, x2, cy1, y1) +
+        overlap_to(t, cx1, x1, cy1, y1);
+    return (int)MIN(overlap, G_MAXINT);
+}
+
+/* The rectangle must be within the grid, which it is when it is within
+   the monitor. */
+static int total_overlap(const OverlapTable* t,
+                         const Rect* proposed_rect)
+{
+    int x1 = proposed_rect->x;
+    int y1 = proposed_rect->y;
+    int x2 = x1 + proposed_rect->width;
+    int y2 = y1 + proposed_rect->height;
+    return overlap_in(t,
+                      grid_cell(x1, t->x_edges, t->n_x_edges), x1,
+                      grid_cell(y1, t->y_edges, t->n_y_edges), y1,
+                      grid_cell(x2, t->x_edges, t->n_x_edges), x2,
+                      grid_cell(y2, t->y_edges, t->n_y_edges), y2);
 }
 
 static int find_first_grid_position_greater_or_equal(int search_value,
@@ -210,8 +409,7 @@ typedef struct _ExpandInfo {
     int orig_width;
     int orig_height;
     const Rect* monitor;
-    const Rect* client_rects;
-    int n_client_rects;
+    const OverlapTable* table;
     int max_edges;
 } ExpandInfo;
 
@@ -230,8 +428,8 @@ static int expand_field(int orig_edge_index,
     while (edge_index < i->max_edges - 1) {
         int next_edge_index = edge_index + 1;
         (*expand_by)(&field, edges[next_edge_index] - edges[edge_index]);
-        int overlap = total_overlap(i->client_rects, i->n_client_rects, &field);
-        if (overlap != 0 || !RECT_CONTAINS_RECT(*(i->monitor), field))
+        if (!RECT_CONTAINS_RECT(*(i->monitor), field) ||
+            total_overlap(i->table, &field) != 0)
             break;
         edge_index = next_edge_index;
     }
@@ -251,8 +449,7 @@ static int expand_field(int orig_edge_index,
 static void center_in_field(Point* top_left,
                             const Size* req_size,
                             const Rect *monitor,
-                            const Rect* client_rects,
-                            int n_client_rects,
+                            const OverlapTable* table,
                             const int* x_edges,
                             const int* y_edges,
                             int max_edges)
@@ -269,8 +466,7 @@ static void center_in_field(Point* top_left,
         .orig_width = x_edges[orig_right_edge_index] - top_left->x,
         .orig_height = y_edges[orig_bottom_edge_index] - top_left->y,
         .monitor = monitor,
-        .client_rects = client_rects,
-        .n_client_rects = n_client_rects,
+        .table = table,
         .max_edges = max_edges};
     /* Try extending width. */
     int right_edge_index =
@@ -293,17 +489,19 @@ static void center_in_field(Point* top_left,
     top_left->y += (final_height - req_size->height) / 2;
 }
 
-/* Given a list of Rect RECTS, a Point PT and a Size size, determine the
-   direction from PT which results in the least total overlap with RECTS
-   if a rectangle is placed in that direction.  Return the top/left
-   Point of such rectangle and the resulting overlap amount.  Only
-   consider placements within BOUNDS. */
+/* Given an OverlapTable TABLE, a Point PT and a Size size, determine the
+   direction from PT which results in the least total overlap with the
+   client rectangles if a rectangle is placed in that direction.  Return
+   the top/left Point of such rectangle and the resulting overlap amount.
+   Only consider placements within BOUNDS.  X_CELLS and Y_CELLS are PT's
+   entries from grid_cells(). */
 
 #define NUM_DIRECTIONS 4
 
 static int best_direction(const Point* grid_point,
-                          const Rect* client_rects,
-                          int n_client_rects,
+                          const OverlapTable* table,
+                          const int* x_cells,
+                          const int* y_cells,
                           const Rect* monitor,
                           const Size* req_size,
                           Point* best_top_left)
@@ -322,7 +520,14 @@ static int best_direction(const Point* grid_point,
         RECT_SET(r, pt.x, pt.y, req_size->width, req_size->height);
         if (!RECT_CONTAINS_RECT(*monitor, r))
             continue;
-        int this_overlap = total_overlap(client_rects, n_client_rects, &r);
+        /* the rectangle's sides are either on the grid point or a size
+           away from it */
+        int this_overlap =
+            overlap_in(table,
+                       x_cells[1 + directions[i].width], r.x,
+                       y_cells[1 + directions[i].height], r.y,
+                       x_cells[2 + directions[i].width], r.x + r.width,
+                       y_cells[2 + directions[i].height], r.y + r.height);
         if (this_overlap < overlap) {
             overlap = this_overlap;
             *best_top_left = pt;
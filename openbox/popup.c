@@ -71,7 +71,7 @@ void popup_free(ObPopup *self)
         RrAppearanceFree(self->a_bg);
         RrAppearanceFree(self->a_text);
         window_remove(self->bg);
-        stacking_remove(self);
+        stacking_remove(INTERNAL_AS_WINDOW(self));
         g_slice_free(ObPopup, self);
     }
 }
@@ -541,8 +541,10 @@ void pager_popup_delay_show(ObPagerPopup *self, gulong msec,
     guint i;
 
     if (screen_num_desktops < self->desks)
-        for (i = screen_num_desktops; i < self->desks; ++i)
+        for (i = screen_num_desktops; i < self->desks; ++i) {
             XDestroyWindow(obt_display, self->wins[i]);
+            RrPaintForget(ob_rr_inst, self->wins[i]);
+        }
 
     if (screen_num_desktops != self->desks)
         self->wins = g_renew(Window, self->wins, screen_num_desktops);
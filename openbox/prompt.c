@@ -199,10 +199,13 @@ void prompt_unref(ObPrompt *self)
         for (i = 0; i < self->n_buttons; ++i) {
             window_remove(self->button[i].window);
             XDestroyWindow(obt_display, self->button[i].window);
+            RrPaintForget(ob_rr_inst, self->button[i].window);
         }
 
         XDestroyWindow(obt_display, self->msg.window);
         XDestroyWindow(obt_display, self->super.window);
+        RrPaintForget(ob_rr_inst, self->msg.window);
+        RrPaintForget(ob_rr_inst, self->super.window);
         g_slice_free(ObPrompt, self);
     }
 }
@@ -135,7 +135,7 @@ void resist_move_windows(ObClient *c, gint resist, gint *x, gint *y)
 
 void resist_move_monitors(ObClient *c, gint resist, gint *x, gint *y)
 {
-    Rect *area;
+    Rect area;
     const Rect *parea;
     guint i;
     gint l, t, r, b; /* requested edges */
@@ -171,13 +171,13 @@ void resist_move_monitors(ObClient *c, gint resist, gint *x, gint *y)
         if (!RECT_INTERSECTS_RECT(*parea, c->frame->area))
             continue;
 
-        area = screen_area(c->desktop, SCREEN_AREA_ALL_MONITORS,
-                           &desired_area);
+        screen_area_get(c->desktop, SCREEN_AREA_ALL_MONITORS,
+                        &desired_area, &area);
 
-        al = RECT_LEFT(*area);
-        at = RECT_TOP(*area);
-        ar = RECT_RIGHT(*area);
-        ab = RECT_BOTTOM(*area);
+        al = RECT_LEFT(area);
+        at = RECT_TOP(area);
+        ar = RECT_RIGHT(area);
+        ab = RECT_BOTTOM(area);
         pl = RECT_LEFT(*parea);
         pt = RECT_TOP(*parea);
         pr = RECT_RIGHT(*parea);
@@ -200,8 +200,6 @@ void resist_move_monitors(ObClient *c, gint resist, gint *x, gint *y)
             *y = pt;
         else if (cb <= pb && b > pb && b < pb + resist)
             *y = pb - h + 1;
-
-        g_slice_free(Rect, area);
     }
 
     frame_frame_gravity(c->frame, x, y);
@@ -324,7 +322,7 @@ void resist_size_monitors(ObClient *c, gint resist, gint *w, gint *h,
 {
     gint l, t, r, b; /* my left, top, right and bottom sides */
     gint dlt, drb; /* my destination left/top and right/bottom sides */
-    Rect *area;
+    Rect area;
     const Rect *parea;
     gint al, at, ar, ab; /* screen boundaries */
     gint pl, pt, pr, pb; /* physical screen boundaries */
@@ -346,14 +344,14 @@ void resist_size_monitors(ObClient *c, gint resist, gint *w, gint *h,
         if (!RECT_INTERSECTS_RECT(*parea, c->frame->area))
             continue;
 
-        area = screen_area(c->desktop, SCREEN_AREA_ALL_MONITORS,
-                           &desired_area);
+        screen_area_get(c->desktop, SCREEN_AREA_ALL_MONITORS,
+                        &desired_area, &area);
 
         /* get the screen boundaries */
-        al = RECT_LEFT(*area);
-        at = RECT_TOP(*area);
-        ar = RECT_RIGHT(*area);
-        ab = RECT_BOTTOM(*area);
+        al = RECT_LEFT(area);
+        at = RECT_TOP(area);
+        ar = RECT_RIGHT(area);
+        ab = RECT_BOTTOM(area);
         pl = RECT_LEFT(*parea);
         pt = RECT_TOP(*parea);
         pr = RECT_RIGHT(*parea);
@@ -410,7 +408,5 @@ void resist_size_monitors(ObClient *c, gint resist, gint *w, gint *h,
                 *h = b - pt + 1;
             break;
         }
-
-        g_slice_free(Rect, area);
     }
 }
@@ -73,11 +73,6 @@ static gboolean screen_desktop_timeout = TRUE;
 static guint    screen_desktop_timer = 0;
 /*! An array of desktops, holding an array of areas per monitor */
 static Rect  *monitor_area = NULL;
-/*! An array of desktops, holding an array of struts */
-static GSList *struts_top = NULL;
-static GSList *struts_left = NULL;
-static GSList *struts_right = NULL;
-static GSList *struts_bottom = NULL;
 
 static ObPagerPopup *desktop_popup;
 static guint         desktop_popup_timer = 0;
@@ -460,6 +455,13 @@ void screen_startup(gboolean reconfig)
 
 void screen_shutdown(gboolean reconfig)
 {
+    gulong written, skipped;
+
+    screen_flush_props();
+    screen_prop_stats(&written, &skipped);
+    ob_debug("Root properties: %lu set, %lu changes skipped while waiting "
+             "to be set", written, skipped);
+
     pager_popup_free(desktop_popup);
 
     if (reconfig)
@@ -498,8 +500,8 @@ void screen_resize(void)
     if (ob_state() != OB_STATE_RUNNING)
         return;
 
-    /* this calls screen_update_areas(), which we need ! */
     dock_configure();
+    screen_update_areas();
 
     for (it = client_list; it; it = g_list_next(it)) {
         client_move_onscreen(it->data, FALSE);
@@ -1330,31 +1332,205 @@ void screen_install_colormap(ObClient *client, gboolean install)
 }
 
 typedef struct {
-    guint desktop;
-    StrutPartial *strut;
+    /*! The list in struts that this is in */
+    guint slot;
+    /*! A copy of the strut, limited to half of the screen */
+    StrutPartial strut;
 } ObScreenStrut;
 
-#define RESET_STRUT_LIST(sl) \
-    while (sl) { \
-        g_slice_free(ObScreenStrut, (sl)->data); \
-        sl = g_slist_delete_link(sl, sl); \
+/*! The struts on each desktop, holding a list of ObScreenStrut for each of
+  strut_desktops desktops, and one more list for the struts on all
+  desktops */
+static GSList  **struts = NULL;
+static guint     strut_desktops = 0;
+/*! Finds the ObScreenStrut in struts for a StrutPartial that it copies */
+static GHashTable *strut_map = NULL;
+/*! The areas without struts for each desktop in struts, plus one for all
+  desktops, holding an area for each monitor plus one for all monitors.  It
+  is kept up to date as the struts change, so that screen_area() doesn't
+  have to look at them when it isn't given a search area. */
+static Rect     *desktop_areas = NULL;
+
+/*! The most areas to remember for screen_area() calls with a search area */
+#define AREA_CACHE_SIZE 64
+
+typedef struct {
+    guint desktop;
+    guint head;
+    Rect search;
+    Rect area;
+} ObScreenArea;
+
+/*! The areas found for screen_area() calls with a search area, which are
+  forgotten whenever any strut changes */
+static GHashTable *area_cache = NULL;
+static gulong area_calls = 0;
+static gulong area_hits = 0;
+
+/*! The ObScreenProps waiting to be set */
+static guint  props_waiting = 0;
+static guint  props_idle_id = 0;
+static gulong props_written = 0;
+static gulong props_skipped = 0;
+
+static void area_calc(guint desktop, guint head, const Rect *search,
+                      Rect *a);
+
+static guint area_hash(const ObScreenArea *k)
+{
+    guint h;
+
+    h = k->desktop * 31 + k->head;
+    h = h * 31 + k->search.x;
+    h = h * 31 + k->search.y;
+    h = h * 31 + k->search.width;
+    return h * 31 + k->search.height;
+}
+
+static gboolean area_equal(const ObScreenArea *a, const ObScreenArea *b)
+{
+    return a->desktop == b->desktop && a->head == b->head &&
+        RECT_EQUAL(a->search, b->search);
+}
+
+static void area_free(ObScreenArea *k)
+{
+    g_slice_free(ObScreenArea, k);
+}
+
+static void area_cache_clear(void)
+{
+    if (area_cache)
+        g_hash_table_remove_all(area_cache);
+    else
+        area_cache = g_hash_table_new_full((GHashFunc)area_hash,
+                                           (GEqualFunc)area_equal,
+                                           (GDestroyNotify)area_free, NULL);
+}
+
+/*! Gives the list in struts for a strut on @desktop, or G_MAXUINT if it
+  should not be in any of them */
+static guint strut_slot(const StrutPartial *s, guint desktop)
+{
+    if (!STRUT_EXISTS(*s)) return G_MAXUINT;
+    if (desktop == DESKTOP_ALL) return strut_desktops;
+    if (desktop < strut_desktops) return desktop;
+    return G_MAXUINT;
+}
+
+/*! Keeps struts from taking up more than half of the screen */
+static void strut_clamp(StrutPartial *s)
+{
+    s->left = MIN(s->left, monitor_area[screen_num_monitors].width / 2);
+    s->right = MIN(s->right, monitor_area[screen_num_monitors].width / 2);
+    s->top = MIN(s->top, monitor_area[screen_num_monitors].height / 2);
+    s->bottom = MIN(s->bottom, monitor_area[screen_num_monitors].height / 2);
+}
+
+static void strut_index_add(StrutPartial *owner, guint slot)
+{
+    ObScreenStrut *ss;
+
+    if (slot == G_MAXUINT) return;
+
+    ss = g_slice_new(ObScreenStrut);
+    ss->slot = slot;
+    ss->strut = *owner;
+    strut_clamp(&ss->strut);
+    struts[slot] = g_slist_prepend(struts[slot], ss);
+    g_hash_table_insert(strut_map, owner, ss);
+}
+
+static void strut_index_remove(StrutPartial *owner)
+{
+    ObScreenStrut *ss;
+
+    if ((ss = g_hash_table_lookup(strut_map, owner))) {
+        struts[ss->slot] = g_slist_remove(struts[ss->slot], ss);
+        g_hash_table_remove(strut_map, owner);
+        g_slice_free(ObScreenStrut, ss);
+    }
+}
+
+/*! Empties the strut index and sizes it for the current desktops */
+static void strut_index_reset(void)
+{
+    guint i;
+
+    if (struts) {
+        for (i = 0; i <= strut_desktops; ++i)
+            while (struts[i]) {
+                g_slice_free(ObScreenStrut, struts[i]->data);
+                struts[i] = g_slist_delete_link(struts[i], struts[i]);
+            }
+        g_free(struts);
+        g_hash_table_destroy(strut_map);
     }
+    area_cache_clear();
+
+    strut_desktops = screen_num_desktops;
+    struts = g_new0(GSList*, strut_desktops + 1);
+    strut_map = g_hash_table_new(g_direct_hash, g_direct_equal);
 
-#define ADD_STRUT_TO_LIST(sl, d, s) \
-{ \
-    ObScreenStrut *ss = g_slice_new(ObScreenStrut); \
-    ss->desktop = d; \
-    ss->strut = s;  \
-    sl = g_slist_prepend(sl, ss); \
+    g_free(desktop_areas);
+    desktop_areas = g_new(Rect, (strut_desktops + 1) *
+                          (screen_num_monitors + 1));
 }
 
-#define VALIDATE_STRUTS(sl, side, max) \
-{ \
-    GSList *it; \
-    for (it = sl; it; it = g_slist_next(it)) { \
-      ObScreenStrut *ss = it->data; \
-      ss->strut->side = MIN(max, ss->strut->side); \
-    } \
+/*! Finds the areas without struts for the desktop in one of the lists in
+  struts.
+  @return TRUE if the area for all of the monitors has changed
+*/
+static gboolean desktop_areas_update(guint slot)
+{
+    Rect *row, all;
+    guint i;
+
+    row = &desktop_areas[slot * (screen_num_monitors + 1)];
+    all = row[screen_num_monitors];
+    for (i = 0; i < screen_num_monitors; ++i)
+        area_calc(slot == strut_desktops ? DESKTOP_ALL : slot, i, NULL,
+                  &row[i]);
+    area_calc(slot == strut_desktops ? DESKTOP_ALL : slot,
+              SCREEN_AREA_ALL_MONITORS, NULL, &row[screen_num_monitors]);
+    return !RECT_EQUAL(all, row[screen_num_monitors]);
+}
+
+/*! Sets the legacy workarea hint to the union of all the monitors */
+static void set_workarea(void)
+{
+    gulong *dims;
+    guint i;
+
+    dims = g_new(gulong, 4 * screen_num_desktops);
+    for (i = 0; i < screen_num_desktops; ++i) {
+        const Rect *area =
+            &desktop_areas[i * (screen_num_monitors + 1) + screen_num_monitors];
+        dims[i*4+0] = area->x;
+        dims[i*4+1] = area->y;
+        dims[i*4+2] = area->width;
+        dims[i*4+3] = area->height;
+    }
+    OBT_PROP_SETA32(obt_root(ob_screen), NET_WORKAREA, CARDINAL,
+                    dims, 4 * screen_num_desktops);
+    g_free(dims);
+}
+
+/*! Finds the area that a client is being maximized into, the same way as
+  client_try_configure().  The struts don't change where other clients go.
+  @return FALSE if the client isn't maximized
+*/
+static gboolean client_strut_area(ObClient *c, Rect *a)
+{
+    Rect desired;
+
+    if (c->fullscreen || !(c->max_horz || c->max_vert)) return FALSE;
+
+    desired = c->area;
+    frame_rect_to_frame(c->frame, &desired);
+    screen_area_get(c->desktop, screen_find_monitor(&desired),
+                    (c->max_horz && c->max_vert ? NULL : &desired), a);
+    return TRUE;
 }
 
 static void get_xinerama_screens(Rect **xin_areas, guint *nxin)
@@ -1418,7 +1594,6 @@ static void get_xinerama_screens(Rect **xin_areas, guint *nxin)
 void screen_update_areas(void)
 {
     guint i;
-    gulong *dims;
     GList *it, *onscreen;
 
     /* collect the clients that are on screen */
@@ -1441,69 +1616,105 @@ void screen_update_areas(void)
     config_margins.right_start = RECT_TOP(monitor_area[screen_num_monitors]);
     config_margins.right_end = RECT_BOTTOM(monitor_area[screen_num_monitors]);
 
-    RESET_STRUT_LIST(struts_left);
-    RESET_STRUT_LIST(struts_top);
-    RESET_STRUT_LIST(struts_right);
-    RESET_STRUT_LIST(struts_bottom);
-
     /* collect the struts */
+    strut_index_reset();
     for (it = client_list; it; it = g_list_next(it)) {
         ObClient *c = it->data;
-        if (c->strut.left)
-            ADD_STRUT_TO_LIST(struts_left, c->desktop, &c->strut);
-        if (c->strut.top)
-            ADD_STRUT_TO_LIST(struts_top, c->desktop, &c->strut);
-        if (c->strut.right)
-            ADD_STRUT_TO_LIST(struts_right, c->desktop, &c->strut);
-        if (c->strut.bottom)
-            ADD_STRUT_TO_LIST(struts_bottom, c->desktop, &c->strut);
-    }
-    if (dock_strut.left)
-        ADD_STRUT_TO_LIST(struts_left, DESKTOP_ALL, &dock_strut);
-    if (dock_strut.top)
-        ADD_STRUT_TO_LIST(struts_top, DESKTOP_ALL, &dock_strut);
-    if (dock_strut.right)
-        ADD_STRUT_TO_LIST(struts_right, DESKTOP_ALL, &dock_strut);
-    if (dock_strut.bottom)
-        ADD_STRUT_TO_LIST(struts_bottom, DESKTOP_ALL, &dock_strut);
-
-    if (config_margins.left)
-        ADD_STRUT_TO_LIST(struts_left, DESKTOP_ALL, &config_margins);
-    if (config_margins.top)
-        ADD_STRUT_TO_LIST(struts_top, DESKTOP_ALL, &config_margins);
-    if (config_margins.right)
-        ADD_STRUT_TO_LIST(struts_right, DESKTOP_ALL, &config_margins);
-    if (config_margins.bottom)
-        ADD_STRUT_TO_LIST(struts_bottom, DESKTOP_ALL, &config_margins);
-
-    VALIDATE_STRUTS(struts_left, left,
-                    monitor_area[screen_num_monitors].width / 2);
-    VALIDATE_STRUTS(struts_right, right,
-                    monitor_area[screen_num_monitors].width / 2);
-    VALIDATE_STRUTS(struts_top, top,
-                    monitor_area[screen_num_monitors].height / 2);
-    VALIDATE_STRUTS(struts_bottom, bottom,
-                    monitor_area[screen_num_monitors].height / 2);
-
-    dims = g_new(gulong, 4 * screen_num_desktops);
-    for (i = 0; i < screen_num_desktops; ++i) {
-        Rect *area = screen_area(i, SCREEN_AREA_ALL_MONITORS, NULL);
-        dims[i*4+0] = area->x;
-        dims[i*4+1] = area->y;
-        dims[i*4+2] = area->width;
-        dims[i*4+3] = area->height;
-        g_slice_free(Rect, area);
+        strut_index_add(&c->strut, strut_slot(&c->strut, c->desktop));
     }
+    strut_index_add(&dock_strut, strut_slot(&dock_strut, DESKTOP_ALL));
+    strut_index_add(&config_margins,
+                    strut_slot(&config_margins, DESKTOP_ALL));
 
-    /* set the legacy workarea hint to the union of all the monitors */
-    OBT_PROP_SETA32(obt_root(ob_screen), NET_WORKAREA, CARDINAL,
-                    dims, 4 * screen_num_desktops);
+    for (i = 0; i <= strut_desktops; ++i)
+        desktop_areas_update(i);
+    screen_set_prop_later(OB_SCREEN_PROP_WORKAREA);
 
     /* the area has changed, adjust all the windows if they need it */
     for (it = onscreen; it; it = g_list_next(it))
         client_reconfigure(it->data, FALSE);
+    g_list_free(onscreen);
+}
 
-    g_free(dims);
+typedef struct {
+    ObClient *client;
+    Rect area;
+} ObScreenMaximized;
+
+void screen_update_strut(StrutPartial *strut, guint desktop)
+{
+    ObScreenStrut *ss;
+    StrutPartial clamped;
+    GSList *maxed, *it;
+    GList *cit;
+    guint i, old, slot;
+    gboolean workarea;
+
+    if (!struts || strut_desktops != screen_num_desktops) {
+        /* the desktops are changing, so everything is going to be found
+           again */
+        screen_update_areas();
+        return;
+    }
+
+    ss = g_hash_table_lookup(strut_map, strut);
+    old = ss ? ss->slot : G_MAXUINT;
+    slot = strut_slot(strut, desktop);
+
+    clamped = *strut;
+    strut_clamp(&clamped);
+    if (old == slot &&
+        (slot == G_MAXUINT || PARTIAL_STRUT_EQUAL(ss->strut, clamped)))
+        return; /* nothing changed that anyone can see */
+
+    /* remember where the maximized windows which could be affected are
+       being fit now, to see if that changes */
+    maxed = NULL;
+    for (cit = client_list; cit; cit = g_list_next(cit)) {
+        ObClient *c = cit->data;
+        Rect a;
+
+        if (!(old == strut_desktops || slot == strut_desktops ||
+              c->desktop == DESKTOP_ALL ||
+              c->desktop == old || c->desktop == slot))
+            continue;
+        if (client_monitor(c) == screen_num_monitors) continue;
+
+        if (client_strut_area(c, &a)) {
+            ObScreenMaximized *m = g_slice_new(ObScreenMaximized);
+            m->client = c;
+            m->area = a;
+            maxed = g_slist_prepend(maxed, m);
+        }
+    }
+
+    strut_index_remove(strut);
+    strut_index_add(strut, slot);
+    area_cache_clear();
+
+    /* find the areas again only for the desktops the strut was or is on */
+    workarea = FALSE;
+    for (i = 0; i < strut_desktops; ++i)
+        if (old == strut_desktops || slot == strut_desktops ||
+            i == old || i == slot)
+        {
+            if (desktop_areas_update(i))
+                workarea = TRUE;
+        }
+    desktop_areas_update(strut_desktops);
+    if (workarea)
+        screen_set_prop_later(OB_SCREEN_PROP_WORKAREA);
+
+    /* only move the windows whose area has changed */
+    for (it = maxed; it; it = g_slist_next(it)) {
+        ObScreenMaximized *m = it->data;
+        Rect a;
+
+        if (client_strut_area(m->client, &a) && !RECT_EQUAL(a, m->area))
+            client_reconfigure(m->client, FALSE);
+        g_slice_free(ObScreenMaximized, m);
+    }
+    g_slist_free(maxed);
 }
 
 #if 0
@@ -1559,19 +1770,153 @@ Rect* screen_area_all_monitors(guint desktop)
     (head == SCREEN_AREA_ALL_MONITORS && us && \
      RECT_BOTTOM(monitor_area[i]) - s->bottom < RECT_BOTTOM(*search))
 
+/*! Moves in the edges of an area for the struts in a list, on monitor @i */
+static void apply_struts(GSList *list, guint head, guint i, gboolean us,
+                         const Rect *search,
+                         gint *l, gint *t, gint *r, gint *b)
+{
+    GSList *it;
+    const Rect *all = &monitor_area[screen_num_monitors];
+
+    for (it = list; it; it = g_slist_next(it)) {
+        const StrutPartial *s = &((ObScreenStrut*)it->data)->strut;
+
+        if (s->left && STRUT_LEFT_IN_SEARCH(s, search) &&
+            !STRUT_LEFT_IGNORE(s, us, search))
+            *l = MAX(*l, RECT_LEFT(*all) + s->left);
+        if (s->top && STRUT_TOP_IN_SEARCH(s, search) &&
+            !STRUT_TOP_IGNORE(s, us, search))
+            *t = MAX(*t, RECT_TOP(*all) + s->top);
+        if (s->right && STRUT_RIGHT_IN_SEARCH(s, search) &&
+            !STRUT_RIGHT_IGNORE(s, us, search))
+            *r = MIN(*r, RECT_RIGHT(*all) - s->right);
+        if (s->bottom && STRUT_BOTTOM_IN_SEARCH(s, search) &&
+            !STRUT_BOTTOM_IGNORE(s, us, search))
+            *b = MIN(*b, RECT_BOTTOM(*all) - s->bottom);
+    }
+}
+
 Rect* screen_area(guint desktop, guint head, Rect *search)
 {
     Rect *a;
-    GSList *it;
-    gint l, r, t, b;
-    guint i, d;
-    gboolean us = search != NULL; /* user provided search */
 
+    a = g_slice_new(Rect);
+    screen_area_get(desktop, head, search, a);
+    return a;
+}
+
+void screen_area_get(guint desktop, guint head, const Rect *search,
+                     Rect *area)
+{
     g_assert(desktop < screen_num_desktops || desktop == DESKTOP_ALL);
     g_assert(head < screen_num_monitors || head == SCREEN_AREA_ONE_MONITOR ||
              head == SCREEN_AREA_ALL_MONITORS);
     g_assert(!(head == SCREEN_AREA_ONE_MONITOR && search == NULL));
 
+    ++area_calls;
+
+    /* the struts haven't caught up with the number of desktops yet */
+    if (strut_desktops != screen_num_desktops)
+        area_calc(desktop, head, search, area);
+    else if (!search) {
+        guint slot = (desktop == DESKTOP_ALL ? strut_desktops : desktop);
+        guint mon = (head == SCREEN_AREA_ALL_MONITORS ?
+                     screen_num_monitors : head);
+        *area = desktop_areas[slot * (screen_num_monitors + 1) + mon];
+        ++area_hits;
+    }
+    else {
+        ObScreenArea k, *c;
+
+        k.desktop = desktop;
+        k.head = head;
+        k.search = *search;
+        if ((c = g_hash_table_lookup(area_cache, &k))) {
+            *area = c->area;
+            ++area_hits;
+        }
+        else {
+            area_calc(desktop, head, search, area);
+
+            if (g_hash_table_size(area_cache) >= AREA_CACHE_SIZE)
+                g_hash_table_remove_all(area_cache);
+            c = g_slice_new(ObScreenArea);
+            *c = k;
+            c->area = *area;
+            g_hash_table_insert(area_cache, c, c);
+        }
+    }
+}
+
+void screen_area_stats(gulong *calls, gulong *hits)
+{
+    *calls = area_calls;
+    *hits = area_hits;
+}
+
+static gboolean flush_props_func(gpointer data)
+{
+    props_idle_id = 0;
+    screen_flush_props();
+    return FALSE; /* don't repeat */
+}
+
+void screen_set_prop_later(ObScreenProp prop)
+{
+    if (props_waiting & prop)
+        ++props_skipped;
+    props_waiting |= prop;
+
+    if (!props_idle_id)
+        props_idle_id = g_idle_add_full(G_PRIORITY_DEFAULT, flush_props_func,
+                                        NULL, NULL);
+}
+
+void screen_flush_props(void)
+{
+    guint waiting = props_waiting;
+
+    props_waiting = 0;
+    if (props_idle_id) {
+        g_source_remove(props_idle_id);
+        props_idle_id = 0;
+    }
+
+    /* the client list goes first, so the stacking list never has windows
+       which aren't in it */
+    if (waiting & OB_SCREEN_PROP_CLIENT_LIST) {
+        client_set_list();
+        ++props_written;
+    }
+    if (waiting & (OB_SCREEN_PROP_CLIENT_LIST |
+                   OB_SCREEN_PROP_CLIENT_LIST_STACKING))
+    {
+        stacking_set_list();
+        ++props_written;
+    }
+    /* when the number of desktops is changing, screen_update_areas() will
+       ask for this again once the areas are found for them */
+    if ((waiting & OB_SCREEN_PROP_WORKAREA) &&
+        strut_desktops == screen_num_desktops)
+    {
+        set_workarea();
+        ++props_written;
+    }
+}
+
+void screen_prop_stats(gulong *written, gulong *skipped)
+{
+    *written = props_written;
+    *skipped = props_skipped;
+}
+
+static void area_calc(guint desktop, guint head, const Rect *search,
+                      Rect *a)
+{
+    gint l, r, t, b;
+    guint i, d;
+    gboolean us = search != NULL; /* user provided search */
+
     /* find any struts for this monitor
        which will be affecting the search area.
     */
@@ -1621,38 +1966,11 @@ Rect* screen_area(guint desktop, guint head, Rect *search)
         for (i = 0; i < screen_num_monitors; ++i) {
             if (head != SCREEN_AREA_ALL_MONITORS && head != i) continue;
 
-            for (it = struts_left; it; it = g_slist_next(it)) {
-                ObScreenStrut *s = it->data;
-                if ((s->desktop == d || s->desktop == DESKTOP_ALL) &&
-                    STRUT_LEFT_IN_SEARCH(s->strut, search) &&
-                    !STRUT_LEFT_IGNORE(s->strut, us, search))
-                    l = MAX(l, RECT_LEFT(monitor_area[screen_num_monitors])
-                               + s->strut->left);
-            }
-            for (it = struts_top; it; it = g_slist_next(it)) {
-                ObScreenStrut *s = it->data;
-                if ((s->desktop == d || s->desktop == DESKTOP_ALL) &&
-                    STRUT_TOP_IN_SEARCH(s->strut, search) &&
-                    !STRUT_TOP_IGNORE(s->strut, us, search))
-                    t = MAX(t, RECT_TOP(monitor_area[screen_num_monitors])
-                               + s->strut->top);
-            }
-            for (it = struts_right; it; it = g_slist_next(it)) {
-                ObScreenStrut *s = it->data;
-                if ((s->desktop == d || s->desktop == DESKTOP_ALL) &&
-                    STRUT_RIGHT_IN_SEARCH(s->strut, search) &&
-                    !STRUT_RIGHT_IGNORE(s->strut, us, search))
-                    r = MIN(r, RECT_RIGHT(monitor_area[screen_num_monitors])
-                               - s->strut->right);
-            }
-            for (it = struts_bottom; it; it = g_slist_next(it)) {
-                ObScreenStrut *s = it->data;
-                if ((s->desktop == d || s->desktop == DESKTOP_ALL) &&
-                    STRUT_BOTTOM_IN_SEARCH(s->strut, search) &&
-                    !STRUT_BOTTOM_IGNORE(s->strut, us, search))
-                    b = MIN(b, RECT_BOTTOM(monitor_area[screen_num_monitors])
-                               - s->strut->bottom);
-            }
+            /* the struts on this desktop, and on all of them */
+            if (d < strut_desktops)
+                apply_struts(struts[d], head, i, us, search, &l, &t, &r, &b);
+            apply_struts(struts[strut_desktops], head, i, us, search,
+                         &l, &t, &r, &b);
 
             /* limit to this monitor */
             if (head == i) {
@@ -1664,12 +1982,10 @@ Rect* screen_area(guint desktop, guint head, Rect *search)
         }
     }
 
-    a = g_slice_new(Rect);
     a->x = l;
     a->y = t;
     a->width = r - l + 1;
     a->height = b - t + 1;
-    return a;
 }
 
 typedef struct {
@@ -112,7 +112,13 @@ void screen_update_desktop_names(void);
   it handles the root colormap. */
 void screen_install_colormap(struct _ObClient *client, gboolean install);
 
+/*! Finds the monitors and all of the struts again, and adjusts every window
+  for them */
 void screen_update_areas(void);
+/*! Updates the areas for a single strut, which has changed or moved to
+  another desktop, or which is going away when it is empty.  Only maximized
+  windows whose area is changed by it are adjusted. */
+void screen_update_strut(StrutPartial *strut, guint desktop);
 
 const Rect* screen_physical_area_all_monitors(void);
 
@@ -151,6 +157,33 @@ const Rect* screen_physical_area_primary(gboolean fixed);
     @return A Rect allocated with g_slice_new()
  */
 Rect* screen_area(guint desktop, guint head, Rect *search);
+/*! The same as screen_area(), but fills in @area instead of allocating a
+  new Rect.  The areas are remembered until the struts or monitors change. */
+void screen_area_get(guint desktop, guint head, const Rect *search,
+                     Rect *area);
+/*! Gives the number of times that an area was asked for, and the number of
+  those which were already known */
+void screen_area_stats(gulong *calls, gulong *hits);
+
+/*! Root window properties which are set from openbox's state when it is
+  idle, so that changing them many times while handling some events only
+  sets them once */
+typedef enum {
+    OB_SCREEN_PROP_CLIENT_LIST          = 1 << 0, /*!< and the stacking */
+    OB_SCREEN_PROP_CLIENT_LIST_STACKING = 1 << 1,
+    OB_SCREEN_PROP_WORKAREA             = 1 << 2
+} ObScreenProp;
+
+/*! Sets a root window property the next time that openbox is idle */
+void screen_set_prop_later(ObScreenProp prop);
+/*! Sets the root window properties which are waiting now.  This is used
+  before setting something that has to come after them, like the active
+  window, which has to be in the client list already. */
+void screen_flush_props(void);
+/*! Gives the number of times that the root window properties were set, and
+  the number of changes which were skipped because the property was already
+  waiting to be set */
+void screen_prop_stats(gulong *written, gulong *skipped);
 
 gboolean screen_physical_area_monitor_contains(guint head, Rect *search);
 
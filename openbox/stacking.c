@@ -30,6 +30,8 @@
 #include "config.h"
 #include "obt/prop.h"
 
+#include <string.h>
+
 GList  *stacking_list = NULL;
 GList  *stacking_list_tail = NULL;
 /*! When true, stacking changes will not be reflected on the screen.  This is
@@ -37,9 +39,193 @@ GList  *stacking_list_tail = NULL;
   raised during focus cycling */
 static gboolean pause_changes = FALSE;
 
+/*! The least space left between windows when some of them are given new
+  places */
+#define PLACE_MIN_GAP ((guint64)1 << 20)
+
+/*! Where a window is in the stacking_list */
+typedef struct {
+    GList *link;
+    /*! The layer it was in when it was put in the list */
+    ObStackingLayer layer;
+    /*! Larger for windows further down the stacking_list, so that windows
+      can be put in order without looking through the list */
+    guint64 place;
+} ObStackingPlace;
+
+/*! The ObStackingPlace for each ObWindow in the stacking_list */
+static GHashTable *places = NULL;
+/*! The highest window in each layer, or NULL when a layer is empty */
+static GList *layer_top[OB_NUM_STACKING_LAYERS];
+/*! The number of clients in the stacking_list */
+static guint n_clients = 0;
+/*! The last list of windows given in NET_CLIENT_LIST_STACKING */
+static Window *client_windows = NULL;
+static guint n_client_windows = 0;
+
+static ObStackingPlace* find_place(ObWindow *win)
+{
+    return places ? g_hash_table_lookup(places, win) : NULL;
+}
+
+/*! Gives the windows around a link new places, spread out evenly, taking
+  in more of them until there is enough space between them.  The link's own
+  place is not used. */
+static void spread_places(GList *link)
+{
+    GList *first = link, *last = link, *it;
+    guint64 lo, hi, gap, p;
+    guint n = 1;
+
+    for (;;) {
+        lo = first->prev ? find_place(first->prev->data)->place : 0;
+        hi = last->next ? find_place(last->next->data)->place : G_MAXUINT64;
+        gap = (hi - lo) / (n + 1);
+        if (gap >= PLACE_MIN_GAP || (!first->prev && !last->next))
+            break;
+        if (first->prev) { first = first->prev; ++n; }
+        if (last->next)  { last = last->next; ++n; }
+    }
+
+    for (p = lo + gap, it = first; ; p += gap, it = g_list_next(it)) {
+        find_place(it->data)->place = p;
+        if (it == last) break;
+    }
+}
+
+/*! Puts a window in the stacking_list above @before, or at the bottom when
+  it is NULL */
+static void list_insert(ObWindow *win, GList *before)
+{
+    ObStackingPlace *pl;
+    GList *link;
+    guint64 a, b;
+
+    if (!places)
+        places = g_hash_table_new_full(g_direct_hash, g_direct_equal,
+                                       NULL, g_free);
+
+    link = g_list_alloc();
+    link->data = win;
+    link->next = before;
+    link->prev = before ? before->prev : stacking_list_tail;
+    if (link->prev) link->prev->next = link;
+    else            stacking_list = link;
+    if (before) before->prev = link;
+    else        stacking_list_tail = link;
+
+    pl = g_new(ObStackingPlace, 1);
+    pl->link = link;
+    pl->layer = window_layer(win);
+    g_hash_table_insert(places, win, pl);
+
+    a = link->prev ? find_place(link->prev->data)->place : 0;
+    b = link->next ? find_place(link->next->data)->place : G_MAXUINT64;
+    if (b - a < 2)
+        spread_places(link);
+    else
+        pl->place = a + (b - a) / 2;
+
+    if (!layer_top[pl->layer] || layer_top[pl->layer] == before)
+        layer_top[pl->layer] = link;
+
+    if (WINDOW_IS_CLIENT(win)) ++n_clients;
+}
+
+/*! Takes a window out of the stacking_list, if it is in it */
+static void list_remove(ObWindow *win)
+{
+    ObStackingPlace *pl;
+    GList *link;
+
+    if (!(pl = find_place(win))) return;
+    link = pl->link;
+
+    if (layer_top[pl->layer] == link)
+        layer_top[pl->layer] =
+            (link->next && find_place(link->next->data)->layer == pl->layer) ?
+            link->next : NULL;
+
+    if (link->prev) link->prev->next = link->next;
+    else            stacking_list = link->next;
+    if (link->next) link->next->prev = link->prev;
+    else            stacking_list_tail = link->prev;
+    g_list_free_1(link);
+
+    g_hash_table_remove(places, win);
+
+    if (WINDOW_IS_CLIENT(win)) --n_clients;
+}
+
+/*! Finds the highest window in a layer at or below @layer, which is where
+  windows go to be on the top of @layer.  Returns NULL if there are none,
+  for the bottom of the stacking_list. */
+static GList* layer_start(ObStackingLayer layer)
+{
+    gint i;
+
+    for (i = layer; i >= 0; --i)
+        if (layer_top[i]) return layer_top[i];
+    return NULL;
+}
+
+static gint place_cmp(gconstpointer a, gconstpointer b)
+{
+    const ObStackingPlace *pa = *(ObStackingPlace*const*)a;
+    const ObStackingPlace *pb = *(ObStackingPlace*const*)b;
+
+    return pa->place < pb->place ? -1 : (pa->place > pb->place ? 1 : 0);
+}
+
+/*! Puts the windows in a list in the order they are in the stacking_list,
+  from the top down.  They must all be in the stacking_list. */
+static GSList* sort_by_place(GSList *wins)
+{
+    GPtrArray *a;
+    GSList *it, *ret;
+    guint i;
+
+    a = g_ptr_array_sized_new(g_slist_length(wins));
+    for (it = wins; it; it = g_slist_next(it)) {
+        ObStackingPlace *pl = find_place(it->data);
+        g_assert(pl);
+        g_ptr_array_add(a, pl);
+    }
+    g_ptr_array_sort(a, place_cmp);
+
+    ret = NULL;
+    for (i = a->len; i > 0; --i)
+        ret = g_slist_prepend(ret,
+                              ((ObStackingPlace*)g_ptr_array_index(a, i-1))
+                              ->link->data);
+    g_ptr_array_free(a, TRUE);
+    g_slist_free(wins);
+    return ret;
+}
+
+/*! Adds the transients of a client in the stacking_list, and theirs, to
+  @family if they are in @layer and not there already */
+static GSList* add_transients(GSList *family, ObClient *self,
+                              ObStackingLayer layer)
+{
+    GSList *it;
+
+    for (it = self->transients; it; it = g_slist_next(it)) {
+        ObClient *c = it->data;
+
+        if (c->layer == layer && !g_slist_find(family, c) &&
+            find_place(CLIENT_AS_WINDOW(c)))
+        {
+            family = g_slist_prepend(family, c);
+        }
+        family = add_transients(family, c, layer);
+    }
+    return family;
+}
+
 void stacking_set_list(void)
 {
-    Window *windows = NULL;
+    Window *windows;
     GList *it;
     guint i = 0;
 
@@ -50,18 +236,27 @@ void stacking_set_list(void)
 
     /* create an array of the window ids (from bottom to top,
        reverse order!) */
-    if (stacking_list) {
-        windows = g_new(Window, g_list_length(stacking_list));
-        for (it = g_list_last(stacking_list); it; it = g_list_previous(it)) {
-            if (WINDOW_IS_CLIENT(it->data))
-                windows[i++] = WINDOW_AS_CLIENT(it->data)->window;
-        }
+    windows = g_new(Window, n_clients);
+    for (it = stacking_list_tail; it; it = g_list_previous(it)) {
+        if (WINDOW_IS_CLIENT(it->data))
+            windows[i++] = WINDOW_AS_CLIENT(it->data)->window;
+    }
+
+    /* don't tell everyone again if raising or lowering didn't change the
+       order of the clients */
+    if (client_windows && i == n_client_windows &&
+        !memcmp(windows, client_windows, i * sizeof(Window)))
+    {
+        g_free(windows);
+        return;
     }
 
     OBT_PROP_SETA32(obt_root(ob_screen), NET_CLIENT_LIST_STACKING, WINDOW,
                     (gulong*)windows, i);
 
-    g_free(windows);
+    g_free(client_windows);
+    client_windows = windows;
+    n_client_windows = i;
 }
 
 static void do_restack(GList *wins, GList *before)
@@ -89,7 +284,7 @@ static void do_restack(GList *wins, GList *before)
     if (before == stacking_list)
         win[0] = screen_support_win;
     else if (!before)
-        win[0] = window_top(g_list_last(stacking_list)->data);
+        win[0] = window_top(stacking_list_tail->data);
     else
         win[0] = window_top(g_list_previous(before)->data);
 
@@ -97,7 +292,7 @@ static void do_restack(GList *wins, GList *before)
         win[i] = window_top(it->data);
         g_assert(win[i] != None); /* better not call stacking shit before
                                      setting your top level window value */
-        stacking_list = g_list_insert_before(stacking_list, before, it->data);
+        list_insert(it->data, before);
     }
 
 #ifdef DEBUG
@@ -113,7 +308,7 @@ static void do_restack(GList *wins, GList *before)
         XRestackWindows(obt_display, win, i);
     g_free(win);
 
-    stacking_set_list();
+    screen_set_prop_later(OB_SCREEN_PROP_CLIENT_LIST_STACKING);
 }
 
 void stacking_temp_raise(ObWindow *window)
@@ -162,63 +357,33 @@ void stacking_restore(void)
     pause_changes = FALSE;
 }
 
-static void do_raise(GList *wins)
+static void do_raise(ObWindow *win)
 {
-    GList *it;
-    GList *layer[OB_NUM_STACKING_LAYERS] = {NULL};
-    gint i;
-
-    for (it = wins; it; it = g_list_next(it)) {
-        ObStackingLayer l;
-
-        l = window_layer(it->data);
-        layer[l] = g_list_append(layer[l], it->data);
-    }
+    GList *wins;
 
-    it = stacking_list;
-    for (i = OB_NUM_STACKING_LAYERS - 1; i >= 0; --i) {
-        if (layer[i]) {
-            for (; it; it = g_list_next(it)) {
-                /* look for the top of the layer */
-                if (window_layer(it->data) <= (ObStackingLayer) i)
-                    break;
-            }
-            do_restack(layer[i], it);
-            g_list_free(layer[i]);
-        }
-    }
+    list_remove(win);
+    wins = g_list_append(NULL, win);
+    /* go on the top of its layer */
+    do_restack(wins, layer_start(window_layer(win)));
+    g_list_free(wins);
 }
 
-static void do_lower(GList *wins)
+static void do_lower(ObWindow *win)
 {
-    GList *it;
-    GList *layer[OB_NUM_STACKING_LAYERS] = {NULL};
-    gint i;
-
-    for (it = wins; it; it = g_list_next(it)) {
-        ObStackingLayer l;
-
-        l = window_layer(it->data);
-        layer[l] = g_list_append(layer[l], it->data);
-    }
+    GList *wins;
+    ObStackingLayer l;
 
-    it = stacking_list;
-    for (i = OB_NUM_STACKING_LAYERS - 1; i >= 0; --i) {
-        if (layer[i]) {
-            for (; it; it = g_list_next(it)) {
-                /* look for the top of the next layer down */
-                if (window_layer(it->data) < (ObStackingLayer) i)
-                    break;
-            }
-            do_restack(layer[i], it);
-            g_list_free(layer[i]);
-        }
-    }
+    list_remove(win);
+    wins = g_list_append(NULL, win);
+    /* go on the top of the next layer down */
+    l = window_layer(win);
+    do_restack(wins, l > 0 ? layer_start(l - 1) : NULL);
+    g_list_free(wins);
 }
 
 static void restack_windows(ObClient *selected, gboolean raise)
 {
-    GList *it, *last, *below, *above, *next;
+    GList *below;
     GList *wins = NULL;
 
     GList *group_helpers = NULL;
@@ -237,48 +402,45 @@ static void restack_windows(ObClient *selected, gboolean raise)
     }
 
     /* remove first so we can't run into ourself */
-    it = g_list_find(stacking_list, selected);
-    g_assert(it);
-    stacking_list = g_list_delete_link(stacking_list, it);
+    g_assert(find_place(CLIENT_AS_WINDOW(selected)));
+    list_remove(CLIENT_AS_WINDOW(selected));
 
-    /* go from the bottom of the stacking list up. don't move any other windows
-       when lowering, we call this for each window independently */
+    /* don't move any other windows when lowering, we call this for each
+       window independently */
     if (raise) {
-        for (it = g_list_last(stacking_list); it; it = next) {
-            next = g_list_previous(it);
-
-            if (WINDOW_IS_CLIENT(it->data)) {
-                ObClient *ch = it->data;
-
-                /* only move windows in the same stacking layer */
-                if (ch->layer == selected->layer &&
-                    /* looking for windows that are transients, and so would
-                       remain above the selected window */
-                    client_search_transient(selected, ch))
-                {
-                    if (client_is_direct_child(selected, ch)) {
-                        if (ch->modal)
-                            modals = g_list_prepend(modals, ch);
-                        else
-                            trans = g_list_prepend(trans, ch);
-                    }
-                    else if (client_helper(ch)) {
-                        if (selected->transient) {
-                            /* helpers do not stay above transient windows */
-                            continue;
-                        }
-                        group_helpers = g_list_prepend(group_helpers, ch);
-                    }
-                    else {
-                        if (ch->modal)
-                            group_modals = g_list_prepend(group_modals, ch);
-                        else
-                            group_trans = g_list_prepend(group_trans, ch);
-                    }
-                    stacking_list = g_list_delete_link(stacking_list, it);
+        GSList *family, *it;
+
+        /* looking for windows that are transients, and so would remain above
+           the selected window, going from the top of the stacking list
+           down */
+        family = sort_by_place(add_transients(NULL, selected,
+                                              selected->layer));
+
+        for (it = family; it; it = g_slist_next(it)) {
+            ObClient *ch = it->data;
+
+            if (client_is_direct_child(selected, ch)) {
+                if (ch->modal)
+                    modals = g_list_append(modals, ch);
+                else
+                    trans = g_list_append(trans, ch);
+            }
+            else if (client_helper(ch)) {
+                if (selected->transient) {
+                    /* helpers do not stay above transient windows */
+                    continue;
                 }
+                group_helpers = g_list_append(group_helpers, ch);
             }
+            else {
+                if (ch->modal)
+                    group_modals = g_list_append(group_modals, ch);
+                else
+                    group_trans = g_list_append(group_trans, ch);
+            }
+            list_remove(CLIENT_AS_WINDOW(ch));
         }
+        g_slist_free(family);
     }
 
     /* put modals above other direct transients */
@@ -301,95 +463,32 @@ static void restack_windows(ObClient *selected, gboolean raise)
         group_trans = NULL;
     }
 
-    /* find where to put the selected window, start from bottom of list,
-       this is the window below everything we are re-adding to the list */
-    last = NULL;
-    for (it = g_list_last(stacking_list); it; it = g_list_previous(it))
-    {
-        if (window_layer(it->data) < selected->layer) {
-            last = it;
-            continue;
-        }
-        /* if lowering, stop at the beginning of the layer */
-        if (!raise)
-            break;
-        /* if raising, stop at the end of the layer */
-        if (window_layer(it->data) > selected->layer)
-            break;
-
-        last = it;
-    }
-
-    /* save this position in the stacking list */
-    below = last;
-
-    /* find where to put the group transients, start from the top of list */
-    for (it = stacking_list; it; it = g_list_next(it)) {
-        /* skip past higher layers */
-        if (window_layer(it->data) > selected->layer)
-            continue;
-        /* if we reach the end of the layer (how?) then don't go further */
-        if (window_layer(it->data) < selected->layer)
-            break;
-        /* stop when we reach the first window in the group */
-        if (WINDOW_IS_CLIENT(it->data)) {
-            ObClient *c = it->data;
-            if (c->group == selected->group)
-                break;
-        }
-        /* if we don't hit any other group members, stop here because this
-           is where we are putting the selected window (and its children) */
-        if (it == below)
-            break;
-    }
-
-    /* save this position, this is the top of the group of windows between the
-       group transient ones we're restacking and the others up above that we're
-       restacking
-
-       we actually want to save 1 position _above_ that, for for loops to work
-       nicely, so move back one position in the list while saving it
-    */
-    above = it ? g_list_previous(it) : g_list_last(stacking_list);
-
-    /* put the windows inside the gap to the other windows we're stacking
-       into the restacking list, go from the bottom up so that we can use
-       g_list_prepend */
-    if (below) it = g_list_previous(below);
-    else       it = g_list_last(stacking_list);
-    for (; it != above; it = next) {
-        next = g_list_previous(it);
-        wins = g_list_prepend(wins, it->data);
-        stacking_list = g_list_delete_link(stacking_list, it);
-    }
-
     /* group transients go above the rest of the stuff acquired to now */
     wins = g_list_concat(group_trans, wins);
     /* group modals go on the very top */
     wins = g_list_concat(group_modals, wins);
 
+    /* if raising, go on the top of the layer, and if lowering, go on the top
+       of the next layer down */
+    if (raise)
+        below = layer_start(selected->layer);
+    else
+        below = selected->layer > 0 ? layer_start(selected->layer - 1) : NULL;
+
     do_restack(wins, below);
     g_list_free(wins);
 
     /* lower our parents after us, so they go below us */
     if (!raise && selected->parents) {
-        GSList *parents_copy, *sit;
-        GSList *reorder = NULL;
+        GSList *reorder, *sit;
 
-        parents_copy = g_slist_copy(selected->parents);
-
-        /* go thru stacking list backwards so we can use g_slist_prepend */
-        for (it = g_list_last(stacking_list); it && parents_copy;
-             it = g_list_previous(it))
-            if ((sit = g_slist_find(parents_copy, it->data))) {
-                reorder = g_slist_prepend(reorder, sit->data);
-                parents_copy = g_slist_delete_link(parents_copy, sit);
-            }
-        g_assert(parents_copy == NULL);
+        /* from the top of the stacking list down */
+        reorder = sort_by_place(g_slist_copy(selected->parents));
 
         /* call restack for each of these to lower them */
         for (sit = reorder; sit; sit = g_slist_next(sit))
             restack_windows(sit->data, raise);
+        g_slist_free(reorder);
     }
 }
 
@@ -399,14 +498,8 @@ void stacking_raise(ObWindow *window)
         ObClient *selected;
         selected = WINDOW_AS_CLIENT(window);
         restack_windows(selected, TRUE);
-    } else {
-        GList *wins;
-        wins = g_list_append(NULL, window);
-        stacking_list = g_list_remove(stacking_list, window);
-        do_raise(wins);
-        g_list_free(wins);
-    }
-    stacking_list_tail = g_list_last(stacking_list);
+    } else
+        do_raise(window);
 }
 
 void stacking_lower(ObWindow *window)
@@ -415,42 +508,44 @@ void stacking_lower(ObWindow *window)
         ObClient *selected;
         selected = WINDOW_AS_CLIENT(window);
         restack_windows(selected, FALSE);
-    } else {
-        GList *wins;
-        wins = g_list_append(NULL, window);
-        stacking_list = g_list_remove(stacking_list, window);
-        do_lower(wins);
-        g_list_free(wins);
-    }
-    stacking_list_tail = g_list_last(stacking_list);
+    } else
+        do_lower(window);
 }
 
 void stacking_below(ObWindow *window, ObWindow *below)
 {
-    GList *wins, *before;
+    GList *wins;
+    ObStackingPlace *pl;
 
     if (window_layer(window) != window_layer(below))
         return;
 
     wins = g_list_append(NULL, window);
-    stacking_list = g_list_remove(stacking_list, window);
-    before = g_list_next(g_list_find(stacking_list, below));
-    do_restack(wins, before);
+    list_remove(window);
+    pl = find_place(below);
+    do_restack(wins, pl ? g_list_next(pl->link) : NULL);
     g_list_free(wins);
-    stacking_list_tail = g_list_last(stacking_list);
 }
 
 void stacking_add(ObWindow *win)
 {
+    ObStackingLayer l;
+
     g_assert(screen_support_win != None); /* make sure I dont break this in the
                                              future */
     /* don't add windows that are being unmanaged ! */
     if (WINDOW_IS_CLIENT(win)) g_assert(WINDOW_AS_CLIENT(win)->managed);
 
-    stacking_list = g_list_append(stacking_list, win);
+    /* put it on the bottom of its layer, and then raise it */
+    l = window_layer(win);
+    list_insert(win, l > 0 ? layer_start(l - 1) : NULL);
 
     stacking_raise(win);
-    /* stacking_list_tail set by stacking_raise() */
+}
+
+void stacking_remove(ObWindow *win)
+{
+    list_remove(win);
 }
 
 static GList *find_highest_relative(ObClient *client)
@@ -458,38 +553,39 @@ static GList *find_highest_relative(ObClient *client)
     GList *ret = NULL;
 
     if (client->parents) {
-        GList *it;
-        GSList *top;
+        GSList *top, *family, *sit;
+        ObStackingPlace *pl, *best = NULL;
 
         /* get all top level relatives of this client */
         top = client_search_all_top_parents_layer(client);
 
-        /* go from the top of the stacking order down */
-        for (it = stacking_list; !ret && it; it = g_list_next(it)) {
-            if (WINDOW_IS_CLIENT(it->data)) {
-                ObClient *c = it->data;
-                /* only look at windows in the same layer and that are
-                   visible */
-                if (c->layer == client->layer &&
-                    !c->iconic &&
-                    (c->desktop == client->desktop ||
-                     c->desktop == DESKTOP_ALL ||
-                     client->desktop == DESKTOP_ALL))
-                {
-                    GSList *sit;
-
-                    /* go through each top level parent and see it this window
-                       is related to them */
-                    for (sit = top; !ret && sit; sit = g_slist_next(sit)) {
-                        ObClient *topc = sit->data;
+        /* and everything that is related to them */
+        family = NULL;
+        for (sit = top; sit; sit = g_slist_next(sit)) {
+            if (!g_slist_find(family, sit->data) &&
+                ((ObClient*)sit->data)->layer == client->layer &&
+                find_place(CLIENT_AS_WINDOW(sit->data)))
+                family = g_slist_prepend(family, sit->data);
+            family = add_transients(family, sit->data, client->layer);
+        }
 
-                        /* are they related ? */
-                        if (topc == c || client_search_transient(topc, c))
-                            ret = it;
-                    }
-                }
+        /* find the highest one in the stacking order */
+        for (sit = family; sit; sit = g_slist_next(sit)) {
+            ObClient *c = sit->data;
+            /* only look at windows that are visible */
+            if (!c->iconic &&
+                (c->desktop == client->desktop ||
+                 c->desktop == DESKTOP_ALL ||
+                 client->desktop == DESKTOP_ALL))
+            {
+                pl = find_place(CLIENT_AS_WINDOW(c));
+                if (!best || pl->place < best->place)
+                    best = pl;
             }
         }
+        g_slist_free(family);
+
+        if (best) ret = best->link;
     }
     return ret;
 }
@@ -520,11 +616,11 @@ void stacking_add_nonintrusive(ObWindow *win)
         if (focus_client && client != focus_client &&
             focus_client->layer == client->layer)
         {
-            it_below = g_list_find(stacking_list, focus_client);
+            ObStackingPlace *pl = find_place(CLIENT_AS_WINDOW(focus_client));
             /* this can give NULL, but it means the focused window is on the
                bottom of the stacking order, so go to the bottom in that case,
                below it */
-            it_below = g_list_next(it_below);
+            it_below = pl ? g_list_next(pl->link) : NULL;
         }
         else {
             /* There is no window to put this directly above, so put it at the
@@ -555,7 +651,7 @@ void stacking_add_nonintrusive(ObWindow *win)
         /* stop when the window is not in a lower layer than the
            window it is going under (it_above) */
         it_above = it_below ?
-            g_list_previous(it_below) : g_list_last(stacking_list);
+            g_list_previous(it_below) : stacking_list_tail;
         if (client->layer <= window_layer(it_above->data))
             break;
     }
@@ -563,7 +659,6 @@ void stacking_add_nonintrusive(ObWindow *win)
     wins = g_list_append(NULL, win);
     do_restack(wins, it_below);
     g_list_free(wins);
-    stacking_list_tail = g_list_last(stacking_list);
 }
 
 /*! Returns TRUE if client is occluded by the sibling. If sibling is NULL it
@@ -574,6 +669,7 @@ static gboolean stacking_occluded(ObClient *client, ObWindow *sibling_win)
     GList *it;
     gboolean occluded = FALSE;
     ObClient *sibling = NULL;
+    ObStackingPlace *pl;
 
     if (sibling_win && WINDOW_IS_CLIENT(sibling_win))
         sibling = WINDOW_AS_CLIENT(sibling_win);
@@ -582,7 +678,8 @@ static gboolean stacking_occluded(ObClient *client, ObWindow *sibling_win)
     if (sibling && client->layer != sibling->layer)
         return FALSE;
 
-    for (it = g_list_previous(g_list_find(stacking_list, client)); it;
+    pl = find_place(CLIENT_AS_WINDOW(client));
+    for (it = pl ? g_list_previous(pl->link) : NULL; it;
          it = g_list_previous(it))
         if (WINDOW_IS_CLIENT(it->data)) {
             ObClient *c = it->data;
@@ -634,6 +731,7 @@ static gboolean stacking_occludes(ObClient *client, ObWindow *sibling_win)
     GList *it;
     gboolean occludes = FALSE;
     ObClient *sibling = NULL;
+    ObStackingPlace *pl;
 
     if (sibling_win && WINDOW_IS_CLIENT(sibling_win))
         sibling = WINDOW_AS_CLIENT(sibling_win);
@@ -642,7 +740,8 @@ static gboolean stacking_occludes(ObClient *client, ObWindow *sibling_win)
     if (sibling && client->layer != sibling->layer)
         return FALSE;
 
-    for (it = g_list_next(g_list_find(stacking_list, client));
+    pl = find_place(CLIENT_AS_WINDOW(client));
+    for (it = pl ? g_list_next(pl->link) : NULL;
          it; it = g_list_next(it))
         if (WINDOW_IS_CLIENT(it->data)) {
             ObClient *c = it->data;
@@ -44,12 +44,14 @@ extern GList *stacking_list;
 extern GList *stacking_list_tail;
 
 /*! Sets the window stacking list on the root window from the
-  stacking_list */
+  stacking_list now, if the order of the clients in it has changed.  Use
+  screen_set_prop_later() to set it when openbox is idle. */
 void stacking_set_list(void);
 
 void stacking_add(struct _ObWindow *win);
 void stacking_add_nonintrusive(struct _ObWindow *win);
-#define stacking_remove(win) stacking_list = g_list_remove(stacking_list, win);
+/*! Takes a window out of the stacking order, if it is in it */
+void stacking_remove(struct _ObWindow *win);
 
 /*! Raises a window above all others in its stacking layer */
 void stacking_raise(struct _ObWindow *window);
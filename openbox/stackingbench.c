@@ -0,0 +1,382 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   stackingbench.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Maps lots of clients, in groups with transients and helpers, and raises,
+   lowers and changes the layers of random ones of them.  After each change
+   it checks that the stacking_list is in order and that a raised window's
+   transients are still above it.  Then it measures how long it takes to
+   raise windows, and how many windows were given to XRestackWindows() and
+   how many times the stacking order was set on the root window.
+
+   The order the windows end up in is printed as a number, which comes out
+   the same for the same arguments as long as the stacking rules haven't
+   changed. */
+
+#include "stacking.h"
+#include "client.h"
+#include "frame.h"
+#include "dock.h"
+#include "window.h"
+#include "openbox.h"
+#include "event.h"
+#include "screen.h"
+#include "config.h"
+#include "debug.h"
+#include "obt/display.h"
+#include "obt/prop.h"
+
+#include <glib.h>
+#include <stdio.h>
+#include <stdlib.h>
+
+/* the parts of openbox that stacking.c uses */
+
+Display *obt_display;
+gint ob_screen;
+Window screen_support_win = 1;
+ObClient *focus_client;
+ObStackingLayer config_dock_layer = OB_STACKING_LAYER_ABOVE;
+
+static gulong restacked = 0;
+static gulong published = 0;
+static gboolean list_waiting = FALSE;
+
+ObState ob_state(void) { return OB_STATE_RUNNING; }
+gulong event_start_ignore_all_enters(void) { return 0; }
+void event_end_ignore_all_enters(gulong start) {}
+void ob_debug(const gchar *a, ...) {}
+Atom obt_prop_atom(ObtPropAtom a) { return a; }
+
+void obt_prop_set_array32(Window win, Atom prop, Atom type, gulong *val,
+                          guint num)
+{
+    ++published;
+}
+
+void screen_set_prop_later(ObScreenProp prop)
+{
+    list_waiting = TRUE;
+}
+
+/*! Sets the stacking list the way the event loop does when it is idle,
+  which is done after each window is raised, as if each was for an event */
+static void idle(void)
+{
+    if (list_waiting) {
+        list_waiting = FALSE;
+        stacking_set_list();
+    }
+}
+
+int XRestackWindows(Display *d, Window *wins, int n)
+{
+    restacked += n;
+    return 1;
+}
+
+Window window_top(ObWindow *self)
+{
+    switch (self->type) {
+    case OB_WINDOW_CLASS_DOCK:
+        return WINDOW_AS_DOCK(self)->frame;
+    case OB_WINDOW_CLASS_CLIENT:
+        return WINDOW_AS_CLIENT(self)->frame->window;
+    case OB_WINDOW_CLASS_INTERNAL:
+        return WINDOW_AS_INTERNAL(self)->window;
+    default:
+        g_assert_not_reached();
+    }
+    return None;
+}
+
+ObStackingLayer window_layer(ObWindow *self)
+{
+    switch (self->type) {
+    case OB_WINDOW_CLASS_DOCK:
+        return config_dock_layer;
+    case OB_WINDOW_CLASS_CLIENT:
+        return ((ObClient*)self)->layer;
+    case OB_WINDOW_CLASS_INTERNAL:
+        return OB_STACKING_LAYER_INTERNAL;
+    default:
+        g_assert_not_reached();
+    }
+    return OB_STACKING_LAYER_INVALID;
+}
+
+gboolean client_helper(ObClient *self)
+{
+    return (self->type == OB_CLIENT_TYPE_UTILITY ||
+            self->type == OB_CLIENT_TYPE_MENU ||
+            self->type == OB_CLIENT_TYPE_TOOLBAR);
+}
+
+ObClient *client_direct_parent(ObClient *self)
+{
+    if (!self->parents) return NULL;
+    if (self->transient_for_group) return NULL;
+    return self->parents->data;
+}
+
+gboolean client_is_direct_child(ObClient *parent, ObClient *child)
+{
+    while (child != parent && (child = client_direct_parent(child)));
+    return child == parent;
+}
+
+GSList *client_search_all_top_parents_layer(ObClient *self)
+{
+    ObClient *p;
+    ObStackingLayer layer = self->layer;
+
+    while ((p = client_direct_parent(self)) && p->layer == layer)
+        self = p;
+
+    if (!self->parents)
+        return g_slist_prepend(NULL, self);
+    return g_slist_copy(self->parents);
+}
+
+ObClient *client_search_transient(ObClient *self, ObClient *search)
+{
+    GSList *sit;
+
+    for (sit = self->transients; sit; sit = g_slist_next(sit)) {
+        if (sit->data == search)
+            return search;
+        if (client_search_transient(sit->data, search))
+            return search;
+    }
+    return NULL;
+}
+
+/* the windows */
+
+static ObClient *clients;
+static gint n_clients;
+
+static void new_client(ObClient *c, ObClient *parent, ObClient *leader,
+                       gboolean group, ObClientType type)
+{
+    static Window xwin = 100;
+
+    c->obwin.type = OB_WINDOW_CLASS_CLIENT;
+    c->frame = g_slice_new0(ObFrame);
+    c->frame->window = ++xwin;
+    c->window = ++xwin;
+    c->managed = TRUE;
+    c->desktop = 0;
+    c->type = type;
+    c->layer = OB_STACKING_LAYER_NORMAL;
+    c->group = (struct _ObGroup*)leader;
+
+    if (group) {
+        ObClient *m;
+
+        /* transient for each of the group's windows before it which are not
+           group transients */
+        c->transient = c->transient_for_group = TRUE;
+        for (m = leader; m < c; ++m)
+            if (!m->transient_for_group) {
+                c->parents = g_slist_append(c->parents, m);
+                m->transients = g_slist_append(m->transients, c);
+            }
+    }
+    else if (parent) {
+        c->transient = TRUE;
+        c->parents = g_slist_append(NULL, parent);
+        parent->transients = g_slist_append(parent->transients, c);
+    }
+
+    stacking_add_nonintrusive(CLIENT_AS_WINDOW(c));
+}
+
+/*! Makes groups of a main window with some transients, some of which are
+  modal, and maybe a helper window and a group transient */
+static void new_clients(gint n)
+{
+    gint i = 0;
+
+    clients = g_new0(ObClient, n);
+    while (i < n) {
+        ObClient *leader = &clients[i];
+        gint size = g_random_int_range(1, 9);
+        gint j;
+
+        size = MIN(size, n - i);
+
+        new_client(&clients[i++], NULL, leader, FALSE,
+                   OB_CLIENT_TYPE_NORMAL);
+        for (j = 1; j < size; ++j, ++i) {
+            gint r = g_random_int_range(0, 10);
+
+            if (r < 5) {
+                ObClient *parent = &clients[i - g_random_int_range(1, j+1)];
+
+                new_client(&clients[i], parent, leader, FALSE,
+                           OB_CLIENT_TYPE_DIALOG);
+                clients[i].modal = r == 0;
+            }
+            else if (r < 7)
+                new_client(&clients[i], NULL, leader, TRUE,
+                           OB_CLIENT_TYPE_UTILITY);
+            else if (r < 9) {
+                new_client(&clients[i], NULL, leader, TRUE,
+                           OB_CLIENT_TYPE_DIALOG);
+                clients[i].modal = r == 8;
+            }
+            else
+                new_client(&clients[i], NULL, leader, FALSE,
+                           OB_CLIENT_TYPE_NORMAL);
+        }
+    }
+    n_clients = n;
+}
+
+/*! Moves a client into another layer, the way client_calc_layer() does */
+static void set_layer(ObClient *c, ObStackingLayer layer)
+{
+    if (c->layer != layer) {
+        c->layer = layer;
+        stacking_remove(CLIENT_AS_WINDOW(c));
+        stacking_add_nonintrusive(CLIENT_AS_WINDOW(c));
+    }
+}
+
+static gint check_list(void)
+{
+    GList *it;
+    guint n = 0;
+
+    for (it = stacking_list; it; it = g_list_next(it)) {
+        ++n;
+        if (it->next && it->next->prev != it)
+            return printf("the stacking_list is broken\n");
+        if (it->next &&
+            window_layer(it->data) < window_layer(it->next->data))
+            return printf("the stacking_list's layers are out of order\n");
+        if (!it->next && it != stacking_list_tail)
+            return printf("stacking_list_tail is not the end of the list\n");
+    }
+    if (!stacking_list && stacking_list_tail)
+        return printf("stacking_list_tail is not the end of the list\n");
+    if (n != n_clients + 2)
+        return printf("%u windows in the stacking_list instead of %d\n",
+                      n, n_clients + 2);
+    return 0;
+}
+
+/*! Checks that the windows which stay above a raised window are above it */
+static gint check_raised(ObClient *c)
+{
+    GList *it;
+    GSList *sit;
+
+    while (c->modal && client_direct_parent(c))
+        c = client_direct_parent(c);
+
+    for (sit = c->transients; sit; sit = g_slist_next(sit)) {
+        ObClient *t = sit->data;
+
+        if (t->layer != c->layer || (c->transient && client_helper(t)))
+            continue;
+        for (it = stacking_list; it->data != c; it = g_list_next(it))
+            if (it->data == t) break;
+        if (it->data == c)
+            return printf("a transient is below the window raised\n");
+    }
+    return 0;
+}
+
+static guint order_hash(void)
+{
+    GList *it;
+    guint h = 5381;
+
+    for (it = stacking_list; it; it = g_list_next(it))
+        h = h * 33 + (guint)window_top(it->data);
+    return h;
+}
+
+gint main(gint argc, gchar **argv)
+{
+    static Screen screen;
+    ObDock dock;
+    ObInternalWindow popup;
+    GTimer *timer;
+    gdouble t;
+    gint i, n, n_raises, wrong = 0;
+
+    n = argc > 1 ? atoi(argv[1]) : 500;
+    n_raises = argc > 2 ? atoi(argv[2]) : 10000;
+    g_random_set_seed(1);
+
+    /* obt_root() finds the root window in the Display */
+    obt_display = g_malloc0(sizeof(*(_XPrivDisplay)NULL));
+    ((_XPrivDisplay)obt_display)->screens = &screen;
+
+    dock.obwin.type = OB_WINDOW_CLASS_DOCK;
+    dock.frame = 2;
+    stacking_add(DOCK_AS_WINDOW(&dock));
+    popup.type = OB_WINDOW_CLASS_INTERNAL;
+    popup.window = 3;
+    stacking_add(INTERNAL_AS_WINDOW(&popup));
+
+    new_clients(n);
+    wrong += check_list();
+
+    for (i = 0; i < n * 4 && !wrong; ++i) {
+        ObClient *c = &clients[g_random_int_range(0, n)];
+        gint r = g_random_int_range(0, 100);
+
+        if (r < 60) {
+            stacking_raise(CLIENT_AS_WINDOW(c));
+            wrong += check_raised(c);
+        }
+        else if (r < 80)
+            stacking_lower(CLIENT_AS_WINDOW(c));
+        else if (r < 95)
+            set_layer(c, g_random_int_range(0, 4) ?
+                      OB_STACKING_LAYER_NORMAL :
+                      (g_random_boolean() ? OB_STACKING_LAYER_ABOVE :
+                       OB_STACKING_LAYER_BELOW));
+        else if (r < 98)
+            stacking_raise(DOCK_AS_WINDOW(&dock));
+        else
+            stacking_lower(DOCK_AS_WINDOW(&dock));
+        idle();
+        wrong += check_list();
+    }
+    printf("%d clients, %d changes: the order is %08x\n",
+           n, i, order_hash());
+
+    restacked = published = 0;
+    timer = g_timer_new();
+    for (i = 0; i < n_raises; ++i) {
+        stacking_raise(CLIENT_AS_WINDOW(&clients[g_random_int_range(0, n)]));
+        idle();
+    }
+    t = g_timer_elapsed(timer, NULL);
+    g_timer_destroy(timer);
+
+    printf("%d raises: %.2f us each, %lu windows restacked, "
+           "%lu stacking lists set\n",
+           n_raises, t * 1000000 / n_raises, restacked, published);
+
+    return wrong ? 1 : 0;
+}
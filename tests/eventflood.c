@@ -0,0 +1,101 @@
+/* -*- indent-tabs-mode: nil; tab-width: 4; c-basic-offset: 4; -*-
+
+   eventflood.c for the Openbox window manager
+   Copyright (c) 2026        agent
+
+   This program is free software; you can redistribute it and/or modify
+   it under the terms of the GNU General Public License as published by
+   the Free Software Foundation; either version 2 of the License, or
+   (at your option) any later version.
+
+   This program is distributed in the hope that it will be useful,
+   but WITHOUT ANY WARRANTY; without even the implied warranty of
+   MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+   GNU General Public License for more details.
+
+   See the COPYING file for a copy of the GNU General Public License.
+*/
+
+/* Sends bursts of property changes and configure requests to the window
+   manager, and times how long it takes to work through each burst.  The
+   window is resized wider during a burst, and the last request in a burst
+   puts it back to its size, so the burst is done when the ConfigureNotify
+   for that size comes back.  obt/xqueuebench feeds the same kinds of events
+   through the queue without an X server. */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <X11/Xlib.h>
+#include <X11/Xutil.h>
+#include <X11/Xatom.h>
+
+int main (int argc, char **argv) {
+  Display   *display;
+  Window     win;
+  XEvent     report;
+  Atom       aname, atime, autf8;
+  int        x=10,y=10,h=100,w=400;
+  int        bursts, burst, i, n;
+  Time       num;
+  char       title[64];
+  struct timeval start, end;
+
+  n = argc > 1 ? atoi(argv[1]) : 5000;
+  bursts = argc > 2 ? atoi(argv[2]) : 10;
+
+  display = XOpenDisplay(NULL);
+
+  if (display == NULL) {
+    fprintf(stderr, "couldn't connect to X server :0\n");
+    return 0;
+  }
+
+  aname = XInternAtom(display, "_NET_WM_NAME", False);
+  atime = XInternAtom(display, "_NET_WM_USER_TIME", False);
+  autf8 = XInternAtom(display, "UTF8_STRING", False);
+
+  win = XCreateWindow(display, RootWindow(display, 0),
+                      x, y, w, h, 10, CopyFromParent, CopyFromParent,
+                      CopyFromParent, 0, 0);
+
+  XSetWindowBackground(display,win,WhitePixel(display,0));
+  XSelectInput(display, win, StructureNotifyMask);
+
+  XMapWindow(display, win);
+  XFlush(display);
+
+  sleep(1);
+
+  for (burst = 0; burst < bursts; ++burst) {
+    gettimeofday(&start, NULL);
+
+    for (i = 0; i < n; ++i) {
+      snprintf(title, sizeof(title), "flood %d/%d", burst, i);
+      XChangeProperty(display, win, aname, autf8, 8, PropModeReplace,
+                      (unsigned char*)title, strlen(title));
+      num = i + 1;
+      XChangeProperty(display, win, atime, XA_CARDINAL, 32,
+                      PropModeReplace, (unsigned char*)&num, 1);
+      if (i % 8 == 0)
+        XResizeWindow(display, win, w + 1 + (i % 16), h);
+    }
+    XResizeWindow(display, win, w, h);
+    XFlush(display);
+
+    while (1) {
+      XNextEvent(display, &report);
+      if (report.type == ConfigureNotify && report.xconfigure.width == w)
+        break;
+    }
+
+    gettimeofday(&end, NULL);
+    printf("burst %d: %d events in %ld ms\n", burst, n * 2 + (n + 7) / 8 + 1,
+           (end.tv_sec - start.tv_sec) * 1000 +
+           (end.tv_usec - start.tv_usec) / 1000);
+  }
+
+  return 0;
+}